@@ -0,0 +1,8 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/host
+# Build directory: /root/repo/_wall_build
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+subdirs("dex")
+subdirs("system")
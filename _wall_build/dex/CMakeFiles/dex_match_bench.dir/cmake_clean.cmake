@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/dex_match_bench.dir/dex_match_bench.cpp.o"
+  "CMakeFiles/dex_match_bench.dir/dex_match_bench.cpp.o.d"
+  "dex_match_bench"
+  "dex_match_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/dex_match_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
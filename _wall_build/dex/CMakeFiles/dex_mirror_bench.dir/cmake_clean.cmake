@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/dex_mirror_bench.dir/dex_mirror_bench.cpp.o"
+  "CMakeFiles/dex_mirror_bench.dir/dex_mirror_bench.cpp.o.d"
+  "dex_mirror_bench"
+  "dex_mirror_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/dex_mirror_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/dex_replay.dir/dex_replay.cpp.o"
+  "CMakeFiles/dex_replay.dir/dex_replay.cpp.o.d"
+  "dex_replay"
+  "dex_replay.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/dex_replay.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
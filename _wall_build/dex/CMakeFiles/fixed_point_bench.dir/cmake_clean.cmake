@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/fixed_point_bench.dir/fixed_point_bench.cpp.o"
+  "CMakeFiles/fixed_point_bench.dir/fixed_point_bench.cpp.o.d"
+  "fixed_point_bench"
+  "fixed_point_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/fixed_point_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
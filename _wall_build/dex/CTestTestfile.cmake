@@ -0,0 +1,16 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/host/dex
+# Build directory: /root/repo/_wall_build/dex
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(dex_match_bench_smoke "/root/repo/_wall_build/dex/dex_match_bench" "--depth" "100" "--takers" "500")
+set_tests_properties(dex_match_bench_smoke PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/host/dex/CMakeLists.txt;4;add_test;/root/repo/host/dex/CMakeLists.txt;0;")
+add_test(dex_replay_smoke "/root/repo/_wall_build/dex/dex_replay" "--generate" "20000" "--check")
+set_tests_properties(dex_replay_smoke PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/host/dex/CMakeLists.txt;18;add_test;/root/repo/host/dex/CMakeLists.txt;0;")
+add_test(dex_fixed_point_test "/root/repo/_wall_build/dex/fixed_point_test")
+set_tests_properties(dex_fixed_point_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/host/dex/CMakeLists.txt;33;add_test;/root/repo/host/dex/CMakeLists.txt;0;")
+add_test(dex_fixed_point_bench_smoke "/root/repo/_wall_build/dex/fixed_point_bench" "--fills" "10000" "--rounds" "1")
+set_tests_properties(dex_fixed_point_bench_smoke PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/host/dex/CMakeLists.txt;37;add_test;/root/repo/host/dex/CMakeLists.txt;0;")
+add_test(dex_mirror_bench_smoke "/root/repo/_wall_build/dex/dex_mirror_bench" "--depth" "1000" "--events" "20000")
+set_tests_properties(dex_mirror_bench_smoke PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/host/dex/CMakeLists.txt;46;add_test;/root/repo/host/dex/CMakeLists.txt;0;")
@@ -0,0 +1,6 @@
+#pragma once
+
+namespace dex {
+   static const std::string __version = "host";
+   const std::string& version() { return __version; }
+}
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bancor_bench.dir/bancor_bench.cpp.o"
+  "CMakeFiles/bancor_bench.dir/bancor_bench.cpp.o.d"
+  "bancor_bench"
+  "bancor_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bancor_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bancor_test.dir/bancor_test.cpp.o"
+  "CMakeFiles/bancor_test.dir/bancor_test.cpp.o.d"
+  "bancor_test"
+  "bancor_test.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bancor_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/system_exchange_state.dir/root/repo/contracts/eosio.system/src/exchange_state.cpp.o"
+  "CMakeFiles/system_exchange_state.dir/root/repo/contracts/eosio.system/src/exchange_state.cpp.o.d"
+  "libsystem_exchange_state.a"
+  "libsystem_exchange_state.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/system_exchange_state.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,3 @@
+file(REMOVE_RECURSE
+  "libsystem_exchange_state.a"
+)
@@ -0,0 +1,10 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/host/system
+# Build directory: /root/repo/_wall_build/system
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(system_bancor_test "/root/repo/_wall_build/system/bancor_test")
+set_tests_properties(system_bancor_test PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/host/system/CMakeLists.txt;10;add_test;/root/repo/host/system/CMakeLists.txt;0;")
+add_test(system_bancor_bench_smoke "/root/repo/_wall_build/system/bancor_bench" "--ops" "10000" "--rounds" "1")
+set_tests_properties(system_bancor_bench_smoke PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/host/system/CMakeLists.txt;14;add_test;/root/repo/host/system/CMakeLists.txt;0;")
@@ -5,6 +5,7 @@
 #include "dex_const.hpp"
 #include "dex_states.hpp"
 #include "dex_match.hpp"
+#include "dex_amm.hpp"
 
 using namespace std;
 using namespace eosio;
@@ -16,12 +17,12 @@ public:
 public:
     dex_contract(name receiver, name code, datastream<const char *> ds)
         : contract(receiver, code, ds), _conf_tbl(get_self(), get_self().value),
-          _global(dex::global_state::make_global(get_self())) {
-        _config = _conf_tbl.exists() ? _conf_tbl.get() : get_default_config();
+          _global(dex::global_state::make_global(get_self())), _counters(get_self()) {
     }
 
     ~dex_contract() {
         _global->save(get_self());
+        _counters.save(get_self());
     }
 
     [[eosio::action]] void init();
@@ -58,6 +59,17 @@ public:
              const asset &price, const uint64_t &external_id,
              const optional<dex::order_config_ex_t> &order_config_ex);
 
+    /**
+     * set the key which signs the relayed orders of user
+     */
+    [[eosio::action]] void setrelaykey(const name &user, const public_key &pubkey);
+
+    /**
+     * new orders of many users in one action, must authenticate by admin. Each order is signed
+     * by the relay key of its user and has a new nonce, see dex::relay_order_t
+     */
+    [[eosio::action]] void relayorders(const vector<dex::relay_order_t> &orders);
+
     [[eosio::action]] void buymarket(const name &user, const uint64_t &sympair_id,
                                      const asset &coins, const uint64_t &external_id,
                                      const optional<dex::order_config_ex_t> &order_config_ex);
@@ -75,6 +87,17 @@ public:
                                      const uint64_t &external_id,
                                      const optional<dex::order_config_ex_t> &order_config_ex);
 
+    /**
+     * convert quantity along a path of symbol pairs in one action, each leg is filled like a market
+     * order against the limit orders of its pair, at most DEX_MATCH_COUNT_MAX fills in total
+     * @param user - user, should deposit quantity by transfer first
+     * @param path - the symbol pair ids, the quantity of a leg is the output of the previous leg
+     * @param quantity - the input of the first leg
+     * @param min_output - the min output of the last leg
+     */
+    [[eosio::action]] void routeorder(const name &user, const vector<uint64_t> &path,
+                                      const extended_asset &quantity, const extended_asset &min_output);
+
     /**
      *  @param max_count the max count of match item
      *  @param sym_pairs the symol pairs to match. is empty, match all
@@ -83,8 +106,76 @@ public:
 
     [[eosio::action]] void cancel(const uint64_t &order_id);
 
+    /**
+     * new stop or take-profit order, its quantity is frozen now and it is placed as a new order
+     * when a deal price of the symbol pair reaches trigger_price
+     * @param trigger_type - STOP: buy when price >= trigger_price, sell when price <= trigger_price;
+     *                       TAKE_PROFIT: buy when price <= trigger_price, sell when price >= trigger_price
+     * @param trigger_price - the trigger price, in coin symbol
+     * the other params are the same as neworder
+     */
+    [[eosio::action]] void newtrigger(const name &user, const uint64_t &sympair_id,
+                                      const name &trigger_type, const asset &trigger_price,
+                                      const name &order_type, const name &order_side,
+                                      const asset &limit_quant, const asset &price,
+                                      const uint64_t &external_id);
+
+    [[eosio::action]] void canceltrig(const uint64_t &trigger_id);
+
+    /**
+     * switch the call auction mode of symbol pair, must authenticate by admin
+     * @param sympair_id - symbol pair id
+     * @param interval_blocks - the min blocks between two clears
+     * @param enabled - in auction mode, only limit orders are accepted and they are settled by clear
+     */
+    [[eosio::action]] void setauction(const uint64_t &sympair_id, const uint32_t &interval_blocks, const bool &enabled);
+
+    /**
+     * settle the crossing limit orders of symbol pair in auction mode at one uniform price
+     * @param max_count the max count of match item
+     */
+    [[eosio::action]] void clear(const name &matcher, const uint64_t &sympair_id, const uint32_t &max_count, const string &memo);
+
+    /**
+     * create or update the amm pool of symbol pair, must authenticate by admin
+     * @param sympair_id - symbol pair id
+     * @param fee_ratio - the lp fee ratio of swap input, stays in the pool
+     * @param enabled - whether market orders can be filled by the pool
+     */
+    [[eosio::action]] void setpool(const uint64_t &sympair_id, const int64_t &fee_ratio, const bool &enabled);
+
+    /**
+     * add liquidity to the amm pool from the dex balances of user. The first provider sets the
+     * pool price, later ones deposit at the pool price, the excess of one side is not taken
+     */
+    [[eosio::action]] void addliquidity(const name &user, const uint64_t &sympair_id,
+                                        const asset &asset_quant, const asset &coin_quant);
+
+    /**
+     * remove liquidity of shares from the amm pool to the dex balances of user
+     */
+    [[eosio::action]] void rmliquidity(const name &user, const uint64_t &sympair_id, const uint64_t &shares);
+
     [[eosio::action]] void cleandata(const uint64_t &max_count);
 
+    /**
+     * emit the open orders of symbol pair as bookchunk notifications, in the order of the
+     * ordermatch index, for bootstrapping an off-chain mirror of the book
+     * @param cursor - the next_cursor of the last bookchunk to resume after, empty to start
+     * @param max_count - the max orders to emit, at most DEX_SNAPSHOT_COUNT_MAX
+     */
+    [[eosio::action]] void snapshot(const uint64_t &sympair_id, const optional<dex::book_cursor_t> &cursor,
+                                    const uint32_t &max_count);
+
+    /**
+     * a chunk of the book snapshot of symbol pair, only sent inline by snapshot
+     * @param last_deal_id - the last deal id when the chunk is emitted, the mirror follows the deals after it
+     * @param next_cursor - the cursor to resume the snapshot, empty if the snapshot is complete
+     */
+    [[eosio::action]] void bookchunk(const uint64_t &sympair_id, const uint64_t &last_deal_id,
+                                     const vector<dex::book_order_t> &orders,
+                                     const optional<dex::book_cursor_t> &next_cursor);
+
     [[eosio::action]] void version();
 
     [[eosio::action]] void name2uint(const name& n) { check(false, to_string(n.value)); };
@@ -107,6 +198,8 @@ public:
     using selllimit_action  = action_wrapper<"selllimit"_n, &dex_contract::selllimit>;
     using match_action      = action_wrapper<"match"_n, &dex_contract::match>;
     using cancel_action     = action_wrapper<"cancel"_n, &dex_contract::cancel>;
+    using clear_action      = action_wrapper<"clear"_n, &dex_contract::clear>;
+    using bookchunk_action  = action_wrapper<"bookchunk"_n, &dex_contract::bookchunk>;
 
 public:
     std::string to_hex(const char* d, uint32_t s){
@@ -133,10 +226,25 @@ public:
 
 private:
     dex::config get_default_config();
+
+    // the config singleton is read on first access
+    inline const dex::config &get_config() {
+        if (!_config) {
+            _config = _conf_tbl.get_or_default(get_default_config());
+        }
+        return *_config;
+    }
+
     void process_refund(dex::order_t &buy_order);
     void match_sympair(const name &matcher, const dex::symbol_pair_t &sym_pair, uint32_t max_count,
                         uint32_t &matched_count, const string &memo);
-    void update_latest_deal_price(const uint64_t& sympair_id, const asset& latest_deal_price);
+    asset take_sympair(const name &user, const dex::symbol_pair_t &sym_pair, const dex::order_side_t &side,
+                       asset &quantity, uint32_t &matched_count);
+    uint32_t activate_triggers(const dex::symbol_pair_t &sym_pair, const asset &deal_price);
+    bool is_auction_sympair(uint64_t sympair_id);
+    bool match_pool(const dex::symbol_pair_t &sym_pair, dex::order_tbl &order_tbl, const dex::order_t &order);
+    uint32_t update_market(const uint64_t &sympair_id, const dex::candle_t &deals, const time_point_sec &now);
+    void save_candle(uint64_t sympair_id, const dex::candle_interval_t &interval, const dex::candle_t &candle);
 
     void new_order(const name &user, const uint64_t &sympair_id,
             const name &order_type, const name &order_side,
@@ -145,6 +253,13 @@ private:
             const uint64_t &external_id,
             const optional<dex::order_config_ex_t> &order_config_ex);
 
+    void place_order(const name &user, const uint64_t &sympair_id,
+            const name &order_type, const name &order_side,
+            const asset &limit_quant,
+            const optional<asset> &price,
+            const uint64_t &external_id,
+            const optional<dex::order_config_ex_t> &order_config_ex);
+
     void add_balance(const name &user, const name &bank, const asset &quantity, const name &ram_payer);
 
     inline void sub_balance(const name &user, const name &bank, const asset &quantity, const name &ram_payer) {
@@ -157,6 +272,7 @@ private:
     bool check_dex_enabled();
 
     dex::config_table _conf_tbl;
-    dex::config _config;
+    optional<dex::config> _config;
     dex::global_state::ptr_t _global;
+    dex::counters_state _counters;
 };
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "dex_match.hpp"
+
+namespace dex {
+
+    /**
+     * The output of swapping inp into a constant-product pool, the same formula as
+     * exchange_state::get_bancor_output of eosio.system: out = out_reserve * inp / (inp_reserve + inp).
+     * It is computed in 128-bit integers and rounds down, in favor of the pool.
+     */
+    inline int64_t get_bancor_output(int64_t inp_reserve, int64_t out_reserve, int64_t inp) {
+        ASSERT(inp_reserve >= 0 && out_reserve >= 0 && inp >= 0);
+        if (inp == 0 || out_reserve == 0) return 0;
+        int128_t out = int128_t(out_reserve) * inp / (int128_t(inp_reserve) + inp);
+        ASSERT(out < out_reserve);
+        return int64_t(out);
+    }
+
+    inline uint64_t isqrt(uint128_t value) {
+        if (value < 2) return uint64_t(value);
+        // newton's method from an upper bound, decreasing to floor(sqrt(value))
+        uint128_t x = value;
+        uint128_t y = (x + 1) / 2;
+        while (y < x) {
+            x = y;
+            y = (x + value / x) / 2;
+        }
+        return uint64_t(x);
+    }
+
+    // the average price of a deal, in the coin symbol
+    inline asset calc_deal_price(const asset &deal_assets, const asset &deal_coins) {
+        ASSERT(deal_assets.amount > 0);
+        int64_t precision = calc_precision(deal_assets.symbol.precision());
+        return asset(mul_div_round(deal_coins.amount, precision, deal_assets.amount), deal_coins.symbol);
+    }
+
+}// namespace dex
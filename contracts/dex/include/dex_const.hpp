@@ -9,8 +9,16 @@ constexpr int64_t FEE_RATIO_MAX             = 4999;      // 49.99%, max fee rati
 constexpr int64_t DEX_MAKER_FEE_RATIO       = 4;         // 0.04%, dex maker fee ratio
 constexpr int64_t DEX_TAKER_FEE_RATIO       = 8;         // 0.04%, dex taker fee ratio
 constexpr uint32_t DEX_MATCH_COUNT_MAX      = 50;         // the max dex match count.
+constexpr uint32_t DEX_ROUTE_PATH_MAX       = 4;          // the max symbol pairs of a route order
+constexpr uint32_t DEX_TRIGGER_ACTIVATE_MAX = 20;         // the max trigger orders activated per matched price
+constexpr uint32_t DEX_SNAPSHOT_COUNT_MAX   = 1000;       // the max orders emitted by one snapshot action
+constexpr uint32_t DEX_SNAPSHOT_CHUNK_SIZE  = 100;        // the max orders of one bookchunk notification
 constexpr uint64_t DATA_RECYCLE_SEC         = 90 * 3600 * 24; // recycle time: 90 days, in seconds
 
+constexpr uint32_t CANDLE_MINUTE_SLOTS      = 1440;       // 1m candles kept in the ring: 1 day
+constexpr uint32_t CANDLE_HOUR_SLOTS        = 720;        // 1h candles kept in the ring: 30 days
+constexpr uint32_t CANDLE_DAY_SLOTS         = 366;        // 1d candles kept in the ring: 1 year
+
 constexpr int64_t MEMO_LEN_MAX              = 255;        // 0.001%, max memo length
 constexpr int64_t URL_LEN_MAX               = 255;        // 0.001%, max url length
 
@@ -2,6 +2,7 @@
 
 #include "dex_states.hpp"
 #include <utils.hpp>
+#include "fixed_point.hpp"
 
 namespace dex {
 
@@ -24,14 +25,14 @@ namespace dex {
 
     int64_t calc_asset_amount(const asset &coin_quant, const asset &price, const symbol &asset_symbol) {
         ASSERT(coin_quant.symbol.precision() == price.symbol.precision());
-        int128_t precision = calc_precision(asset_symbol.precision());
-        return divide_decimal64(coin_quant.amount, price.amount, precision);
+        int64_t precision = calc_precision(asset_symbol.precision());
+        return mul_div_round(coin_quant.amount, precision, price.amount);
     }
 
     int64_t calc_coin_amount(const asset &asset_quant, const asset &price, const symbol &coin_symbol) {
         ASSERT(coin_symbol.precision() == price.symbol.precision());
-        int128_t precision = calc_precision(asset_quant.symbol.precision());
-        return multiply_decimal64(asset_quant.amount, price.amount, precision);
+        int64_t precision = calc_precision(asset_quant.symbol.precision());
+        return mul_div_round(asset_quant.amount, price.amount, precision);
     }
 
     asset calc_asset_quant(const asset &coin_quant, const asset &price, const symbol &asset_symbol) {
@@ -44,7 +45,7 @@ namespace dex {
 
     inline asset calc_match_fee(int64_t ratio, const asset &quant) {
         if (quant.amount == 0) return asset{0, quant.symbol};
-        int64_t fee = multiply_decimal64(quant.amount, ratio, RATIO_PRECISION);
+        int64_t fee = mul_div_round(quant.amount, ratio, RATIO_PRECISION);
         CHECK(fee < quant.amount, "the calc_fee is large than quantity=" + quant.to_string() + ", ratio=" + to_string(ratio));
         return asset{fee, quant.symbol};
     }
@@ -370,4 +371,40 @@ namespace dex {
         }
     };
 
+    /**
+     * The uniform price of a call auction. Walks the limit buy orders from the highest price and
+     * the limit sell orders from the lowest price while they cross, at most max_count fills, and
+     * takes the middle of the last crossing buy and sell prices, so that every crossing order can
+     * be settled at it within its own price. Returns 0 if nothing crosses.
+     */
+    template<typename match_index_t>
+    asset calc_auction_price(match_index_t &match_index, const symbol_pair_t &sym_pair, uint32_t max_count) {
+        const auto &sympair_id = sym_pair.sympair_id;
+        auto in_side = [&](const auto &it, const order_side_t &side) {
+            return it != match_index.end() && it->sympair_id == sympair_id && it->status == order_status::MATCHABLE &&
+                   it->order_side == side && it->order_type == order_type::LIMIT;
+        };
+        auto buy_it = match_index.upper_bound(make_order_match_idx(sympair_id, order_status::MATCHABLE, order_side::BUY,
+                order_type::LIMIT, std::numeric_limits<uint64_t>::max(), 0));
+        auto sell_it = match_index.upper_bound(make_order_match_idx(sympair_id, order_status::MATCHABLE, order_side::SELL,
+                order_type::LIMIT, 0, 0));
+
+        asset price(0, sym_pair.coin_symbol.get_symbol());
+        int64_t buy_free = in_side(buy_it, order_side::BUY) ? (buy_it->limit_quant - buy_it->matched_assets).amount : 0;
+        int64_t sell_free = in_side(sell_it, order_side::SELL) ? (sell_it->limit_quant - sell_it->matched_assets).amount : 0;
+        for (uint32_t count = 0; count < max_count && buy_free > 0 && sell_free > 0 && buy_it->price >= sell_it->price; count++) {
+            price.amount = (buy_it->price.amount + sell_it->price.amount) / 2;
+            auto matched = std::min(buy_free, sell_free);
+            buy_free -= matched;
+            sell_free -= matched;
+            if (buy_free == 0 && in_side(++buy_it, order_side::BUY)) {
+                buy_free = (buy_it->limit_quant - buy_it->matched_assets).amount;
+            }
+            if (sell_free == 0 && in_side(++sell_it, order_side::SELL)) {
+                sell_free = (sell_it->limit_quant - sell_it->matched_assets).amount;
+            }
+        }
+        return price;
+    }
+
 }// namespace dex
\ No newline at end of file
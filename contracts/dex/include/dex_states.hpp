@@ -5,6 +5,8 @@
 #include <eosio/name.hpp>
 #include <eosio/asset.hpp>
 #include <eosio/singleton.hpp>
+#include <eosio/binary_extension.hpp>
+#include <eosio/crypto.hpp>
 #include "dex_const.hpp"
 #include "utils.hpp"
 
@@ -81,11 +83,64 @@ namespace dex {
         }
     }
 
+    typedef name trigger_type_t;
+
+    namespace trigger_type {
+        static const trigger_type_t STOP = "stop"_n;              // buy above or sell below the trigger price
+        static const trigger_type_t TAKE_PROFIT = "takeprofit"_n; // buy below or sell above the trigger price
+
+        inline bool is_valid(const trigger_type_t &value) {
+            return value == STOP || value == TAKE_PROFIT;
+        }
+    }
+
     struct order_config_ex_t {
         uint64_t taker_fee_ratio = 0;
         uint64_t maker_fee_ratio = 0;
     };
 
+    /**
+     * An order signed by its user and submitted by the dex admin in relayorders. The signature is
+     * over make_relay_order_digest, the nonce must be greater than the last relayed one of user.
+     */
+    struct relay_order_t {
+        name user;
+        uint64_t sympair_id;
+        name order_type;
+        name order_side;
+        asset limit_quant;
+        asset price;
+        uint64_t external_id;
+        uint64_t nonce;
+        signature sig;
+    };
+
+    /**
+     * An open order in the book snapshot of a symbol pair, see the snapshot action. The amounts
+     * are in the symbols of the order_t fields of the same names.
+     */
+    struct book_order_t {
+        uint64_t order_id;
+        name owner;
+        order_type_t order_type;
+        order_side_t order_side;
+        int64_t price;
+        int64_t limit_quant;
+        int64_t matched_assets;
+        int64_t matched_coins;
+    };
+
+    /**
+     * The ordermatch index position of the last order of a book snapshot chunk, the snapshot
+     * resumes after it even if that order is no longer open
+     */
+    struct book_cursor_t {
+        order_side_t order_side;
+        order_type_t order_type;
+        uint64_t price;
+        uint64_t order_id;
+    };
+
     struct DEX_TABLE config {
         bool dex_enabled;     // if false, disable all operation of common user
         name dex_admin;   // admin of this contract, permisions: manage sym_pairs, authorize order
@@ -113,18 +168,15 @@ namespace dex {
 
         using ptr_t = std::unique_ptr<global_state>;
 
+        // the global row is read on the first new id, the actions which create nothing skip it
         static ptr_t make_global(const name &contract) {
-            std::shared_ptr<global_table> global_tbl;
             auto ret = std::make_unique<global_state>();
             ret->_global_tbl = std::make_unique<global_table>(contract, contract.value);
-
-            if (ret->_global_tbl->exists()) {
-                static_cast<global&>(*ret) = ret->_global_tbl->get();
-            }
             return ret;
         }
 
         inline uint64_t new_auto_inc_id(uint64_t &id) {
+            load();
             if (id == 0 || id == std::numeric_limits<uint64_t>::max()) {
                 id = 1;
             } else {
@@ -146,6 +198,11 @@ namespace dex {
             return new_auto_inc_id(deal_item_id);
         }
 
+        inline uint64_t last_deal_item_id() {
+            load();
+            return deal_item_id;
+        }
+
         inline void change() {
             changed = true;
         }
@@ -158,9 +215,113 @@ namespace dex {
             }
         }
     private:
+        inline void load() {
+            if (!_loaded) {
+                static_cast<global&>(*this) = _global_tbl->get_or_default();
+                _loaded = true;
+            }
+        }
+
+        bool _loaded = false;
         std::unique_ptr<global_table> _global_tbl;
     };
 
+    /**
+     * Row and activity counters for monitoring, in the scope of a sympair_id for one symbol pair
+     * and in the scope of the contract for the totals. The volumes are only counted per symbol
+     * pair and balance_rows only in total.
+     */
+    struct DEX_TABLE counters {
+        uint64_t open_buy_orders  = 0; // matchable buy orders
+        uint64_t open_sell_orders = 0; // matchable sell orders
+        uint64_t total_orders     = 0; // orders ever created
+        uint64_t deal_rows        = 0; // rows in the deal table
+        uint64_t fills            = 0; // deals ever made
+        uint64_t cancels          = 0; // orders ever canceled
+        uint64_t balance_rows     = 0; // rows in the account tables of all users
+        uint64_t asset_volume     = 0; // matched assets ever, in the smallest unit of asset_symbol
+        uint64_t coin_volume      = 0; // matched coins ever, in the smallest unit of coin_symbol
+    };
+
+    typedef eosio::singleton< "counters"_n, counters > counters_table;
+
+    /**
+     * Caches the counters rows touched by an action, every row is loaded and saved at most once.
+     * The counters start at zero when they are introduced, so the decrements never go below zero.
+     */
+    class counters_state {
+    public:
+        explicit counters_state(const name &contract) : _contract(contract) {}
+
+        inline void on_new_order(uint64_t sympair_id, const order_side_t &side) {
+            for (auto c : {&get(_contract.value), &get(sympair_id)}) {
+                c->total_orders++;
+                open_orders(*c, side)++;
+            }
+        }
+
+        inline void on_order_completed(uint64_t sympair_id, const order_side_t &side) {
+            for (auto c : {&get(_contract.value), &get(sympair_id)}) {
+                decrease(open_orders(*c, side));
+            }
+        }
+
+        inline void on_order_canceled(uint64_t sympair_id, const order_side_t &side) {
+            for (auto c : {&get(_contract.value), &get(sympair_id)}) {
+                decrease(open_orders(*c, side));
+                c->cancels++;
+            }
+        }
+
+        // an auction deal row settles several fills
+        inline void on_deal(uint64_t sympair_id, const asset &deal_assets, const asset &deal_coins, uint64_t fills = 1) {
+            for (auto c : {&get(_contract.value), &get(sympair_id)}) {
+                c->deal_rows++;
+                c->fills += fills;
+            }
+            auto &sympair_counters = get(sympair_id);
+            sympair_counters.asset_volume += deal_assets.amount;
+            sympair_counters.coin_volume += deal_coins.amount;
+        }
+
+        inline void on_deal_erased(uint64_t sympair_id) {
+            for (auto c : {&get(_contract.value), &get(sympair_id)}) {
+                decrease(c->deal_rows);
+            }
+        }
+
+        inline void on_balance_created() {
+            get(_contract.value).balance_rows++;
+        }
+
+        inline void save(const name &payer) {
+            for (auto &item : _items) {
+                counters_table(_contract, item.first).set(item.second, payer);
+            }
+            _items.clear();
+        }
+
+    private:
+        counters &get(uint64_t scope) {
+            auto it = _items.find(scope);
+            if (it == _items.end()) {
+                it = _items.emplace(scope, counters_table(_contract, scope).get_or_default()).first;
+            }
+            return it->second;
+        }
+
+        static uint64_t &open_orders(counters &c, const order_side_t &side) {
+            return side == order_side::BUY ? c.open_buy_orders : c.open_sell_orders;
+        }
+
+        static void decrease(uint64_t &value) {
+            if (value > 0) value--;
+        }
+
+        name _contract;
+        std::map<uint64_t, counters> _items;
+    };
+
     using uint256_t = fixed_bytes<32>;
 
     static inline uint256_t make_symbols_idx(const extended_symbol &asset_symbol, const extended_symbol &coin_symbol) {
@@ -171,6 +332,72 @@ namespace dex {
                 coin_symbol.get_symbol().code().raw());
     }
 
+    /**
+     * OHLCV of the deals in a time bucket, the prices are in the smallest unit of coin_symbol.
+     */
+    struct candle_t {
+        time_point_sec start;     // start of the bucket
+        int64_t open          = 0;
+        int64_t high          = 0;
+        int64_t low           = 0;
+        int64_t close         = 0;
+        int64_t asset_volume  = 0;
+        int64_t coin_volume   = 0;
+        uint32_t deals        = 0;
+
+        inline bool empty() const { return deals == 0; }
+
+        inline void add_deal(const asset &price, const asset &deal_assets, const asset &deal_coins) {
+            if (empty()) {
+                open = high = low = price.amount;
+            } else {
+                high = std::max(high, price.amount);
+                low = std::min(low, price.amount);
+            }
+            close = price.amount;
+            asset_volume += deal_assets.amount;
+            coin_volume += deal_coins.amount;
+            deals++;
+        }
+
+        inline void merge(const candle_t &later) {
+            ASSERT(!later.empty());
+            if (empty()) {
+                open = later.open;
+                high = later.high;
+                low = later.low;
+            } else {
+                high = std::max(high, later.high);
+                low = std::min(low, later.low);
+            }
+            close = later.close;
+            asset_volume += later.asset_volume;
+            coin_volume += later.coin_volume;
+            deals += later.deals;
+        }
+    };
+
+    struct candle_interval_t {
+        uint32_t seconds;
+        uint32_t slots; // capacity of the ring
+    };
+
+    // the intervals of sympair_market_t::candles, in this order
+    static constexpr candle_interval_t CANDLE_INTERVALS[] = {
+        {60,        CANDLE_MINUTE_SLOTS},
+        {3600,      CANDLE_HOUR_SLOTS},
+        {3600 * 24, CANDLE_DAY_SLOTS},
+    };
+
+    /**
+     * Latest deal time and open candles of a symbol pair, kept in the sympair row and written with
+     * latest_deal_price.
+     */
+    struct sympair_market_t {
+        time_point_sec latest_deal_time;
+        std::vector<candle_t> candles; // the open candle of each of CANDLE_INTERVALS
+    };
+
     struct DEX_TABLE symbol_pair_t {
         uint64_t sympair_id; // PK: auto-increment
         extended_symbol asset_symbol;
@@ -182,6 +409,7 @@ namespace dex {
         int64_t maker_fee_ratio;
         bool only_accept_coin_fee;
         bool enabled;
+        binary_extension<sympair_market_t> market; // set by the first deal of the pair
 
         uint64_t primary_key() const { return sympair_id; }
         inline uint256_t get_symbols_idx() const { return make_symbols_idx(asset_symbol, coin_symbol); }
@@ -367,4 +595,170 @@ namespace dex {
         return deal_table(self, self.value/*scope*/);
     }
 
+    inline static uint64_t make_candle_slot(uint32_t interval_seconds, uint32_t bucket) {
+        return (uint64_t(interval_seconds) << 32) | bucket;
+    }
+
+    /**
+     * Ring of closed candles, scope: sympair_id. A candle is closed by the first deal of a later
+     * bucket, and overwrites the candle of the same slot one ring capacity before.
+     */
+    struct DEX_TABLE candle_slot_t {
+        uint64_t slot; // PK: make_candle_slot(interval seconds, bucket number % slots)
+        candle_t candle;
+
+        uint64_t primary_key() const { return slot; }
+    };
+
+    typedef eosio::multi_index<"candle"_n, candle_slot_t> candle_table;
+
+    inline static candle_table make_candle_table(const name &self, uint64_t sympair_id) {
+        return candle_table(self, sympair_id/*scope*/);
+    }
+
+    /**
+     * Constant-product liquidity pool of a symbol pair, market orders are filled by it when it
+     * gives a better price than the order book.
+     */
+    struct DEX_TABLE pool_t {
+        uint64_t sympair_id; // PK: same as symbol_pair_t
+        asset asset_reserve;
+        asset coin_reserve;
+        uint64_t total_shares = 0;
+        int64_t fee_ratio     = 0; // lp fee ratio of the swap input, stays in the reserves
+        bool enabled          = false;
+
+        uint64_t primary_key() const { return sympair_id; }
+    };
+
+    typedef eosio::multi_index<"pool"_n, pool_t> pool_table;
+
+    inline static pool_table make_pool_table(const name &self) {
+        return pool_table(self, self.value/*scope*/);
+    }
+
+    /**
+     * Liquidity provider shares of a pool, scope: sympair_id
+     */
+    struct DEX_TABLE lp_share_t {
+        name owner; // PK
+        uint64_t shares = 0;
+
+        uint64_t primary_key() const { return owner.value; }
+    };
+
+    typedef eosio::multi_index<"lpshare"_n, lp_share_t> lp_share_table;
+
+    inline static lp_share_table make_lp_share_table(const name &self, uint64_t sympair_id) {
+        return lp_share_table(self, sympair_id/*scope*/);
+    }
+
+    /**
+     * Call auction mode of a symbol pair: the limit orders are not matched continuously, the clear
+     * action settles all crossing orders at one uniform price, at most once per interval_blocks.
+     */
+    struct DEX_TABLE auction_t {
+        uint64_t sympair_id; // PK: same as symbol_pair_t
+        uint32_t interval_blocks = 0;
+        block_timestamp last_cleared_at;
+        bool enabled = false;
+
+        uint64_t primary_key() const { return sympair_id; }
+    };
+
+    typedef eosio::multi_index<"auction"_n, auction_t> auction_table;
+
+    inline static auction_table make_auction_table(const name &self) {
+        return auction_table(self, self.value/*scope*/);
+    }
+
+    // triggers fired by a deal price >= trigger price come first by the lowest trigger price,
+    // those fired by a deal price <= trigger price by the highest trigger price
+    inline static uint256_t make_trigger_idx(uint64_t sympair_id, bool fire_above, uint64_t trigger_price, uint64_t id) {
+        uint64_t price_factor = fire_above ? trigger_price : std::numeric_limits<uint64_t>::max() - trigger_price;
+        return uint256_t::make_from_word_sequence<uint64_t>(sympair_id, fire_above ? 1 : 0, price_factor, id);
+    }
+
+    /**
+     * Stop or take-profit order, its quantity is frozen at creation. It becomes a matchable order
+     * of the order table when a deal price of the symbol pair reaches the trigger price.
+     */
+    struct DEX_TABLE trigger_order_t {
+        uint64_t id; // PK: available_primary_key
+        uint64_t external_id;
+        name owner;
+        uint64_t sympair_id;
+        trigger_type_t trigger_type;
+        asset trigger_price;
+        order_type_t order_type;
+        order_side_t order_side;
+        asset limit_quant;
+        asset frozen_quant;
+        asset price;
+        int64_t taker_fee_ratio = 0;
+        int64_t maker_fee_ratio = 0;
+        time_point created_at;
+
+        uint64_t primary_key() const { return id; }
+
+        inline bool fire_above() const {
+            return (trigger_type == trigger_type::STOP) == (order_side == order_side::BUY);
+        }
+
+        uint256_t get_trigger_idx() const {
+            return make_trigger_idx(sympair_id, fire_above(), trigger_price.amount, id);
+        }
+    };
+
+    using trigger_idx = indexed_by<"triggeridx"_n, const_mem_fun<trigger_order_t, uint256_t, &trigger_order_t::get_trigger_idx> >;
+
+    typedef eosio::multi_index<"trigger"_n, trigger_order_t, trigger_idx> trigger_table;
+
+    inline static trigger_table make_trigger_table(const name &self) {
+        return trigger_table(self, self.value/*scope*/);
+    }
+
+    /**
+     * The key which signs the relayed orders of user, and the last nonce relayed
+     */
+    struct DEX_TABLE relay_account_t {
+        name user; // PK
+        public_key pubkey;
+        uint64_t nonce = 0;
+
+        uint64_t primary_key() const { return user.value; }
+    };
+
+    typedef eosio::multi_index<"relayacct"_n, relay_account_t> relay_account_table;
+
+    inline static relay_account_table make_relay_account_table(const name &self) {
+        return relay_account_table(self, self.value/*scope*/);
+    }
+
+    /**
+     * sha256 of the 32 bytes of chain_id followed by the little-endian uint64 sequence: contract,
+     * user, sympair_id, order_type, order_side, limit_quant amount and symbol, price amount and
+     * symbol, external_id, nonce. The chain id keeps an order from being replayed on another chain.
+     */
+    inline checksum256 make_relay_order_digest(const checksum256 &chain_id, const name &self, const relay_order_t &order) {
+        const uint64_t words[] = {
+            self.value, order.user.value, order.sympair_id, order.order_type.value, order.order_side.value,
+            uint64_t(order.limit_quant.amount), order.limit_quant.symbol.raw(),
+            uint64_t(order.price.amount), order.price.symbol.raw(),
+            order.external_id, order.nonce
+        };
+        const auto chain_bytes = chain_id.extract_as_byte_array();
+        char buf[std::size(chain_bytes) + sizeof(words)];
+        for (size_t i = 0; i < std::size(chain_bytes); i++) {
+            buf[i] = char(chain_bytes[i]);
+        }
+        char *word_buf = buf + std::size(chain_bytes);
+        for (size_t i = 0; i < std::size(words); i++) {
+            for (size_t b = 0; b < sizeof(uint64_t); b++) {
+                word_buf[i * sizeof(uint64_t) + b] = char(words[i] >> (8 * b));
+            }
+        }
+        return sha256(buf, sizeof(buf));
+    }
+
 }// namespace dex
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <limits>
+#include "utils.hpp"
+
+/**
+ * Checked fixed-point kernel of the dex: amounts, prices and fee ratios are non-negative int64
+ * numbers with an implied precision, and every conversion between them is a * b / c.
+ *
+ * The product is taken in 64 bits when it fits, checked with __builtin_mul_overflow, and in
+ * 128 bits otherwise. The quotient and the remainder come from a single division, the rounding
+ * is decided from the remainder. The result is CHECKed to fit int64.
+ */
+namespace dex {
+
+    namespace fixed_point {
+
+        inline bool fits_int64(uint64_t v) {
+            return v <= uint64_t(std::numeric_limits<int64_t>::max());
+        }
+
+        // q = a * b / c, r = a * b % c, returns false if q does not fit int64
+        inline bool mul_div(int64_t a, int64_t b, int64_t c, uint64_t &q, uint64_t &r) {
+            ASSERT(a >= 0 && b >= 0 && c > 0);
+            uint64_t p;
+            if (!__builtin_mul_overflow(uint64_t(a), uint64_t(b), &p)) {
+                q = p / uint64_t(c);
+                r = p - q * uint64_t(c);
+                return fits_int64(q);
+            }
+            uint128_t p128 = uint128_t(a) * uint64_t(b);
+            uint128_t q128 = p128 / uint64_t(c);
+            if (q128 > std::numeric_limits<int64_t>::max()) return false;
+            q = uint64_t(q128);
+            r = uint64_t(p128 - q128 * uint64_t(c));
+            return true;
+        }
+
+    }// namespace fixed_point
+
+    // floor(a * b / c)
+    inline int64_t mul_div_floor(int64_t a, int64_t b, int64_t c) {
+        uint64_t q, r;
+        CHECK(fixed_point::mul_div(a, b, c, q, r), "overflow exception of mul_div_floor");
+        return int64_t(q);
+    }
+
+    // ceil(a * b / c)
+    inline int64_t mul_div_ceil(int64_t a, int64_t b, int64_t c) {
+        uint64_t q, r;
+        bool ok = fixed_point::mul_div(a, b, c, q, r);
+        if (ok && r != 0) ok = fixed_point::fits_int64(++q);
+        CHECK(ok, "overflow exception of mul_div_ceil");
+        return int64_t(q);
+    }
+
+    // a * b / c rounded half up, the rounding of the dex amounts, prices and fees
+    inline int64_t mul_div_round(int64_t a, int64_t b, int64_t c) {
+        uint64_t q, r;
+        bool ok = fixed_point::mul_div(a, b, c, q, r);
+        // r >= c / 2, written without overflowing 2 * r
+        if (ok && r >= uint64_t(c) - r) ok = fixed_point::fits_int64(++q);
+        CHECK(ok, "overflow exception of mul_div_round");
+        return int64_t(q);
+    }
+
+}// namespace dex
@@ -28,25 +28,6 @@ using namespace std;
 
 #define CHECK(exp, msg) { if (!(exp)) eosio::check(false, msg); }
 
-template<typename T>
-int128_t divide_decimal(int128_t a, int128_t b, int128_t precision) {
-    int128_t tmp = 10 * a * precision  / b;
-    CHECK(tmp >= std::numeric_limits<T>::min() && tmp <= std::numeric_limits<T>::max(),
-          "overflow exception of divide_decimal");
-    return (tmp + 5) / 10;
-}
-
-template<typename T>
-int128_t multiply_decimal(int128_t a, int128_t b, int128_t precision) {
-    int128_t tmp = 10 * a * b / precision;
-    CHECK(tmp >= std::numeric_limits<T>::min() && tmp <= std::numeric_limits<T>::max(),
-          "overflow exception of multiply_decimal");
-    return (tmp + 5) / 10;
-}
-
-#define divide_decimal64(a, b, precision) divide_decimal<int64_t>(a, b, precision)
-#define multiply_decimal64(a, b, precision) multiply_decimal<int64_t>(a, b, precision)
-
 string_view trim(string_view sv) {
     sv.remove_prefix(std::min(sv.find_first_not_of(" "), sv.size())); // left trim
     sv.remove_suffix(std::min(sv.size()-sv.find_last_not_of(" ")-1, sv.size())); // right trim
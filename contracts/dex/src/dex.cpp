@@ -8,7 +8,7 @@ using namespace std;
 using namespace dex;
 
 #define CHECK_DEX_ENABLED() { \
-    CHECK(_config.dex_enabled, string("DEX is disabled! function=") + __func__); \
+    CHECK(get_config().dex_enabled, string("DEX is disabled! function=") + __func__); \
 }
 
 inline std::string str_to_upper(string_view str) {
@@ -38,6 +38,52 @@ inline string symbol_pair_to_string(const symbol &asset_symbol, const symbol &co
     return symbol_to_string(asset_symbol) + "/" + symbol_to_string(coin_symbol);
 }
 
+// check the order quantities and calc the quantity to freeze from the balance of user
+asset calc_frozen_quant(const symbol_pair_t &sym_pair, const name &order_type, const name &order_side,
+                        const asset &limit_quant, const optional<asset> &price, int64_t taker_fee_ratio) {
+    const auto &asset_symbol = sym_pair.asset_symbol.get_symbol();
+    const auto &coin_symbol = sym_pair.coin_symbol.get_symbol();
+
+    // check price
+    if (price) {
+        CHECK(price->symbol == coin_symbol, "The price symbol mismatch with coin_symbol")
+        if (order_type == dex::order_type::LIMIT) {
+            CHECK( price->amount > 0, "The price must > 0 for limit order")
+        } else { // order.order_type == dex::order_type::LIMIT
+            CHECK( price->amount == 0, "The price must == 0 for market order")
+        }
+    }
+
+    asset frozen_quant;
+    if (order_side == dex::order_side::BUY) {
+        if (order_type == dex::order_type::LIMIT) {
+            CHECK( limit_quant.symbol == asset_symbol,
+                    "The limit_symbol=" + symbol_to_string(limit_quant.symbol) +
+                        " mismatch with asset_symbol=" + symbol_to_string(asset_symbol) +
+                        " for limit buy order");
+            ASSERT(price.has_value());
+            frozen_quant = dex::calc_coin_quant(limit_quant, *price, coin_symbol);
+        } else {// order_type == order_type::MARKET
+            CHECK(limit_quant.symbol == coin_symbol,
+                    "The limit_symbol=" + symbol_to_string(limit_quant.symbol) +
+                        " mismatch with coin_symbol=" + symbol_to_string(coin_symbol) +
+                        " for market buy order");
+            frozen_quant = limit_quant;
+        }
+        if (sym_pair.only_accept_coin_fee) {
+            frozen_quant += dex::calc_match_fee(taker_fee_ratio, frozen_quant);
+        }
+
+    } else { // order_side == order_side::SELL
+        CHECK( limit_quant.symbol == asset_symbol,
+                "The limit_symbol=" + symbol_to_string(limit_quant.symbol) +
+                    " mismatch with asset_symbol=" + symbol_to_string(asset_symbol) +
+                    " for sell order");
+        frozen_quant = limit_quant;
+    }
+    return frozen_quant;
+}
+
 ACTION dex_contract::init() {
     // order_tbl orders(_self, _self.value);
 
@@ -86,13 +132,14 @@ void dex_contract::setconfig(const dex::config &conf) {
     validate_fee_ratio( conf.taker_fee_ratio, "taker_fee_ratio");
 
     _conf_tbl.set(conf, get_self());
+    _config = conf;
 }
 
 void dex_contract::setsympair(const extended_symbol &asset_symbol,
                               const extended_symbol &coin_symbol, const asset &min_asset_quant,
                               const asset &min_coin_quant, bool only_accept_coin_fee,
                               bool enabled) {
-    require_auth( _config.dex_admin );
+    require_auth( get_config().dex_admin );
     const auto &asset_sym = asset_symbol.get_symbol();
     const auto &coin_sym = coin_symbol.get_symbol();
     auto sympair_tbl = make_sympair_table(get_self());
@@ -134,7 +181,7 @@ void dex_contract::setsympair(const extended_symbol &asset_symbol,
 }
 
 void dex_contract::onoffsympair(const uint64_t& sympair_id, const bool& on_off) {
-    require_auth( _config.dex_admin );
+    require_auth( get_config().dex_admin );
 
     auto sympair_tbl = make_sympair_table(_self);
     auto it = sympair_tbl.find(sympair_id);
@@ -145,8 +192,8 @@ void dex_contract::onoffsympair(const uint64_t& sympair_id, const bool& on_off)
 }
 
 void dex_contract::ontransfer(const name& from, const name& to, const asset& quant, const string& memo) {
+    if (from == get_self()) { return; } // the withdraw transfers
     CHECK_DEX_ENABLED()
-    if (from == get_self()) { return; }
     CHECK( to == get_self(), "Must transfer to this contract")
     CHECK( quant.amount > 0, "The quantity must be positive")
     add_balance(from, get_first_receiver(), quant, get_self());
@@ -210,6 +257,7 @@ void dex_contract::cancel(const uint64_t &order_id) {
         a.status = order_status::CANCELED;
         a.last_updated_at = current_block_time();
     });
+    _counters.on_order_canceled(order.sympair_id, order.order_side);
 }
 
 dex::config dex_contract::get_default_config() {
@@ -237,12 +285,13 @@ void dex_contract::match(const name &matcher, uint32_t max_count, const vector<u
             auto it = sympair_tbl.find(sympair_id);
             CHECK(it != sympair_tbl.end(), "The symbol pair=" + std::to_string(sympair_id) + " does not exist");
             CHECK(it->enabled, "The indicated sym_pair=" + std::to_string(sympair_id) + " is disabled");
+            CHECK(!is_auction_sympair(sympair_id), "The indicated sym_pair=" + std::to_string(sympair_id) + " is in auction mode");
             sym_pair_list.push_back(*it);
         }
     } else {
         auto sym_pair_it = sympair_tbl.begin();
         for (; sym_pair_it != sympair_tbl.end(); sym_pair_it++) {
-            if (sym_pair_it->enabled) {
+            if (sym_pair_it->enabled && !is_auction_sympair(sym_pair_it->sympair_id)) {
                 sym_pair_list.push_back(*sym_pair_it);
             }
         }
@@ -258,6 +307,187 @@ void dex_contract::match(const name &matcher, uint32_t max_count, const vector<u
     CHECK(matched_count > 0, "None matched");
 }
 
+void dex_contract::routeorder(const name &user, const vector<uint64_t> &path,
+                              const extended_asset &quantity, const extended_asset &min_output) {
+    CHECK_DEX_ENABLED()
+    require_auth(user);
+    if (get_config().admin_sign_required) { require_auth(get_config().dex_admin); }
+    CHECK(!path.empty() && path.size() <= DEX_ROUTE_PATH_MAX,
+          "The path size must be in range [1, " + std::to_string(DEX_ROUTE_PATH_MAX) + "]");
+    CHECK(quantity.quantity.amount > 0, "The quantity must > 0");
+
+    sub_balance(user, quantity.contract, quantity.quantity, user);
+
+    // the output of each leg stays in memory as the input of the next one
+    auto sympair_tbl = make_sympair_table(get_self());
+    extended_asset leg_quant = quantity;
+    uint32_t matched_count = 0;
+    for (auto sympair_id : path) {
+        auto sym_pair_it = sympair_tbl.find(sympair_id);
+        CHECK( sym_pair_it != sympair_tbl.end(), "The symbol pair id '" + std::to_string(sympair_id) + "' does not exist")
+        CHECK( sym_pair_it->enabled, "The symbol pair '" + std::to_string(sympair_id) + " is disabled")
+        CHECK( !is_auction_sympair(sympair_id), "The symbol pair '" + std::to_string(sympair_id) + "' is in auction mode")
+
+        order_side_t side;
+        extended_symbol out_symbol;
+        if (leg_quant.get_extended_symbol() == sym_pair_it->coin_symbol) {
+            side = order_side::BUY;
+            out_symbol = sym_pair_it->asset_symbol;
+        } else {
+            CHECK( leg_quant.get_extended_symbol() == sym_pair_it->asset_symbol,
+                "The route quantity " + leg_quant.quantity.to_string() + " does not belong to symbol pair '" +
+                std::to_string(sympair_id) + "'")
+            side = order_side::SELL;
+            out_symbol = sym_pair_it->coin_symbol;
+        }
+
+        auto output = take_sympair(user, *sym_pair_it, side, leg_quant.quantity, matched_count);
+        if (leg_quant.quantity.amount > 0) {
+            // the dust which can not buy any asset at the best price
+            add_balance(user, leg_quant.contract, leg_quant.quantity, user);
+        }
+        CHECK( output.amount > 0, "The route output of symbol pair '" + std::to_string(sympair_id) + "' is 0")
+        leg_quant = extended_asset(output, out_symbol.get_contract());
+    }
+    CHECK( leg_quant.get_extended_symbol() == min_output.get_extended_symbol(), "The min_output symbol mismatch with the route output")
+    CHECK( leg_quant.quantity >= min_output.quantity,
+        "The route output " + leg_quant.quantity.to_string() + " is less than min_output " + min_output.quantity.to_string())
+
+    add_balance(user, leg_quant.contract, leg_quant.quantity, user);
+}
+
+asset dex_contract::take_sympair(const name &user, const dex::symbol_pair_t &sym_pair, const dex::order_side_t &side,
+                                 asset &quantity, uint32_t &matched_count) {
+    auto cur_block_time = current_block_time();
+    auto order_tbl = make_order_table(get_self());
+    auto match_index = order_tbl.get_index<static_cast<name::raw>(order_match_idx::index_name)>();
+    bool is_buy = side == order_side::BUY;
+    auto maker_it = dex::matching_order_iterator(match_index, sym_pair.sympair_id,
+            is_buy ? order_side::SELL : order_side::BUY, order_type::LIMIT);
+
+    const auto &asset_symbol = sym_pair.asset_symbol.get_symbol();
+    const auto &coin_symbol = sym_pair.coin_symbol.get_symbol();
+    const auto &asset_bank = sym_pair.asset_symbol.get_contract();
+    const auto &coin_bank = sym_pair.coin_symbol.get_contract();
+    const auto &taker_fee_ratio = get_config().taker_fee_ratio;
+    bool buy_coin_fee = sym_pair.only_accept_coin_fee;
+
+    asset output(0, is_buy ? asset_symbol : coin_symbol);
+    asset taker_fees(0, (is_buy && !buy_coin_fee) ? asset_symbol : coin_symbol);
+    dex::candle_t matched_deals;
+    bool is_dust = false;
+    while (quantity.amount > 0 && maker_it.is_valid() && matched_count < DEX_MATCH_COUNT_MAX) {
+        const auto &maker_order = maker_it.stored_order();
+        const auto &matched_price = maker_order.price;
+        auto maker_free_assets = maker_it.get_free_limit_quant();
+
+        asset matched_assets, matched_coins;
+        if (is_buy) {
+            // the fee of a coin fee pair is reserved from the free coins, like the frozen coins of an order
+            auto taker_free_coins = buy_coin_fee ? quantity - calc_match_fee(taker_fee_ratio, quantity) : quantity;
+            auto taker_free_assets = calc_asset_quant(taker_free_coins, matched_price, asset_symbol);
+            if (taker_free_assets <= maker_free_assets) {
+                matched_assets = taker_free_assets;
+                matched_coins = taker_free_coins;
+            } else {
+                matched_assets = maker_free_assets;
+                matched_coins = calc_coin_quant(maker_free_assets, matched_price, coin_symbol);
+            }
+            if (matched_assets.amount == 0 || matched_coins.amount == 0) {
+                is_dust = true;
+                break;
+            }
+        } else {
+            matched_assets = (quantity < maker_free_assets) ? quantity : maker_free_assets;
+            matched_coins = calc_coin_quant(matched_assets, matched_price, coin_symbol);
+        }
+
+        asset buy_fee, sell_fee;
+        auto deal_id = _global->new_deal_item_id();
+        if (is_buy) {
+            if (buy_coin_fee) {
+                buy_fee = calc_match_fee(taker_fee_ratio, matched_coins);
+                quantity -= buy_fee;
+                output += matched_assets;
+            } else {
+                buy_fee = calc_match_fee(taker_fee_ratio, matched_assets);
+                output += matched_assets - buy_fee;
+            }
+            quantity -= matched_coins;
+            taker_fees += buy_fee;
+
+            sell_fee = calc_match_fee(maker_order, side, matched_coins);
+            add_balance(get_config().dex_fee_collector, coin_bank, sell_fee, get_self());
+            add_balance(maker_order.owner, coin_bank, matched_coins - sell_fee, get_self());
+            maker_it.match(deal_id, matched_assets, matched_coins, sell_fee);
+        } else {
+            sell_fee = calc_match_fee(taker_fee_ratio, matched_coins);
+            quantity -= matched_assets;
+            output += matched_coins - sell_fee;
+            taker_fees += sell_fee;
+
+            auto buyer_recv_assets = matched_assets;
+            if (maker_order.matched_fee.symbol == coin_symbol) {
+                buy_fee = calc_match_fee(maker_order, side, matched_coins);
+                add_balance(get_config().dex_fee_collector, coin_bank, buy_fee, get_self());
+            } else {
+                buy_fee = calc_match_fee(maker_order, side, matched_assets);
+                buyer_recv_assets -= buy_fee;
+                add_balance(get_config().dex_fee_collector, asset_bank, buy_fee, get_self());
+            }
+            add_balance(maker_order.owner, asset_bank, buyer_recv_assets, get_self());
+            maker_it.match(deal_id, matched_assets, matched_coins, buy_fee);
+        }
+        ASSERT(quantity.amount >= 0);
+
+        asset buy_refund_coins(0, coin_symbol);
+        if (maker_it.is_completed() && !is_buy) {
+            buy_refund_coins = maker_it.get_refund_coins();
+            if (buy_refund_coins.amount > 0) {
+                add_balance(maker_order.owner, coin_bank, buy_refund_coins, get_self());
+            }
+        }
+
+        auto deal_tbl = dex::make_deal_table(get_self());
+        deal_tbl.emplace(user, [&]( auto& deal_item ) {
+            deal_item.id = deal_id;
+            deal_item.sympair_id = sym_pair.sympair_id;
+            // order id 0 is the route taker
+            deal_item.buy_order_id = is_buy ? 0 : maker_order.order_id;
+            deal_item.sell_order_id = is_buy ? maker_order.order_id : 0;
+            deal_item.deal_assets = matched_assets;
+            deal_item.deal_coins = matched_coins;
+            deal_item.deal_price = matched_price;
+            deal_item.taker_side = side;
+            deal_item.buy_fee = buy_fee;
+            deal_item.sell_fee = sell_fee;
+            deal_item.buy_refund_coins = buy_refund_coins;
+            deal_item.memo = "route";
+            deal_item.deal_time = cur_block_time;
+            TRACE_L("The route deal_item=", deal_item);
+        });
+        _counters.on_deal(sym_pair.sympair_id, matched_assets, matched_coins);
+        matched_deals.add_deal(matched_price, matched_assets, matched_coins);
+        matched_count++;
+
+        if (maker_it.is_completed()) {
+            _counters.on_order_completed(sym_pair.sympair_id, maker_order.order_side);
+            maker_it.complete_and_next(order_tbl);
+        }
+    }
+    maker_it.save_matching_order(order_tbl);
+    CHECK( quantity.amount == 0 || is_dust, "The route leg of symbol pair '" + std::to_string(sym_pair.sympair_id) +
+        "' is not fully filled, unfilled quantity=" + quantity.to_string())
+
+    if (taker_fees.amount > 0) {
+        add_balance(get_config().dex_fee_collector, taker_fees.symbol == coin_symbol ? coin_bank : asset_bank, taker_fees, get_self());
+    }
+    if (!matched_deals.empty()) {
+        update_market(sym_pair.sympair_id, matched_deals, time_point_sec(cur_block_time.to_time_point()));
+    }
+    return output;
+}
+
 void dex_contract::match_sympair(const name &matcher, const dex::symbol_pair_t &sym_pair,
                                   uint32_t max_count, uint32_t &matched_count, const string &memo) {
 
@@ -266,7 +496,7 @@ void dex_contract::match_sympair(const name &matcher, const dex::symbol_pair_t &
     auto match_index = order_tbl.get_index<static_cast<name::raw>(order_match_idx::index_name)>();
 
     auto matching_pair_it = dex::matching_pair_iterator(match_index, sym_pair);
-    asset latest_deal_price;
+    dex::candle_t matched_deals;
     while (matched_count < max_count && matching_pair_it.can_match()) {
         auto &maker_it = matching_pair_it.maker_it();
         auto &taker_it = matching_pair_it.taker_it();
@@ -275,7 +505,6 @@ void dex_contract::match_sympair(const name &matcher, const dex::symbol_pair_t &
         TRACE_L("matching maker_order=", taker_it.stored_order());
 
         const auto &matched_price = maker_it.stored_order().price;
-        latest_deal_price = matched_price;
 
         asset matched_coins;
         asset matched_assets;
@@ -302,17 +531,17 @@ void dex_contract::match_sympair(const name &matcher, const dex::symbol_pair_t &
         // transfer the buy_fee from buy_order to dex_fee_collector
         if (matched_coins.symbol == buy_order.matched_fee.symbol) {
             buy_fee = calc_match_fee(buy_order, taker_it.order_side(), matched_coins);
-            add_balance(_config.dex_fee_collector, coin_bank, buy_fee, get_self());
+            add_balance(get_config().dex_fee_collector, coin_bank, buy_fee, get_self());
         } else {
             buy_fee = calc_match_fee(buy_order, taker_it.order_side(), buyer_recv_assets);
             buyer_recv_assets -= buy_fee;
-            add_balance(_config.dex_fee_collector, asset_bank, buy_fee, get_self());
+            add_balance(get_config().dex_fee_collector, asset_bank, buy_fee, get_self());
         }
 
         auto sell_fee = calc_match_fee(sell_order, taker_it.order_side(), seller_recv_coins);
         seller_recv_coins -= sell_fee;
         // transfer the sell_fee from sell_order to dex_fee_collector
-        add_balance(_config.dex_fee_collector, coin_bank, sell_fee, get_self());
+        add_balance(get_config().dex_fee_collector, coin_bank, sell_fee, get_self());
 
         // transfer the coins from buy_order to seller
         add_balance(sell_order.owner, coin_bank, seller_recv_coins, get_self());
@@ -326,6 +555,12 @@ void dex_contract::match_sympair(const name &matcher, const dex::symbol_pair_t &
         sell_it.match(deal_id, matched_assets, matched_coins, sell_fee);
 
         CHECK(buy_it.is_completed() || sell_it.is_completed(), "Neither buy_order nor sell_order is completed");
+        if (buy_it.is_completed()) {
+            _counters.on_order_completed(sym_pair.sympair_id, order_side::BUY);
+        }
+        if (sell_it.is_completed()) {
+            _counters.on_order_completed(sym_pair.sympair_id, order_side::SELL);
+        }
 
         // process refund
         asset buy_refund_coins(0, coin_symbol);
@@ -353,6 +588,8 @@ void dex_contract::match_sympair(const name &matcher, const dex::symbol_pair_t &
             deal_item.deal_time = cur_block_time;
             TRACE_L("The matched deal_item=", deal_item);
         });
+        _counters.on_deal(sym_pair.sympair_id, matched_assets, matched_coins);
+        matched_deals.add_deal(matched_price, matched_assets, matched_coins);
 
 
         matched_count++;
@@ -361,18 +598,582 @@ void dex_contract::match_sympair(const name &matcher, const dex::symbol_pair_t &
 
     matching_pair_it.save_matching_order(order_tbl);
     
-    if (latest_deal_price.amount > 0)
-        update_latest_deal_price(sym_pair.sympair_id, latest_deal_price);
+    if (!matched_deals.empty()) {
+        auto activated_count = update_market(sym_pair.sympair_id, matched_deals, time_point_sec(cur_block_time.to_time_point()));
+
+        // the activated trigger orders are matched in turn, each round needs a new match so it ends
+        // at max_count
+        if (activated_count > 0 && matched_count < max_count) {
+            match_sympair(matcher, sym_pair, max_count, matched_count, memo);
+        }
+    }
 }
 
-void dex_contract::update_latest_deal_price(const uint64_t& sympair_id, const asset& latest_deal_price) {
-    auto sympair_tbl = make_sympair_table(_self);
-    auto it = sympair_tbl.find( sympair_id );
+uint32_t dex_contract::activate_triggers(const dex::symbol_pair_t &sym_pair, const asset &deal_price) {
+    auto trigger_tbl = make_trigger_table(get_self());
+    auto trigger_index = trigger_tbl.get_index<static_cast<name::raw>(trigger_idx::index_name)>();
+    auto order_tbl = make_order_table(get_self());
+    const auto &asset_symbol = sym_pair.asset_symbol.get_symbol();
+    const auto &coin_symbol = sym_pair.coin_symbol.get_symbol();
+    auto cur_block_time = current_block_time();
+
+    uint32_t activated_count = 0;
+    for (bool fire_above : {true, false}) {
+        auto it = trigger_index.lower_bound(make_trigger_idx(sym_pair.sympair_id, fire_above,
+                fire_above ? 0 : std::numeric_limits<uint64_t>::max(), 0));
+        while (activated_count < DEX_TRIGGER_ACTIVATE_MAX && it != trigger_index.end() &&
+               it->sympair_id == sym_pair.sympair_id && it->fire_above() == fire_above &&
+               (fire_above ? deal_price >= it->trigger_price : deal_price <= it->trigger_price)) {
+
+            const auto &trigger = *it;
+            const auto &fee_symbol = (trigger.order_side == dex::order_side::BUY && !sym_pair.only_accept_coin_fee) ?
+                    asset_symbol : coin_symbol;
+            auto order_id = _global->new_order_id();
+            CHECK( order_tbl.find(order_id) == order_tbl.end(), "The order exists: order_id=" + std::to_string(order_id));
+            order_tbl.emplace(get_self(), [&](auto &order) {
+                order.order_id = order_id;
+                order.external_id = trigger.external_id;
+                order.owner = trigger.owner;
+                order.sympair_id = trigger.sympair_id;
+                order.order_type = trigger.order_type;
+                order.order_side = trigger.order_side;
+                order.price = trigger.price;
+                order.limit_quant = trigger.limit_quant;
+                order.frozen_quant = trigger.frozen_quant;
+                order.taker_fee_ratio = trigger.taker_fee_ratio;
+                order.maker_fee_ratio = trigger.maker_fee_ratio;
+                order.matched_assets = asset(0, asset_symbol);
+                order.matched_coins = asset(0, coin_symbol);
+                order.matched_fee = asset(0, fee_symbol);
+                order.status = order_status::MATCHABLE;
+                order.created_at = cur_block_time;
+                order.last_updated_at = cur_block_time;
+                order.last_deal_id = 0;
+            });
+            _counters.on_new_order(sym_pair.sympair_id, trigger.order_side);
+            TRACE_L("Activated trigger order=", trigger.id, " as order=", order_id);
+
+            it = trigger_index.erase(it);
+            activated_count++;
+        }
+    }
+    return activated_count;
+}
+
+void dex_contract::newtrigger(const name &user, const uint64_t &sympair_id,
+                              const name &trigger_type, const asset &trigger_price,
+                              const name &order_type, const name &order_side,
+                              const asset &limit_quant, const asset &price,
+                              const uint64_t &external_id) {
+    CHECK_DEX_ENABLED()
+    CHECK(is_account(user), "Account of user=" + user.to_string() + " does not existed");
+    require_auth(user);
+    if (get_config().admin_sign_required) { require_auth(get_config().dex_admin); }
+
+    auto sympair_tbl = make_sympair_table(get_self());
+    auto sym_pair_it = sympair_tbl.find(sympair_id);
+    CHECK( sym_pair_it != sympair_tbl.end(), "The symbol pair id '" + std::to_string(sympair_id) + "' does not exist")
+    CHECK( sym_pair_it->enabled, "The symbol pair '" + std::to_string(sympair_id) + " is disabled")
+
+    CHECK( trigger_type::is_valid(trigger_type), "Invalid trigger_type=" + trigger_type.to_string())
+    CHECK( order_type::is_valid(order_type), "Invalid order_type=" + order_type.to_string())
+    CHECK( order_side::is_valid(order_side), "Invalid order_side=" + order_side.to_string())
+    CHECK( trigger_price.symbol == sym_pair_it->coin_symbol.get_symbol(), "The trigger_price symbol mismatch with coin_symbol")
+    CHECK( trigger_price.amount > 0, "The trigger_price must > 0")
+    CHECK( !is_auction_sympair(sympair_id) || order_type == dex::order_type::LIMIT,
+        "The symbol pair '" + std::to_string(sympair_id) + "' in auction mode only accepts limit order")
+
+    auto frozen_quant = calc_frozen_quant(*sym_pair_it, order_type, order_side, limit_quant, price, get_config().taker_fee_ratio);
+    name frozen_bank = (order_side == dex::order_side::BUY) ? sym_pair_it->coin_symbol.get_contract() :
+            sym_pair_it->asset_symbol.get_contract();
+    sub_balance(user, frozen_bank, frozen_quant, user);
+
+    auto trigger_tbl = make_trigger_table(get_self());
+    trigger_tbl.emplace(get_self(), [&](auto &trigger) {
+        trigger.id = trigger_tbl.available_primary_key();
+        trigger.external_id = external_id;
+        trigger.owner = user;
+        trigger.sympair_id = sympair_id;
+        trigger.trigger_type = trigger_type;
+        trigger.trigger_price = trigger_price;
+        trigger.order_type = order_type;
+        trigger.order_side = order_side;
+        trigger.limit_quant = limit_quant;
+        trigger.frozen_quant = frozen_quant;
+        trigger.price = price;
+        trigger.taker_fee_ratio = get_config().taker_fee_ratio;
+        trigger.maker_fee_ratio = get_config().maker_fee_ratio;
+        trigger.created_at = current_block_time();
+    });
+}
+
+void dex_contract::canceltrig(const uint64_t &trigger_id) {
+    CHECK_DEX_ENABLED()
+    auto trigger_tbl = make_trigger_table(get_self());
+    auto it = trigger_tbl.find(trigger_id);
+    CHECK(it != trigger_tbl.end(), "The trigger order does not exist or has been activated");
+    require_auth(it->owner);
+
+    auto sympair_tbl = make_sympair_table(get_self());
+    auto sym_pair_it = sympair_tbl.find(it->sympair_id);
+    CHECK( sym_pair_it != sympair_tbl.end(),
+        "The symbol pair id '" + std::to_string(it->sympair_id) + "' does not exist");
+
+    name bank = (it->order_side == order_side::BUY) ? sym_pair_it->coin_symbol.get_contract() :
+            sym_pair_it->asset_symbol.get_contract();
+    add_balance(it->owner, bank, it->frozen_quant, it->owner);
+    trigger_tbl.erase(it);
+}
+
+bool dex_contract::is_auction_sympair(uint64_t sympair_id) {
+    auto auction_tbl = make_auction_table(get_self());
+    auto it = auction_tbl.find(sympair_id);
+    return it != auction_tbl.end() && it->enabled;
+}
+
+void dex_contract::setauction(const uint64_t &sympair_id, const uint32_t &interval_blocks, const bool &enabled) {
+    require_auth( get_config().dex_admin );
+
+    auto sympair_tbl = make_sympair_table(get_self());
+    CHECK( sympair_tbl.find(sympair_id) != sympair_tbl.end(),
+        "The symbol pair id '" + std::to_string(sympair_id) + "' does not exist")
+
+    auto auction_tbl = make_auction_table(get_self());
+    auto it = auction_tbl.find(sympair_id);
+    if (it == auction_tbl.end()) {
+        auction_tbl.emplace(get_self(), [&](auto &auction) {
+            auction.sympair_id = sympair_id;
+            auction.interval_blocks = interval_blocks;
+            auction.enabled = enabled;
+        });
+    } else {
+        auction_tbl.modify(it, same_payer, [&](auto &auction) {
+            auction.interval_blocks = interval_blocks;
+            auction.enabled = enabled;
+        });
+    }
+}
+
+void dex_contract::clear(const name &matcher, const uint64_t &sympair_id, const uint32_t &max_count, const string &memo) {
+    CHECK_DEX_ENABLED()
+    CHECK(is_account(matcher), "The matcher account does not exist");
+    CHECK(max_count > 0, "The max_count must > 0")
+
+    auto sympair_tbl = make_sympair_table(get_self());
+    auto sym_pair_it = sympair_tbl.find(sympair_id);
+    CHECK( sym_pair_it != sympair_tbl.end(), "The symbol pair id '" + std::to_string(sympair_id) + "' does not exist")
+    CHECK( sym_pair_it->enabled, "The symbol pair '" + std::to_string(sympair_id) + " is disabled")
+    const auto &sym_pair = *sym_pair_it;
+
+    auto auction_tbl = make_auction_table(get_self());
+    auto auction_it = auction_tbl.find(sympair_id);
+    CHECK( auction_it != auction_tbl.end() && auction_it->enabled,
+        "The symbol pair '" + std::to_string(sympair_id) + "' is not in auction mode")
+    auto cur_block_time = current_block_time();
+    block_timestamp cur_block(cur_block_time);
+    CHECK( cur_block.slot >= auction_it->last_cleared_at.slot + auction_it->interval_blocks,
+        "The auction of symbol pair '" + std::to_string(sympair_id) + "' can not be cleared before block slot " +
+        std::to_string(auction_it->last_cleared_at.slot + auction_it->interval_blocks))
+
+    auto order_tbl = make_order_table(get_self());
+    auto match_index = order_tbl.get_index<static_cast<name::raw>(order_match_idx::index_name)>();
+    auto price = calc_auction_price(match_index, sym_pair, max_count);
+    CHECK(price.amount > 0, "None matched");
+
+    const auto &asset_symbol = sym_pair.asset_symbol.get_symbol();
+    const auto &coin_symbol = sym_pair.coin_symbol.get_symbol();
+    const auto &asset_bank = sym_pair.asset_symbol.get_contract();
+    const auto &coin_bank = sym_pair.coin_symbol.get_contract();
+
+    // the fills are settled in memory, then each participant gets one balance write per bank
+    struct settlement_t {
+        asset assets;
+        asset coins;
+    };
+    std::map<name, settlement_t> settlements;
+    auto settle = [&](const name &owner) -> settlement_t & {
+        auto it = settlements.find(owner);
+        if (it == settlements.end()) {
+            it = settlements.emplace(owner, settlement_t{asset(0, asset_symbol), asset(0, coin_symbol)}).first;
+        }
+        return it->second;
+    };
+
+    auto buy_it = dex::matching_order_iterator(match_index, sympair_id, order_side::BUY, order_type::LIMIT);
+    auto sell_it = dex::matching_order_iterator(match_index, sympair_id, order_side::SELL, order_type::LIMIT);
+    auto deal_tbl = dex::make_deal_table(get_self());
+    dex::candle_t matched_deals;
+    // every order of the auction is charged as a taker, which its frozen quantity covers
+    const auto &taker_side = order_side::NONE;
+    uint32_t matched_count = 0;
+    while (matched_count < max_count && buy_it.is_valid() && sell_it.is_valid() &&
+           buy_it.stored_order().price >= sell_it.stored_order().price) {
+        const auto &buy_order = buy_it.stored_order();
+        const auto &sell_order = sell_it.stored_order();
+        auto buy_free_assets = buy_it.get_free_limit_quant();
+        auto sell_free_assets = sell_it.get_free_limit_quant();
+        auto matched_assets = (buy_free_assets < sell_free_assets) ? buy_free_assets : sell_free_assets;
+        auto matched_coins = calc_coin_quant(matched_assets, price, coin_symbol);
+
+        auto &buyer = settle(buy_order.owner);
+        auto &seller = settle(sell_order.owner);
+        auto &fee_collector = settle(get_config().dex_fee_collector);
+
+        // the fee symbol of a buy order is fixed when it is placed, as in the continuous matching
+        asset buy_fee;
+        if (buy_order.matched_fee.symbol == coin_symbol) {
+            buy_fee = calc_match_fee(buy_order.taker_fee_ratio, matched_coins);
+            fee_collector.coins += buy_fee;
+            buyer.assets += matched_assets;
+        } else {
+            buy_fee = calc_match_fee(buy_order.taker_fee_ratio, matched_assets);
+            fee_collector.assets += buy_fee;
+            buyer.assets += matched_assets - buy_fee;
+        }
+        auto sell_fee = calc_match_fee(sell_order.taker_fee_ratio, matched_coins);
+        fee_collector.coins += sell_fee;
+        seller.coins += matched_coins - sell_fee;
+
+        auto deal_id = _global->new_deal_item_id();
+        buy_it.match(deal_id, matched_assets, matched_coins, buy_fee);
+        sell_it.match(deal_id, matched_assets, matched_coins, sell_fee);
+
+        asset buy_refund_coins(0, coin_symbol);
+        if (buy_it.is_completed()) {
+            buy_refund_coins = buy_it.get_refund_coins();
+            buyer.coins += buy_refund_coins;
+        }
+
+        // one deal item per matched pair, so cleandata finds the orders completed by the auction
+        deal_tbl.emplace(matcher, [&]( auto& deal_item ) {
+            deal_item.id = deal_id;
+            deal_item.sympair_id = sympair_id;
+            deal_item.buy_order_id = buy_order.order_id;
+            deal_item.sell_order_id = sell_order.order_id;
+            deal_item.deal_assets = matched_assets;
+            deal_item.deal_coins = matched_coins;
+            deal_item.deal_price = price;
+            deal_item.taker_side = taker_side;
+            deal_item.buy_fee = buy_fee;
+            deal_item.sell_fee = sell_fee;
+            deal_item.buy_refund_coins = buy_refund_coins;
+            deal_item.memo = memo;
+            deal_item.deal_time = cur_block_time;
+            TRACE_L("The auction deal_item=", deal_item);
+        });
+        _counters.on_deal(sympair_id, matched_assets, matched_coins);
+        matched_deals.add_deal(price, matched_assets, matched_coins);
+        matched_count++;
+
+        if (buy_it.is_completed()) {
+            _counters.on_order_completed(sympair_id, order_side::BUY);
+            buy_it.complete_and_next(order_tbl);
+        }
+        if (sell_it.is_completed()) {
+            _counters.on_order_completed(sympair_id, order_side::SELL);
+            sell_it.complete_and_next(order_tbl);
+        }
+    }
+    buy_it.save_matching_order(order_tbl);
+    sell_it.save_matching_order(order_tbl);
+
+    for (const auto &item : settlements) {
+        if (item.second.assets.amount > 0) add_balance(item.first, asset_bank, item.second.assets, get_self());
+        if (item.second.coins.amount > 0) add_balance(item.first, coin_bank, item.second.coins, get_self());
+    }
+
+    auction_tbl.modify(auction_it, same_payer, [&](auto &auction) {
+        auction.last_cleared_at = cur_block;
+    });
+
+    if (!matched_deals.empty()) {
+        update_market(sympair_id, matched_deals, time_point_sec(cur_block_time.to_time_point()));
+    }
+}
+
+uint32_t dex_contract::update_market(const uint64_t &sympair_id, const dex::candle_t &deals, const time_point_sec &now) {
+    auto sympair_tbl = make_sympair_table(get_self());
+    auto it = sympair_tbl.find(sympair_id);
     CHECK( it != sympair_tbl.end(), "Err: sympair not found" )
 
+    // the latest deal price, time and the open candles are in the sympair row, so a match writes it once
     sympair_tbl.modify(*it, same_payer, [&](auto &row) {
-        row.latest_deal_price = latest_deal_price;
+        row.latest_deal_price = asset(deals.close, row.coin_symbol.get_symbol());
+        if (!row.market.has_value()) {
+            row.market.emplace();
+        }
+        auto &market = row.market.value();
+        market.latest_deal_time = now;
+        market.candles.resize(std::size(CANDLE_INTERVALS));
+        for (size_t i = 0; i < std::size(CANDLE_INTERVALS); i++) {
+            const auto &interval = CANDLE_INTERVALS[i];
+            auto &candle = market.candles[i];
+            auto start = time_point_sec(now.sec_since_epoch() / interval.seconds * interval.seconds);
+            if (!candle.empty() && candle.start != start) {
+                save_candle(sympair_id, interval, candle);
+                candle = dex::candle_t();
+            }
+            candle.start = start;
+            candle.merge(deals);
+        }
+    });
+
+    // every path that moves the latest deal price fires the trigger orders it crosses, the activated
+    // orders are matched by match_sympair or wait for the next match
+    return activate_triggers(*it, it->latest_deal_price);
+}
+
+void dex_contract::save_candle(uint64_t sympair_id, const dex::candle_interval_t &interval, const dex::candle_t &candle) {
+    auto candle_tbl = make_candle_table(get_self(), sympair_id);
+    auto bucket = candle.start.sec_since_epoch() / interval.seconds;
+    auto slot = make_candle_slot(interval.seconds, bucket % interval.slots);
+    auto it = candle_tbl.find(slot);
+    if (it == candle_tbl.end()) {
+        candle_tbl.emplace(get_self(), [&](auto &row) {
+            row.slot = slot;
+            row.candle = candle;
+        });
+    } else {
+        candle_tbl.modify(it, same_payer, [&](auto &row) {
+            row.candle = candle;
+        });
+    }
+}
+
+void dex_contract::setpool(const uint64_t &sympair_id, const int64_t &fee_ratio, const bool &enabled) {
+    require_auth( get_config().dex_admin );
+    validate_fee_ratio(fee_ratio, "fee_ratio");
+
+    auto sympair_tbl = make_sympair_table(get_self());
+    auto sym_pair_it = sympair_tbl.find(sympair_id);
+    CHECK( sym_pair_it != sympair_tbl.end(), "The symbol pair id '" + std::to_string(sympair_id) + "' does not exist")
+
+    auto pool_tbl = make_pool_table(get_self());
+    auto pool_it = pool_tbl.find(sympair_id);
+    if (pool_it == pool_tbl.end()) {
+        pool_tbl.emplace(get_self(), [&](auto &pool) {
+            pool.sympair_id = sympair_id;
+            pool.asset_reserve = asset(0, sym_pair_it->asset_symbol.get_symbol());
+            pool.coin_reserve = asset(0, sym_pair_it->coin_symbol.get_symbol());
+            pool.fee_ratio = fee_ratio;
+            pool.enabled = enabled;
+        });
+    } else {
+        pool_tbl.modify(pool_it, same_payer, [&](auto &pool) {
+            pool.fee_ratio = fee_ratio;
+            pool.enabled = enabled;
+        });
+    }
+}
+
+void dex_contract::addliquidity(const name &user, const uint64_t &sympair_id,
+                                const asset &asset_quant, const asset &coin_quant) {
+    CHECK_DEX_ENABLED()
+    require_auth(user);
+
+    auto sympair_tbl = make_sympair_table(get_self());
+    auto sym_pair_it = sympair_tbl.find(sympair_id);
+    CHECK( sym_pair_it != sympair_tbl.end(), "The symbol pair id '" + std::to_string(sympair_id) + "' does not exist")
+
+    auto pool_tbl = make_pool_table(get_self());
+    auto pool_it = pool_tbl.find(sympair_id);
+    CHECK( pool_it != pool_tbl.end(), "The pool of symbol pair '" + std::to_string(sympair_id) + "' does not exist")
+    CHECK( pool_it->enabled, "The pool of symbol pair '" + std::to_string(sympair_id) + "' is disabled")
+    CHECK( asset_quant.symbol == pool_it->asset_reserve.symbol, "The asset_quant symbol mismatch with asset_symbol")
+    CHECK( coin_quant.symbol == pool_it->coin_reserve.symbol, "The coin_quant symbol mismatch with coin_symbol")
+    CHECK( asset_quant.amount > 0 && coin_quant.amount > 0, "The liquidity quantities must > 0")
+
+    uint64_t shares = 0;
+    asset used_assets = asset_quant;
+    asset used_coins = coin_quant;
+    if (pool_it->total_shares == 0) {
+        shares = isqrt(uint128_t(asset_quant.amount) * coin_quant.amount);
+    } else {
+        const auto &pool = *pool_it;
+        ASSERT(pool.asset_reserve.amount > 0 && pool.coin_reserve.amount > 0);
+        auto total_shares = int64_t(pool.total_shares);
+        shares = std::min(mul_div_floor(asset_quant.amount, total_shares, pool.asset_reserve.amount),
+                          mul_div_floor(coin_quant.amount, total_shares, pool.coin_reserve.amount));
+        // round up the deposits so that the shares are never worth more than the deposits
+        used_assets.amount = mul_div_ceil(shares, pool.asset_reserve.amount, total_shares);
+        used_coins.amount = mul_div_ceil(shares, pool.coin_reserve.amount, total_shares);
+        ASSERT(used_assets <= asset_quant && used_coins <= coin_quant);
+    }
+    CHECK( shares > 0, "The liquidity is too small to get shares")
+
+    sub_balance(user, sym_pair_it->asset_symbol.get_contract(), used_assets, user);
+    sub_balance(user, sym_pair_it->coin_symbol.get_contract(), used_coins, user);
+
+    pool_tbl.modify(pool_it, same_payer, [&](auto &pool) {
+        pool.asset_reserve += used_assets;
+        pool.coin_reserve += used_coins;
+        pool.total_shares += shares;
+    });
+
+    auto share_tbl = make_lp_share_table(get_self(), sympair_id);
+    auto share_it = share_tbl.find(user.value);
+    if (share_it == share_tbl.end()) {
+        share_tbl.emplace(user, [&](auto &row) {
+            row.owner = user;
+            row.shares = shares;
+        });
+    } else {
+        share_tbl.modify(share_it, same_payer, [&](auto &row) {
+            row.shares += shares;
+        });
+    }
+}
+
+void dex_contract::rmliquidity(const name &user, const uint64_t &sympair_id, const uint64_t &shares) {
+    CHECK_DEX_ENABLED()
+    require_auth(user);
+
+    auto sympair_tbl = make_sympair_table(get_self());
+    auto sym_pair_it = sympair_tbl.find(sympair_id);
+    CHECK( sym_pair_it != sympair_tbl.end(), "The symbol pair id '" + std::to_string(sympair_id) + "' does not exist")
+
+    auto pool_tbl = make_pool_table(get_self());
+    auto pool_it = pool_tbl.find(sympair_id);
+    CHECK( pool_it != pool_tbl.end(), "The pool of symbol pair '" + std::to_string(sympair_id) + "' does not exist")
+
+    auto share_tbl = make_lp_share_table(get_self(), sympair_id);
+    auto share_it = share_tbl.find(user.value);
+    CHECK( share_it != share_tbl.end(), "The user=" + user.to_string() + " has no shares of the pool")
+    CHECK( shares > 0 && shares <= share_it->shares, "The shares out of range [1, " + std::to_string(share_it->shares) + "]")
+
+    const auto &pool = *pool_it;
+    ASSERT(shares <= pool.total_shares);
+    auto total_shares = int64_t(pool.total_shares);
+    asset out_assets(mul_div_floor(shares, pool.asset_reserve.amount, total_shares), pool.asset_reserve.symbol);
+    asset out_coins(mul_div_floor(shares, pool.coin_reserve.amount, total_shares), pool.coin_reserve.symbol);
+
+    pool_tbl.modify(pool_it, same_payer, [&](auto &pool) {
+        pool.asset_reserve -= out_assets;
+        pool.coin_reserve -= out_coins;
+        pool.total_shares -= shares;
+    });
+
+    if (share_it->shares == shares) {
+        share_tbl.erase(share_it);
+    } else {
+        share_tbl.modify(share_it, same_payer, [&](auto &row) {
+            row.shares -= shares;
+        });
+    }
+
+    if (out_assets.amount > 0)
+        add_balance(user, sym_pair_it->asset_symbol.get_contract(), out_assets, user);
+    if (out_coins.amount > 0)
+        add_balance(user, sym_pair_it->coin_symbol.get_contract(), out_coins, user);
+}
+
+bool dex_contract::match_pool(const dex::symbol_pair_t &sym_pair, dex::order_tbl &order_tbl, const dex::order_t &order) {
+    auto pool_tbl = make_pool_table(get_self());
+    auto pool_it = pool_tbl.find(sym_pair.sympair_id);
+    if (pool_it == pool_tbl.end() || !pool_it->enabled || pool_it->total_shares == 0) return false;
+
+    const auto &asset_symbol = sym_pair.asset_symbol.get_symbol();
+    const auto &coin_symbol = sym_pair.coin_symbol.get_symbol();
+    const auto &asset_bank = sym_pair.asset_symbol.get_contract();
+    const auto &coin_bank = sym_pair.coin_symbol.get_contract();
+    bool is_buy = order.order_side == order_side::BUY;
+
+    // the pool fills the whole market order: a buy order pays limit_quant coins, a sell order pays
+    // limit_quant assets. The lp fee is taken from the input and stays in the reserves
+    const auto &inp_reserve = is_buy ? pool_it->coin_reserve : pool_it->asset_reserve;
+    const auto &out_reserve = is_buy ? pool_it->asset_reserve : pool_it->coin_reserve;
+    auto lp_fee = calc_match_fee(pool_it->fee_ratio, order.limit_quant);
+    asset pool_out(get_bancor_output(inp_reserve.amount, out_reserve.amount, (order.limit_quant - lp_fee).amount),
+                   out_reserve.symbol);
+    if (pool_out.amount == 0) return false;
+
+    // the book wins if its best price gives at least as much as the pool
+    auto match_index = order_tbl.get_index<static_cast<name::raw>(order_match_idx::index_name)>();
+    auto best_it = dex::matching_order_iterator(match_index, sym_pair.sympair_id,
+            is_buy ? order_side::SELL : order_side::BUY, order_type::LIMIT);
+    if (best_it.is_valid()) {
+        const auto &best_price = best_it.stored_order().price;
+        auto book_out = is_buy ? calc_asset_quant(order.limit_quant, best_price, asset_symbol)
+                               : calc_coin_quant(order.limit_quant, best_price, coin_symbol);
+        if (pool_out <= book_out) return false;
+    }
+
+    asset matched_assets = is_buy ? pool_out : order.limit_quant;
+    asset matched_coins = is_buy ? order.limit_quant : pool_out;
+    asset taker_fee;
+    asset buy_refund_coins(0, coin_symbol);
+    if (is_buy) {
+        asset buyer_recv_assets = matched_assets;
+        buy_refund_coins = order.frozen_quant - matched_coins;
+        if (order.matched_fee.symbol == coin_symbol) {
+            taker_fee = calc_match_fee(order.taker_fee_ratio, matched_coins);
+            buy_refund_coins -= taker_fee;
+            add_balance(get_config().dex_fee_collector, coin_bank, taker_fee, get_self());
+        } else {
+            taker_fee = calc_match_fee(order.taker_fee_ratio, buyer_recv_assets);
+            buyer_recv_assets -= taker_fee;
+            add_balance(get_config().dex_fee_collector, asset_bank, taker_fee, get_self());
+        }
+        add_balance(order.owner, asset_bank, buyer_recv_assets, get_self());
+        ASSERT(buy_refund_coins.amount >= 0);
+        if (buy_refund_coins.amount > 0) {
+            add_balance(order.owner, coin_bank, buy_refund_coins, get_self());
+        }
+    } else {
+        asset seller_recv_coins = matched_coins;
+        taker_fee = calc_match_fee(order.taker_fee_ratio, seller_recv_coins);
+        seller_recv_coins -= taker_fee;
+        add_balance(get_config().dex_fee_collector, coin_bank, taker_fee, get_self());
+        add_balance(order.owner, coin_bank, seller_recv_coins, get_self());
+    }
+
+    pool_tbl.modify(pool_it, same_payer, [&](auto &pool) {
+        if (is_buy) {
+            pool.coin_reserve += order.limit_quant;
+            pool.asset_reserve -= pool_out;
+        } else {
+            pool.asset_reserve += order.limit_quant;
+            pool.coin_reserve -= pool_out;
+        }
     });
+
+    auto cur_block_time = current_block_time();
+    auto deal_id = _global->new_deal_item_id();
+    order_tbl.modify(order, same_payer, [&](auto &a) {
+        a.matched_assets = matched_assets;
+        a.matched_coins = matched_coins;
+        a.matched_fee = taker_fee;
+        a.status = order_status::COMPLETED;
+        a.last_updated_at = cur_block_time;
+        a.last_deal_id = deal_id;
+    });
+    _counters.on_order_completed(sym_pair.sympair_id, order.order_side);
+
+    auto deal_price = calc_deal_price(matched_assets, matched_coins);
+    auto deal_tbl = dex::make_deal_table(get_self());
+    deal_tbl.emplace(get_self(), [&]( auto& deal_item ) {
+        deal_item.id = deal_id;
+        deal_item.sympair_id = sym_pair.sympair_id;
+        // order id 0 is the pool
+        deal_item.buy_order_id = is_buy ? order.order_id : 0;
+        deal_item.sell_order_id = is_buy ? 0 : order.order_id;
+        deal_item.deal_assets = matched_assets;
+        deal_item.deal_coins = matched_coins;
+        deal_item.deal_price = deal_price;
+        deal_item.taker_side = order.order_side;
+        deal_item.buy_fee = is_buy ? taker_fee : asset(0, order.matched_fee.symbol);
+        deal_item.sell_fee = is_buy ? asset(0, coin_symbol) : taker_fee;
+        deal_item.buy_refund_coins = buy_refund_coins;
+        deal_item.memo = "pool";
+        deal_item.deal_time = cur_block_time;
+        TRACE_L("The pool deal_item=", deal_item);
+    });
+    _counters.on_deal(sym_pair.sympair_id, matched_assets, matched_coins);
+
+    dex::candle_t deals;
+    deals.add_deal(deal_price, matched_assets, matched_coins);
+    update_market(sym_pair.sympair_id, deals, time_point_sec(cur_block_time.to_time_point()));
+    return true;
 }
 
 void dex_contract::version() {
@@ -416,8 +1217,16 @@ void dex_contract::new_order(const name &user, const uint64_t &sympair_id, const
     CHECK_DEX_ENABLED()
     CHECK(is_account(user), "Account of user=" + user.to_string() + " does not existed");
     require_auth(user);
-    if (_config.admin_sign_required || order_config_ex) { require_auth(_config.dex_admin); }
+    if (get_config().admin_sign_required || order_config_ex) { require_auth(get_config().dex_admin); }
+
+    place_order(user, sympair_id, order_type, order_side, limit_quant, price, external_id, order_config_ex);
+}
 
+void dex_contract::place_order(const name &user, const uint64_t &sympair_id, const name &order_type,
+                               const name &order_side, const asset &limit_quant,
+                               const optional<asset> &price,
+                               const uint64_t &external_id,
+                               const optional<dex::order_config_ex_t> &order_config_ex) {
     auto sympair_tbl = make_sympair_table(get_self());
     auto sym_pair_it = sympair_tbl.find(sympair_id);
     CHECK( sym_pair_it != sympair_tbl.end(), "The symbol pair id '" + std::to_string(sympair_id) + "' does not exist")
@@ -426,8 +1235,8 @@ void dex_contract::new_order(const name &user, const uint64_t &sympair_id, const
     const auto &asset_symbol = sym_pair_it->asset_symbol.get_symbol();
     const auto &coin_symbol = sym_pair_it->coin_symbol.get_symbol();
 
-    auto taker_fee_ratio = _config.taker_fee_ratio;
-    auto maker_fee_ratio = _config.maker_fee_ratio;
+    auto taker_fee_ratio = get_config().taker_fee_ratio;
+    auto maker_fee_ratio = get_config().maker_fee_ratio;
     if (order_config_ex) {
         taker_fee_ratio = order_config_ex->taker_fee_ratio;
         maker_fee_ratio = order_config_ex->maker_fee_ratio;
@@ -435,43 +1244,11 @@ void dex_contract::new_order(const name &user, const uint64_t &sympair_id, const
         validate_fee_ratio(maker_fee_ratio, "ratio");
     }
 
-    // check price
-    if (price) {
-        CHECK(price->symbol == coin_symbol, "The price symbol mismatch with coin_symbol")
-        if (order_type == dex::order_type::LIMIT) {
-            CHECK( price->amount > 0, "The price must > 0 for limit order")
-        } else { // order.order_type == dex::order_type::LIMIT
-            CHECK( price->amount == 0, "The price must == 0 for market order")
-        }
-    }
+    bool in_auction = is_auction_sympair(sympair_id);
+    CHECK( !in_auction || order_type == dex::order_type::LIMIT,
+        "The symbol pair '" + std::to_string(sympair_id) + "' in auction mode only accepts limit order")
 
-    asset frozen_quant;
-    if (order_side == dex::order_side::BUY) {
-        if (order_type == dex::order_type::LIMIT) {
-            CHECK( limit_quant.symbol == asset_symbol,
-                    "The limit_symbol=" + symbol_to_string(limit_quant.symbol) +
-                        " mismatch with asset_symbol=" + symbol_to_string(asset_symbol) +
-                        " for limit buy order");
-            ASSERT(price.has_value());
-            frozen_quant = dex::calc_coin_quant(limit_quant, *price, coin_symbol);
-        } else {// order_type == order_type::MARKET
-            CHECK(limit_quant.symbol == coin_symbol,
-                    "The limit_symbol=" + symbol_to_string(limit_quant.symbol) +
-                        " mismatch with coin_symbol=" + symbol_to_string(coin_symbol) +
-                        " for market buy order");
-            frozen_quant = limit_quant;
-        }
-        if (sym_pair_it->only_accept_coin_fee) {
-            frozen_quant += dex::calc_match_fee(taker_fee_ratio, frozen_quant);
-        }
-
-    } else { // order_side == order_side::SELL
-        CHECK( limit_quant.symbol == asset_symbol,
-                "The limit_symbol=" + symbol_to_string(limit_quant.symbol) +
-                    " mismatch with asset_symbol=" + symbol_to_string(asset_symbol) +
-                    " for sell order");
-        frozen_quant = limit_quant;
-    }
+    auto frozen_quant = calc_frozen_quant(*sym_pair_it, order_type, order_side, limit_quant, price, taker_fee_ratio);
 
     auto order_tbl = make_order_table(get_self());
 
@@ -482,7 +1259,7 @@ void dex_contract::new_order(const name &user, const uint64_t &sympair_id, const
     CHECK( order_tbl.find(order_id) == order_tbl.end(), "The order exists: order_id=" + std::to_string(order_id));
 
     auto cur_block_time = current_block_time();
-    order_tbl.emplace(get_self(), [&](auto &order) {
+    auto order_it = order_tbl.emplace(get_self(), [&](auto &order) {
         order.order_id = order_id;
         order.external_id = external_id;
         order.owner = user;
@@ -507,11 +1284,61 @@ void dex_contract::new_order(const name &user, const uint64_t &sympair_id, const
     name frozen_bank = (order_side == dex::order_side::BUY) ? sym_pair_it->coin_symbol.get_contract() :
             sym_pair_it->asset_symbol.get_contract();
 
+    _counters.on_new_order(sympair_id, order_side);
+
     sub_balance(user, frozen_bank, frozen_quant, user);
 
-    if (_config.max_match_count > 0) {
+    if (order_type == dex::order_type::MARKET) {
+        match_pool(*sym_pair_it, order_tbl, *order_it);
+    }
+
+    if (get_config().max_match_count > 0 && !in_auction) {
         uint32_t matched_count = 0;
-        match_sympair(get_self(), *sym_pair_it, _config.max_match_count, matched_count, "oid:" + std::to_string(order_id));
+        match_sympair(get_self(), *sym_pair_it, get_config().max_match_count, matched_count, "oid:" + std::to_string(order_id));
+    }
+}
+
+void dex_contract::setrelaykey(const name &user, const public_key &pubkey) {
+    CHECK_DEX_ENABLED()
+    require_auth(user);
+
+    auto relay_tbl = make_relay_account_table(get_self());
+    auto it = relay_tbl.find(user.value);
+    if (it == relay_tbl.end()) {
+        relay_tbl.emplace(user, [&](auto &a) {
+            a.user = user;
+            a.pubkey = pubkey;
+        });
+    } else {
+        // the nonce is kept, so the orders signed by the old key can not be replayed
+        relay_tbl.modify(it, same_payer, [&](auto &a) {
+            a.pubkey = pubkey;
+        });
+    }
+}
+
+void dex_contract::relayorders(const vector<dex::relay_order_t> &orders) {
+    CHECK_DEX_ENABLED()
+    require_auth(get_config().dex_admin);
+    CHECK(!orders.empty(), "The orders is empty");
+    CHECK( is_account(get_config().dex_fee_collector), "The dex_fee_collector account does not exist");
+
+    auto relay_tbl = make_relay_account_table(get_self());
+    const auto chain_id = get_chain_id();
+    for (const auto &order : orders) {
+        // the same account check as new_order, the signature does not prove the owner exists
+        CHECK(is_account(order.user), "Account of user=" + order.user.to_string() + " does not existed");
+        auto it = relay_tbl.find(order.user.value);
+        CHECK(it != relay_tbl.end(), "The relay key of user=" + order.user.to_string() + " does not exist");
+        CHECK(order.nonce > it->nonce, "The nonce=" + std::to_string(order.nonce) + " of user=" + order.user.to_string() +
+              " must > the last nonce=" + std::to_string(it->nonce));
+        assert_recover_key(make_relay_order_digest(chain_id, get_self(), order), order.sig, it->pubkey);
+        relay_tbl.modify(it, same_payer, [&](auto &a) {
+            a.nonce = order.nonce;
+        });
+
+        place_order(order.user, order.sympair_id, order.order_type, order.order_side, order.limit_quant,
+                    order.price, order.external_id, nullopt);
     }
 }
 
@@ -533,6 +1360,7 @@ void dex_contract::add_balance(const name &user, const name &bank, const asset &
             a.balance.contract = bank;
             a.balance.quantity = quantity;
         });
+        _counters.on_balance_created();
     } else {
         TRACE_L("add balance. id=", it->id, ", account=", user.to_string(), ", bank=", bank.to_string(),
             ", quantity=", quantity);
@@ -576,7 +1404,7 @@ void dex_contract::selllimit(const name &user, const uint64_t &sympair_id, const
 bool dex_contract::check_data_outdated(const time_point &data_time, const time_point &now) {
     ASSERT(now.sec_since_epoch() >= data_time.sec_since_epoch());
     uint64_t sec = now.sec_since_epoch() - data_time.sec_since_epoch();
-    return sec > _config.data_recycle_sec;
+    return sec > get_config().data_recycle_sec;
 }
 
 void dex_contract::cleandata(const uint64_t &max_count) {
@@ -609,6 +1437,7 @@ void dex_contract::cleandata(const uint64_t &max_count) {
             related_count++;
         }
         TRACE_L("Erase deal_item=", deal_it->id);
+        _counters.on_deal_erased(deal_it->sympair_id);
         deal_it = deal_tbl.erase(deal_it);
         count++;
     }
@@ -638,3 +1467,47 @@ void dex_contract::cleandata(const uint64_t &max_count) {
     CHECK(count > 0, "No data to be cleaned");
     TRACE_L("Found and erased item count=", count, ", related_count=", related_count);
 }
+
+void dex_contract::snapshot(const uint64_t &sympair_id, const optional<dex::book_cursor_t> &cursor,
+                            const uint32_t &max_count) {
+    CHECK(max_count > 0 && max_count <= DEX_SNAPSHOT_COUNT_MAX,
+          "The max_count must be in range [1, " + std::to_string(DEX_SNAPSHOT_COUNT_MAX) + "]")
+    auto sympair_tbl = make_sympair_table(get_self());
+    CHECK( sympair_tbl.find(sympair_id) != sympair_tbl.end(),
+        "The symbol pair id '" + std::to_string(sympair_id) + "' does not exist")
+
+    auto order_tbl = make_order_table(get_self());
+    auto match_index = order_tbl.get_index<static_cast<name::raw>(order_match_idx::index_name)>();
+    // the matchable orders of sym_pair are contiguous in the match index, from the smallest side and type
+    auto it = cursor ?
+        match_index.lower_bound(make_order_match_idx(sympair_id, order_status::MATCHABLE, cursor->order_side,
+                                                     cursor->order_type, cursor->price, cursor->order_id + 1)) :
+        match_index.lower_bound(make_order_match_idx(sympair_id, order_status::MATCHABLE, order_side_t(),
+                                                     order_type_t(), 0, 0));
+    auto is_open = [&]() {
+        return it != match_index.end() && it->sympair_id == sympair_id && it->status == order_status::MATCHABLE;
+    };
+
+    uint64_t last_deal_id = _global->last_deal_item_id();
+    uint32_t count = 0;
+    do {
+        vector<dex::book_order_t> orders;
+        for (; is_open() && count < max_count && orders.size() < DEX_SNAPSHOT_CHUNK_SIZE; ++it, ++count) {
+            orders.push_back({it->order_id, it->owner, it->order_type, it->order_side, it->price.amount,
+                              it->limit_quant.amount, it->matched_assets.amount, it->matched_coins.amount});
+        }
+        optional<dex::book_cursor_t> next_cursor;
+        if (is_open()) {
+            const auto &last = orders.back();
+            next_cursor = dex::book_cursor_t{last.order_side, last.order_type, uint64_t(last.price), last.order_id};
+        }
+        bookchunk_action bookchunk_act{get_self(), {get_self(), "active"_n}};
+        bookchunk_act.send(sympair_id, last_deal_id, orders, next_cursor);
+    } while (is_open() && count < max_count);
+}
+
+void dex_contract::bookchunk(const uint64_t & /* sympair_id */, const uint64_t & /* last_deal_id */,
+                             const vector<dex::book_order_t> & /* orders */,
+                             const optional<dex::book_cursor_t> & /* next_cursor */) {
+    require_auth(get_self());
+}
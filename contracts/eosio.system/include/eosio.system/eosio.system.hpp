@@ -12,6 +12,7 @@
 #include <eosio.system/native.hpp>
 
 #include <deque>
+#include <map>
 #include <optional>
 #include <string>
 #include <type_traits>
@@ -71,6 +72,7 @@ namespace eosiosystem {
    static constexpr int64_t  ram_gift_bytes        = 1400;
    static constexpr int64_t  min_pervote_daily_pay = 100'0000;
    static constexpr uint32_t refund_delay_sec      = 3 * seconds_per_day;
+   static constexpr uint32_t max_onboard_receivers = 50;    // bounds the rows written by one onboard action
 
    static constexpr int64_t  inflation_precision           = 100;     // 2 decimals
    static constexpr int64_t  default_annual_rate           = 500;     // 5% annual rate
@@ -121,6 +123,14 @@ namespace eosiosystem {
 
    typedef eosio::multi_index< "bidrefunds"_n, bid_refund > bid_refund_table;
 
+   // The blocks produced by a producer of the current round which are not yet added to its `producer_info` row
+   struct producer_round_blocks {
+      name           producer;
+      uint32_t       unpaid_blocks = 0;
+
+      EOSLIB_SERIALIZE( producer_round_blocks, (producer)(unpaid_blocks) )
+   };
+
    // Defines new global state parameters.
    struct [[eosio::table("global"), eosio::contract("eosio.system")]] eosio_global_state : eosio::blockchain_parameters {
       uint64_t free_ram()const { return max_ram_size - total_ram_bytes_reserved; }
@@ -139,13 +149,17 @@ namespace eosiosystem {
       uint16_t             last_producer_schedule_size = 0;
       double               total_producer_vote_weight = 0; /// the sum of all producer votes
       block_timestamp      last_name_close;
+      /// the blocks of the current round in production order, added to the producer rows once a minute and at claimrewards
+      eosio::binary_extension< std::vector<producer_round_blocks> > round_unpaid_blocks;
+      /// ram fees collected in eosio.ramfee and not yet channeled to REX, transferred by runrex
+      eosio::binary_extension<int64_t> ram_fee_proceeds;
 
       // explicit serialization macro is not necessary, used here only to improve compilation time
       EOSLIB_SERIALIZE_DERIVED( eosio_global_state, eosio::blockchain_parameters,
                                 (max_ram_size)(total_ram_bytes_reserved)(total_ram_stake)
                                 (last_producer_schedule_update)(last_pervote_bucket_fill)
                                 (pervote_bucket)(perblock_bucket)(total_unpaid_blocks)(total_activated_stake)(thresh_activated_stake_time)
-                                (last_producer_schedule_size)(total_producer_vote_weight)(last_name_close) )
+                                (last_producer_schedule_size)(total_producer_vote_weight)(last_name_close)(round_unpaid_blocks)(ram_fee_proceeds) )
    };
 
    // Defines new global state parameters added after version 1.0
@@ -157,9 +171,10 @@ namespace eosiosystem {
       block_timestamp   last_block_num; /* deprecated */
       double            total_producer_votepay_share = 0;
       uint8_t           revision = 0; ///< used to track version updates in the future.
+      eosio::binary_extension<eosio::checksum256> last_proposed_schedule_hash; ///< sha256 of the packed producers of the last proposed schedule
 
       EOSLIB_SERIALIZE( eosio_global_state2, (new_ram_per_block)(last_ram_increase)(last_block_num)
-                        (total_producer_votepay_share)(revision) )
+                        (total_producer_votepay_share)(revision)(last_proposed_schedule_hash) )
    };
 
    // Defines new global state parameters added after version 1.3.0
@@ -167,8 +182,9 @@ namespace eosiosystem {
       eosio_global_state3() { }
       time_point        last_vpay_state_update;
       double            total_vpay_share_change_rate = 0;
+      eosio::binary_extension<name> next_vote_refresh; ///< the voter the next refreshvotes call starts at
 
-      EOSLIB_SERIALIZE( eosio_global_state3, (last_vpay_state_update)(total_vpay_share_change_rate) )
+      EOSLIB_SERIALIZE( eosio_global_state3, (last_vpay_state_update)(total_vpay_share_change_rate)(next_vote_refresh) )
    };
 
    // Defines new global state parameters to store inflation rate and distribution
@@ -322,6 +338,43 @@ namespace eosiosystem {
 
    typedef eosio::singleton< "global4"_n, eosio_global_state4 > global_state4_singleton;
 
+   /**
+    * A global singleton of the system contract, read on the first access. Only the state returned
+    * by modify() is written back, by save().
+    */
+   template<typename Singleton, typename T>
+   class lazy_global_state {
+      public:
+         lazy_global_state( name contract, T (*make_default)() = nullptr )
+         :_singleton( contract, contract.value ), _make_default( make_default ) {}
+
+         const T& get() {
+            if( !_state ) {
+               _state = _singleton.get_or_default( _make_default ? _make_default() : T{} );
+            }
+            return *_state;
+         }
+
+         T& modify() {
+            get();
+            _changed = true;
+            return *_state;
+         }
+
+         void save( name payer ) {
+            if( _changed ) {
+               _singleton.set( *_state, payer );
+               _changed = false;
+            }
+         }
+
+      private:
+         Singleton           _singleton;
+         T                   (*_make_default)();
+         std::optional<T>    _state;
+         bool                _changed = false;
+   };
+
    struct [[eosio::table, eosio::contract("eosio.system")]] user_resources {
       name          owner;
       asset         net_weight;
@@ -368,6 +421,25 @@ namespace eosiosystem {
    typedef eosio::multi_index< "delband"_n, delegated_bandwidth > del_bandwidth_table;
    typedef eosio::multi_index< "refunds"_n, refund_request >      refunds_table;
 
+   // `refund_queue_entry` structure underlying the refund queue table, a global index of the refund
+   // requests by time, paid out by `runrefunds` once they mature. A refund queue entry is defined by:
+   // - `owner` the owner of the refund request,
+   // - `request_time` the request time of the refund request.
+   struct [[eosio::table, eosio::contract("eosio.system")]] refund_queue_entry {
+      name            owner;
+      time_point_sec  request_time;
+
+      uint64_t  primary_key()const     { return owner.value; }
+      uint64_t  by_request_time()const { return request_time.utc_seconds; }
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( refund_queue_entry, (owner)(request_time) )
+   };
+
+   typedef eosio::multi_index< "refundq"_n, refund_queue_entry,
+                               indexed_by<"bytime"_n, const_mem_fun<refund_queue_entry, uint64_t, &refund_queue_entry::by_request_time>>
+                             > refund_queue_table;
+
    // `rex_pool` structure underlying the rex pool table. A rex pool table entry is defined by:
    // - `version` defaulted to zero,
    // - `total_lent` total amount of CORE_SYMBOL in open rex_loans
@@ -532,13 +604,12 @@ namespace eosiosystem {
          producers_table          _producers;
          producers_table2         _producers2;
          global_state_singleton   _global;
-         global_state2_singleton  _global2;
-         global_state3_singleton  _global3;
-         global_state4_singleton  _global4;
          eosio_global_state       _gstate;
-         eosio_global_state2      _gstate2;
-         eosio_global_state3      _gstate3;
-         eosio_global_state4      _gstate4;
+         bool                     _gstate_changed = false; // _gstate is only written back if set
+         lazy_global_state<global_state2_singleton, eosio_global_state2> _gstate2;
+         lazy_global_state<global_state3_singleton, eosio_global_state3> _gstate3;
+         lazy_global_state<global_state4_singleton, eosio_global_state4> _gstate4;
+         double                   _vote_decay_factor = 0.0; // computed by stake2vote on its first call in an action
          rammarket                _rammarket;
          rex_pool_table           _rexpool;
          rex_return_pool_table    _rexretpool;
@@ -958,6 +1029,24 @@ namespace eosiosystem {
          [[eosio::action]]
          void buyrambytes( const name& payer, const name& receiver, uint32_t bytes );
 
+         /**
+          * Onboard action, buys ram and delegates bandwidth for many receivers at once, e.g. the accounts
+          * created earlier in the same transaction. The ram of all receivers is bought in one market
+          * conversion and the stake is transferred in one transfer, then every receiver gets its share.
+          * Same as `buyrambytes` and `delegatebw` without transfer for each receiver.
+          *
+          * @param payer - the account paying for the ram and staking the bandwidth,
+          * @param receivers - the accounts receiving the ram and the bandwidth, not the payer, at most `max_onboard_receivers`,
+          * @param bytes - the quantity of ram to buy for each receiver, specified in bytes,
+          * @param stake_net_quantity - the amount of tokens staked for net bandwidth of each receiver,
+          * @param stake_cpu_quantity - the amount of tokens staked for cpu bandwidth of each receiver.
+          *
+          * @pre At least one of bytes, stake_net_quantity and stake_cpu_quantity is positive, none is negative
+          */
+         [[eosio::action]]
+         void onboard( const name& payer, const std::vector<name>& receivers, uint32_t bytes,
+                       const asset& stake_net_quantity, const asset& stake_cpu_quantity );
+
          /**
           * Sell ram action, reduces quota by bytes and then performs an inline transfer of tokens
           * to receiver based upon the average purchase price of the original quota.
@@ -977,6 +1066,17 @@ namespace eosiosystem {
          [[eosio::action]]
          void refund( const name& owner );
 
+         /**
+          * Run refunds action, pays out up to max matured refund requests, the oldest first. Anyone may call it.
+          * Each request leaves the refund queue and its `refund` action runs at once in its own deferred
+          * transaction, so an owner rejecting the transfer only fails its own payment. Its request then stays
+          * until the owner calls `refund`.
+          *
+          * @param max - the maximum number of refund requests to pay out.
+          */
+         [[eosio::action]]
+         void runrefunds( uint16_t max );
+
          // functions defined in voting.cpp
 
          /**
@@ -1079,6 +1179,20 @@ namespace eosiosystem {
          [[eosio::action]]
          void regproxy( const name& proxy, bool isproxy );
 
+         /**
+          * Refresh votes action, recomputes the vote weight of at most `max_voters` voters with the current
+          * weekly decay factor and updates their producers or proxy when it changed. Each call starts at the
+          * voter where the previous call stopped and wraps around at the end of the voters table, so the
+          * decay reaches every producer without waiting for the voters to vote again.
+          * Anyone can call it, storage changes are billed to the same payers as before.
+          *
+          * @param max_voters - the maximum number of voters to visit.
+          *
+          * @pre max_voters is positive
+          */
+         [[eosio::action]]
+         void refreshvotes( uint16_t max_voters );
+
          /**
           * Set the blockchain parameters. By tunning these parameters a degree of
           * customization can be achieved.
@@ -1194,8 +1308,10 @@ namespace eosiosystem {
          using undelegatebw_action = eosio::action_wrapper<"undelegatebw"_n, &system_contract::undelegatebw>;
          using buyram_action = eosio::action_wrapper<"buyram"_n, &system_contract::buyram>;
          using buyrambytes_action = eosio::action_wrapper<"buyrambytes"_n, &system_contract::buyrambytes>;
+         using onboard_action = eosio::action_wrapper<"onboard"_n, &system_contract::onboard>;
          using sellram_action = eosio::action_wrapper<"sellram"_n, &system_contract::sellram>;
          using refund_action = eosio::action_wrapper<"refund"_n, &system_contract::refund>;
+         using runrefunds_action = eosio::action_wrapper<"runrefunds"_n, &system_contract::runrefunds>;
          using regproducer_action = eosio::action_wrapper<"regproducer"_n, &system_contract::regproducer>;
          using regproducer2_action = eosio::action_wrapper<"regproducer2"_n, &system_contract::regproducer2>;
          using unregprod_action = eosio::action_wrapper<"unregprod"_n, &system_contract::unregprod>;
@@ -1203,6 +1319,7 @@ namespace eosiosystem {
          using setramrate_action = eosio::action_wrapper<"setramrate"_n, &system_contract::setramrate>;
          using voteproducer_action = eosio::action_wrapper<"voteproducer"_n, &system_contract::voteproducer>;
          using regproxy_action = eosio::action_wrapper<"regproxy"_n, &system_contract::regproxy>;
+         using refreshvotes_action = eosio::action_wrapper<"refreshvotes"_n, &system_contract::refreshvotes>;
          using claimrewards_action = eosio::action_wrapper<"claimrewards"_n, &system_contract::claimrewards>;
          using rmvproducer_action = eosio::action_wrapper<"rmvproducer"_n, &system_contract::rmvproducer>;
          using updtrevision_action = eosio::action_wrapper<"updtrevision"_n, &system_contract::updtrevision>;
@@ -1238,6 +1355,7 @@ namespace eosiosystem {
          asset update_rex_account( const name& owner, const asset& proceeds, const asset& unstake_quant, bool force_vote_update = false );
          void channel_to_rex( const name& from, const asset& amount );
          void channel_namebid_to_rex( const int64_t highest_bid );
+         void channel_ramfee_to_rex( const int64_t fee );
          template <typename T>
          int64_t rent_rex( T& table, const name& from, const name& receiver, const asset& loan_payment, const asset& loan_fund );
          template <typename T>
@@ -1265,16 +1383,34 @@ namespace eosiosystem {
          template <typename Index, typename Iterator>
          int64_t update_renewed_loan( Index& idx, const Iterator& itr, int64_t rented_tokens );
 
+         // defined in producer_pay.cpp
+         uint32_t take_round_unpaid_blocks( const name& producer );
+         void flush_round_unpaid_blocks();
+
          // defined in delegate_bandwidth.cpp
          void changebw( name from, const name& receiver,
                         const asset& stake_net_quantity, const asset& stake_cpu_quantity, bool transfer );
          void update_voting_power( const name& voter, const asset& total_update );
+         int64_t purchase_ram( const name& payer, const asset& quant );
+         void update_refund_queue( const name& owner, const refund_request* req );
 
          // defined in voting.cpp
          void register_producer( const name& producer, const eosio::block_signing_authority& producer_authority, const std::string& url, uint16_t location );
          void update_elected_producers( const block_timestamp& timestamp );
+         struct producer_delta {
+            double delta      = 0.0;
+            bool   new_vote   = false; // the producer is in the new vote of a voter and must be registered
+            bool   direct     = false; // changed by a voter's own vote, the result is clamped at 0
+            bool   propagated = false; // reached through proxy propagation, the producer row must exist
+         };
+         typedef std::map< name, producer_delta > producer_delta_map;
          void update_votes( const name& voter, const name& proxy, const std::vector<name>& producers, bool voting );
+         void update_votes( const name& voter, const name& proxy, const std::vector<name>& producers, bool voting,
+                            producer_delta_map& producer_deltas );
          void propagate_weight_change( const voter_info& voter );
+         void propagate_weight_change( const voter_info& voter, producer_delta_map& producer_deltas );
+         void apply_producer_deltas( const producer_delta_map& producer_deltas, bool voting );
+         double stake2vote( int64_t staked );
          double update_producer_votepay_share( const producers_table2::const_iterator& prod_itr,
                                                const time_point& ct,
                                                double shares_rate, bool reset_to_zero = false );
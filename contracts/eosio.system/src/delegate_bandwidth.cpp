@@ -51,6 +51,38 @@ namespace eosiosystem {
       check( quant.symbol == core_symbol(), "must buy ram with core token" );
       check( quant.amount > 0, "must purchase a positive amount" );
 
+      const int64_t bytes_out = purchase_ram( payer, quant );
+
+      user_resources_table  userres( get_self(), receiver.value );
+      auto res_itr = userres.find( receiver.value );
+      if( res_itr ==  userres.end() ) {
+         res_itr = userres.emplace( receiver, [&]( auto& res ) {
+               res.owner = receiver;
+               res.net_weight = asset( 0, core_symbol() );
+               res.cpu_weight = asset( 0, core_symbol() );
+               res.ram_bytes = bytes_out;
+            });
+      } else {
+         userres.modify( res_itr, receiver, [&]( auto& res ) {
+               res.ram_bytes += bytes_out;
+            });
+      }
+
+      auto voter_itr = _voters.find( res_itr->owner.value );
+      if( voter_itr == _voters.end() || !has_field( voter_itr->flags1, voter_info::flags1_fields::ram_managed ) ) {
+         int64_t ram_bytes, net, cpu;
+         get_resource_limits( res_itr->owner, ram_bytes, net, cpu );
+         set_resource_limits( res_itr->owner, res_itr->ram_bytes + ram_gift_bytes, net, cpu );
+      }
+   }
+
+   /**
+    *  Transfers quant from payer to the ram and ramfee accounts, converts it after the fee to ram
+    *  bytes at the market price and reserves them.
+    *
+    *  @return the bytes bought, to be added to the resources of the receivers
+    */
+   int64_t system_contract::purchase_ram( const name& payer, const asset& quant ) {
       auto fee = quant;
       fee.amount = ( fee.amount + 199 ) / 200; /// .5% fee (round up)
       // fee.amount cannot be 0 since that is only possible if quant.amount is 0 which is not allowed by the assert above.
@@ -67,7 +99,7 @@ namespace eosiosystem {
       if ( fee.amount > 0 ) {
          token::transfer_action transfer_act{ token_account, { {payer, active_permission} } };
          transfer_act.send( payer, ramfee_account, fee, "ram fee" );
-         channel_to_rex( ramfee_account, fee );
+         channel_ramfee_to_rex( fee.amount );
       }
 
       int64_t bytes_out;
@@ -81,27 +113,118 @@ namespace eosiosystem {
 
       _gstate.total_ram_bytes_reserved += uint64_t(bytes_out);
       _gstate.total_ram_stake          += quant_after_fee.amount;
+      _gstate_changed = true;
 
-      user_resources_table  userres( get_self(), receiver.value );
-      auto res_itr = userres.find( receiver.value );
-      if( res_itr ==  userres.end() ) {
-         res_itr = userres.emplace( receiver, [&]( auto& res ) {
-               res.owner = receiver;
-               res.net_weight = asset( 0, core_symbol() );
-               res.cpu_weight = asset( 0, core_symbol() );
-               res.ram_bytes = bytes_out;
-            });
-      } else {
-         userres.modify( res_itr, receiver, [&]( auto& res ) {
-               res.ram_bytes += bytes_out;
-            });
+      return bytes_out;
+   }
+
+   /**
+    *  Buys the ram of all receivers with one market conversion and stakes their bandwidth with one
+    *  transfer, then updates the resources of each receiver once.
+    */
+   void system_contract::onboard( const name& payer, const std::vector<name>& receivers, uint32_t bytes,
+                                  const asset& stake_net_quantity, const asset& stake_cpu_quantity )
+   {
+      require_auth( payer );
+      update_ram_supply();
+
+      const asset zero_asset( 0, core_symbol() );
+      check( !receivers.empty(), "no receivers" );
+      check( receivers.size() <= max_onboard_receivers, "too many receivers" );
+      check( stake_cpu_quantity >= zero_asset, "must stake a positive amount" );
+      check( stake_net_quantity >= zero_asset, "must stake a positive amount" );
+      check( bytes > 0 || stake_net_quantity.amount + stake_cpu_quantity.amount > 0,
+             "must purchase or stake a positive amount" );
+      // a stake to self must go through delegatebw, which keeps the payer's own delband row and refund together
+      for( const auto& receiver : receivers ) {
+         check( receiver != payer, "cannot onboard the payer" );
       }
 
-      auto voter_itr = _voters.find( res_itr->owner.value );
-      if( voter_itr == _voters.end() || !has_field( voter_itr->flags1, voter_info::flags1_fields::ram_managed ) ) {
-         int64_t ram_bytes, net, cpu;
-         get_resource_limits( res_itr->owner, ram_bytes, net, cpu );
-         set_resource_limits( res_itr->owner, res_itr->ram_bytes + ram_gift_bytes, net, cpu );
+      const int64_t receiver_count = receivers.size();
+      int64_t bytes_out = 0;
+      if( bytes > 0 ) {
+         const auto& market = _rammarket.get( ramcore_symbol.raw(), "ram market does not exist" );
+         const int64_t cost = exchange_state::get_bancor_input( market.base.balance.amount, market.quote.balance.amount,
+                                                                int64_t(bytes) * receiver_count );
+         const int64_t cost_plus_fee = cost / double(0.995);
+         check( cost_plus_fee > 0, "must purchase a positive amount" );
+         bytes_out = purchase_ram( payer, asset{ cost_plus_fee, core_symbol() } );
+      }
+
+      // the bytes bought are shared evenly, the first receivers get one more byte of the remainder
+      const int64_t receiver_bytes = bytes_out / receiver_count;
+      const int64_t extra_bytes    = bytes_out % receiver_count;
+      const asset   receiver_stake = stake_net_quantity + stake_cpu_quantity;
+
+      del_bandwidth_table del_tbl( get_self(), payer.value );
+      for( int64_t i = 0; i < receiver_count; ++i ) {
+         const name& receiver = receivers[i];
+         const int64_t ram_delta = receiver_bytes + ( i < extra_bytes ? 1 : 0 );
+
+         if( receiver_stake.amount > 0 ) {
+            auto itr = del_tbl.find( receiver.value );
+            if( itr == del_tbl.end() ) {
+               del_tbl.emplace( payer, [&]( auto& dbo ){
+                     dbo.from          = payer;
+                     dbo.to            = receiver;
+                     dbo.net_weight    = stake_net_quantity;
+                     dbo.cpu_weight    = stake_cpu_quantity;
+                  });
+            } else {
+               del_tbl.modify( itr, same_payer, [&]( auto& dbo ){
+                     dbo.net_weight    += stake_net_quantity;
+                     dbo.cpu_weight    += stake_cpu_quantity;
+                  });
+            }
+         }
+
+         user_resources_table userres( get_self(), receiver.value );
+         auto res_itr = userres.find( receiver.value );
+         if( res_itr == userres.end() ) {
+            res_itr = userres.emplace( receiver, [&]( auto& res ) {
+                  res.owner = receiver;
+                  res.net_weight = stake_net_quantity;
+                  res.cpu_weight = stake_cpu_quantity;
+                  res.ram_bytes = ram_delta;
+               });
+         } else {
+            userres.modify( res_itr, receiver, [&]( auto& res ) {
+                  res.net_weight += stake_net_quantity;
+                  res.cpu_weight += stake_cpu_quantity;
+                  res.ram_bytes += ram_delta;
+               });
+         }
+
+         bool ram_managed = false;
+         bool net_managed = false;
+         bool cpu_managed = false;
+
+         auto voter_itr = _voters.find( receiver.value );
+         if( voter_itr != _voters.end() ) {
+            ram_managed = has_field( voter_itr->flags1, voter_info::flags1_fields::ram_managed );
+            net_managed = has_field( voter_itr->flags1, voter_info::flags1_fields::net_managed );
+            cpu_managed = has_field( voter_itr->flags1, voter_info::flags1_fields::cpu_managed );
+         }
+
+         if( !(ram_managed && net_managed && cpu_managed) ) {
+            int64_t ram_bytes, net, cpu;
+            get_resource_limits( receiver, ram_bytes, net, cpu );
+
+            set_resource_limits( receiver,
+                                 ram_managed ? ram_bytes : std::max( res_itr->ram_bytes + ram_gift_bytes, ram_bytes ),
+                                 net_managed ? net : res_itr->net_weight.amount,
+                                 cpu_managed ? cpu : res_itr->cpu_weight.amount );
+         }
+      }
+
+      if( receiver_stake.amount > 0 ) {
+         const asset total_stake = receiver_stake * receiver_count;
+         if( stake_account != payer ) {
+            token::transfer_action transfer_act{ token_account, { {payer, active_permission} } };
+            transfer_act.send( payer, stake_account, total_stake, "stake bandwidth" );
+         }
+         vote_stake_updater( payer );
+         update_voting_power( payer, total_stake );
       }
    }
 
@@ -133,6 +256,7 @@ namespace eosiosystem {
 
       _gstate.total_ram_bytes_reserved -= static_cast<decltype(_gstate.total_ram_bytes_reserved)>(bytes); // bytes > 0 is asserted above
       _gstate.total_ram_stake          -= tokens_out.amount;
+      _gstate_changed = true;
 
       //// this shouldn't happen, but just in case it does we should prevent it
       check( _gstate.total_ram_stake >= 0, "error, attempt to unstake more tokens than previously staked" );
@@ -157,7 +281,7 @@ namespace eosiosystem {
       if ( fee > 0 ) {
          token::transfer_action transfer_act{ token_account, { {account, active_permission} } };
          transfer_act.send( account, ramfee_account, asset(fee, core_symbol()), "sell ram fee" );
-         channel_to_rex( ramfee_account, asset(fee, core_symbol() ));
+         channel_ramfee_to_rex( fee );
       }
    }
 
@@ -298,12 +422,14 @@ namespace eosiosystem {
 
                if ( req->is_empty() ) {
                   refunds_tbl.erase( req );
+                  update_refund_queue( from, nullptr );
                   need_deferred_trx = false;
                } else {
+                  update_refund_queue( from, &*req );
                   need_deferred_trx = true;
                }
             } else if ( net_balance.amount < 0 || cpu_balance.amount < 0 ) { //need to create refund
-               refunds_tbl.emplace( from, [&]( refund_request& r ) {
+               req = refunds_tbl.emplace( from, [&]( refund_request& r ) {
                   r.owner = from;
                   if ( net_balance.amount < 0 ) {
                      r.net_amount = -net_balance;
@@ -319,6 +445,7 @@ namespace eosiosystem {
                   }
                   r.request_time = current_time_point();
                });
+               update_refund_queue( from, &*req );
                need_deferred_trx = true;
             } // else stake increase requested with no existing row in refunds_tbl -> nothing to do with refunds_tbl
          } /// end if is_delegating_to_self || is_undelegating
@@ -410,6 +537,55 @@ namespace eosiosystem {
       token::transfer_action transfer_act{ token_account, { {stake_account, active_permission}, {req->owner, active_permission} } };
       transfer_act.send( stake_account, req->owner, req->net_amount + req->cpu_amount, "unstake" );
       refunds_tbl.erase( req );
+      update_refund_queue( owner, nullptr );
+   }
+
+   void system_contract::runrefunds( uint16_t max ) {
+      refund_queue_table refund_queue( get_self(), get_self().value );
+      auto idx = refund_queue.get_index<"bytime"_n>();
+      for ( uint16_t i = 0; i < max; ++i ) {
+         auto itr = idx.begin();
+         if ( itr == idx.end() || itr->request_time + seconds(refund_delay_sec) > current_time_point() ) break;
+
+         // dequeued before the payment, an owner rejecting the transfer cannot hold back the requests behind it
+         const name owner = itr->owner;
+         idx.erase( itr );
+
+         refunds_table refunds_tbl( get_self(), owner.value );
+         if ( refunds_tbl.find( owner.value ) != refunds_tbl.end() ) { // should always be true
+            // the refund of owner runs now in its own transaction, if it fails the request stays for the refund action
+            eosio::transaction out;
+            out.actions.emplace_back( permission_level{owner, active_permission},
+                                      get_self(), "refund"_n,
+                                      owner
+            );
+            eosio::cancel_deferred( owner.value ); // TODO: Remove this line when replacing deferred trxs is fixed
+            out.send( owner.value, owner, true );
+         }
+      }
+   }
+
+   /**
+    *  Keeps the refund queue entry of owner in line with its refund request, nullptr if it has none.
+    *  The refund requests made before the refund queue have no entry until they change.
+    */
+   void system_contract::update_refund_queue( const name& owner, const refund_request* req ) {
+      refund_queue_table refund_queue( get_self(), get_self().value );
+      auto itr = refund_queue.find( owner.value );
+      if ( req == nullptr ) {
+         if ( itr != refund_queue.end() ) {
+            refund_queue.erase( itr );
+         }
+      } else if ( itr == refund_queue.end() ) {
+         refund_queue.emplace( owner, [&]( auto& q ) {
+            q.owner        = owner;
+            q.request_time = req->request_time;
+         });
+      } else if ( itr->request_time != req->request_time ) {
+         refund_queue.modify( itr, same_payer, [&]( auto& q ) {
+            q.request_time = req->request_time;
+         });
+      }
    }
 
 
@@ -21,9 +21,9 @@ namespace eosiosystem {
     _producers(get_self(), get_self().value),
     _producers2(get_self(), get_self().value),
     _global(get_self(), get_self().value),
-    _global2(get_self(), get_self().value),
-    _global3(get_self(), get_self().value),
-    _global4(get_self(), get_self().value),
+    _gstate2(get_self()),
+    _gstate3(get_self()),
+    _gstate4(get_self(), &system_contract::get_default_inflation_parameters),
     _rammarket(get_self(), get_self().value),
     _rexpool(get_self(), get_self().value),
     _rexretpool(get_self(), get_self().value),
@@ -33,9 +33,6 @@ namespace eosiosystem {
     _rexorders(get_self(), get_self().value)
    {
       _gstate  = _global.exists() ? _global.get() : get_default_parameters();
-      _gstate2 = _global2.exists() ? _global2.get() : eosio_global_state2{};
-      _gstate3 = _global3.exists() ? _global3.get() : eosio_global_state3{};
-      _gstate4 = _global4.exists() ? _global4.get() : get_default_inflation_parameters();
    }
 
    eosio_global_state system_contract::get_default_parameters() {
@@ -58,10 +55,12 @@ namespace eosiosystem {
    }
 
    system_contract::~system_contract() {
-      _global.set( _gstate, get_self() );
-      _global2.set( _gstate2, get_self() );
-      _global3.set( _gstate3, get_self() );
-      _global4.set( _gstate4, get_self() );
+      if( _gstate_changed ) {
+         _global.set( _gstate, get_self() );
+      }
+      _gstate2.save( get_self() );
+      _gstate3.save( get_self() );
+      _gstate4.save( get_self() );
    }
 
    void system_contract::setram( uint64_t max_ram_size ) {
@@ -82,16 +81,19 @@ namespace eosiosystem {
       });
 
       _gstate.max_ram_size = max_ram_size;
+      _gstate_changed = true;
    }
 
    void system_contract::update_ram_supply() {
       auto cbt = eosio::current_block_time();
 
-      if( cbt <= _gstate2.last_ram_increase ) return;
+      if( cbt <= _gstate2.get().last_ram_increase ) return;
 
+      auto& gstate2 = _gstate2.modify();
       auto itr = _rammarket.find(ramcore_symbol.raw());
-      auto new_ram = (cbt.slot - _gstate2.last_ram_increase.slot)*_gstate2.new_ram_per_block;
+      auto new_ram = (cbt.slot - gstate2.last_ram_increase.slot)*gstate2.new_ram_per_block;
       _gstate.max_ram_size += new_ram;
+      _gstate_changed = true;
 
       /**
        *  Increase the amount of ram for sale based upon the change in max ram size.
@@ -99,19 +101,20 @@ namespace eosiosystem {
       _rammarket.modify( itr, same_payer, [&]( auto& m ) {
          m.base.balance.amount += new_ram;
       });
-      _gstate2.last_ram_increase = cbt;
+      gstate2.last_ram_increase = cbt;
    }
 
    void system_contract::setramrate( uint16_t bytes_per_block ) {
       require_auth( get_self() );
 
       update_ram_supply();
-      _gstate2.new_ram_per_block = bytes_per_block;
+      _gstate2.modify().new_ram_per_block = bytes_per_block;
    }
 
    void system_contract::setparams( const eosio::blockchain_parameters& params ) {
       require_auth( get_self() );
       (eosio::blockchain_parameters&)(_gstate) = params;
+      _gstate_changed = true;
       check( 3 <= _gstate.max_authority_depth, "max_authority_depth should be at least 3" );
       set_blockchain_parameters( params );
    }
@@ -288,11 +291,11 @@ namespace eosiosystem {
 
    void system_contract::updtrevision( uint8_t revision ) {
       require_auth( get_self() );
-      check( _gstate2.revision < 255, "can not increment revision" ); // prevent wrap around
-      check( revision == _gstate2.revision + 1, "can only increment revision by one" );
+      check( _gstate2.get().revision < 255, "can not increment revision" ); // prevent wrap around
+      check( revision == _gstate2.get().revision + 1, "can only increment revision by one" );
       check( revision <= 1, // set upper bound to greatest revision supported in the code
              "specified revision is not yet supported by the code" );
-      _gstate2.revision = revision;
+      _gstate2.modify().revision = revision;
    }
 
    void system_contract::setinflation( int64_t annual_rate, int64_t inflation_pay_factor, int64_t votepay_factor ) {
@@ -304,10 +307,10 @@ namespace eosiosystem {
       if ( votepay_factor < pay_factor_precision ) {
          check( false, "votepay_factor must not be less than " + std::to_string(pay_factor_precision) );
       }
-      _gstate4.continuous_rate      = get_continuous_rate(annual_rate);
-      _gstate4.inflation_pay_factor = inflation_pay_factor;
-      _gstate4.votepay_factor       = votepay_factor;
-      _global4.set( _gstate4, get_self() );
+      auto& gstate4 = _gstate4.modify();
+      gstate4.continuous_rate      = get_continuous_rate(annual_rate);
+      gstate4.inflation_pay_factor = inflation_pay_factor;
+      gstate4.votepay_factor       = votepay_factor;
    }
 
    /**
@@ -395,6 +398,12 @@ namespace eosiosystem {
 
       token::open_action open_act{ token_account, { {get_self(), active_permission} } };
       open_act.send( rex_account, core, get_self() );
+
+      // create all the global rows, they are only written back when modified later
+      _gstate_changed = true;
+      _gstate2.modify();
+      _gstate3.modify();
+      _gstate4.modify();
    }
 
 } /// eosio.system
@@ -2,7 +2,9 @@
 
 #include <eosio/check.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace eosiosystem {
 
@@ -82,29 +84,29 @@ namespace eosiosystem {
                                               int64_t out_reserve,
                                               int64_t inp )
    {
-      const double ib = inp_reserve;
-      const double ob = out_reserve;
-      const double in = inp;
-
-      int64_t out = int64_t( (in * ob) / (ib + in) );
-
-      if ( out < 0 ) out = 0;
-
-      return out;
+      if ( inp <= 0 || out_reserve <= 0 || inp_reserve <= -inp ) return 0;
+
+      // out = floor( inp * out_reserve / (inp_reserve + inp) ), exact; below out_reserve unless
+      // inp_reserve is 0, and capped at out_reserve for a negative inp_reserve (e.g. rex total_unlent)
+      const uint128_t num = uint128_t(uint64_t(inp)) * uint64_t(out_reserve);
+      const uint64_t  den = uint64_t(inp_reserve) + uint64_t(inp); // in (0, 2^64), wraps for a negative inp_reserve
+      if ( (num >> 64) == 0 ) return int64_t( std::min( uint64_t(num) / den, uint64_t(out_reserve) ) );
+      return int64_t( std::min( num / den, uint128_t(uint64_t(out_reserve)) ) );
    }
 
    int64_t exchange_state::get_bancor_input( int64_t out_reserve,
                                              int64_t inp_reserve,
                                              int64_t out )
    {
-      const double ob = out_reserve;
-      const double ib = inp_reserve;
-
-      int64_t inp = (ib * out) / (ob - out);
-
-      if ( inp < 0 ) inp = 0;
-
-      return inp;
+      if ( out <= 0 || inp_reserve <= 0 ) return 0;
+      check( out < out_reserve, "requested amount must be less than the reserve" );
+
+      // inp = floor( inp_reserve * out / (out_reserve - out) )
+      const uint128_t num = uint128_t(uint64_t(inp_reserve)) * uint64_t(out);
+      const uint64_t  den = uint64_t(out_reserve) - uint64_t(out);
+      const uint128_t inp = (num >> 64) == 0 ? uint128_t( uint64_t(num) / den ) : num / den;
+      check( inp <= uint128_t(std::numeric_limits<int64_t>::max()), "bancor input overflow" );
+      return int64_t( inp );
    }
 
 } /// namespace eosiosystem
@@ -1,6 +1,8 @@
 #include <eosio.system/eosio.system.hpp>
 #include <eosio.token/eosio.token.hpp>
 
+#include <algorithm>
+
 namespace eosiosystem {
 
    using eosio::current_time_point;
@@ -19,30 +21,40 @@ namespace eosiosystem {
       // _gstate2.last_block_num is not used anywhere in the system contract code anymore.
       // Although this field is deprecated, we will continue updating it for now until the last_block_num field
       // is eventually completely removed, at which point this line can be removed.
-      _gstate2.last_block_num = timestamp;
+      _gstate2.modify().last_block_num = timestamp;
 
       /** until activation, no new rewards are paid */
       if( _gstate.thresh_activated_stake_time == time_point() )
          return;
 
-      if( _gstate.last_pervote_bucket_fill == time_point() )  /// start the presses
+      if( _gstate.last_pervote_bucket_fill == time_point() ) { /// start the presses
          _gstate.last_pervote_bucket_fill = current_time_point();
+         _gstate_changed = true;
+      }
 
 
       /**
        * At startup the initial producer may not be one that is registered / elected
        * and therefore there may be no producer object for them.
+       * The block is counted in the global state, which is written anyway, instead of the producer row.
        */
-      auto prod = _producers.find( producer.value );
-      if ( prod != _producers.end() ) {
+      if( !_gstate.round_unpaid_blocks.has_value() ) {
+         _gstate.round_unpaid_blocks.emplace();
+      }
+      auto& round_blocks = _gstate.round_unpaid_blocks.value();
+      auto counter = std::find_if( round_blocks.begin(), round_blocks.end(), [&]( const auto& c ) { return c.producer == producer; } );
+      if( counter != round_blocks.end() || _producers.find( producer.value ) != _producers.end() ) {
+         if( counter == round_blocks.end() ) {
+            counter = round_blocks.insert( round_blocks.end(), producer_round_blocks{ producer, 0 } );
+         }
+         counter->unpaid_blocks++;
          _gstate.total_unpaid_blocks++;
-         _producers.modify( prod, same_payer, [&](auto& p ) {
-               p.unpaid_blocks++;
-         });
+         _gstate_changed = true;
       }
 
       /// only update block producers once every minute, block_timestamp is in half seconds
       if( timestamp.slot - _gstate.last_producer_schedule_update.slot > 120 ) {
+         flush_round_unpaid_blocks();
          update_elected_producers( timestamp );
 
          if( (timestamp.slot - _gstate.last_name_close.slot) > blocks_per_day ) {
@@ -56,6 +68,7 @@ namespace eosiosystem {
                 (current_time_point() - _gstate.thresh_activated_stake_time) > microseconds(14 * useconds_per_day)
             ) {
                _gstate.last_name_close = timestamp;
+               _gstate_changed = true;
                channel_namebid_to_rex( highest->high_bid );
                idx.modify( highest, same_payer, [&]( auto& b ){
                   b.high_bid = -b.high_bid;
@@ -65,6 +78,37 @@ namespace eosiosystem {
       }
    }
 
+   uint32_t system_contract::take_round_unpaid_blocks( const name& producer ) {
+      if( !_gstate.round_unpaid_blocks.has_value() ) {
+         return 0;
+      }
+      auto& round_blocks = _gstate.round_unpaid_blocks.value();
+      auto counter = std::find_if( round_blocks.begin(), round_blocks.end(), [&]( const auto& c ) { return c.producer == producer; } );
+      if( counter == round_blocks.end() ) {
+         return 0;
+      }
+      const uint32_t unpaid_blocks = counter->unpaid_blocks;
+      round_blocks.erase( counter );
+      _gstate_changed = true;
+      return unpaid_blocks;
+   }
+
+   void system_contract::flush_round_unpaid_blocks() {
+      if( !_gstate.round_unpaid_blocks.has_value() || _gstate.round_unpaid_blocks.value().empty() ) {
+         return;
+      }
+      for( const auto& c : _gstate.round_unpaid_blocks.value() ) {
+         auto prod = _producers.find( c.producer.value );
+         if( prod != _producers.end() ) {
+            _producers.modify( prod, same_payer, [&](auto& p ) {
+                  p.unpaid_blocks += c.unpaid_blocks;
+            });
+         }
+      }
+      _gstate.round_unpaid_blocks.value().clear();
+      _gstate_changed = true;
+   }
+
    void system_contract::claimrewards( const name& owner ) {
       require_auth( owner );
 
@@ -82,14 +126,15 @@ namespace eosiosystem {
       const auto usecs_since_last_fill = (ct - _gstate.last_pervote_bucket_fill).count();
 
       if( usecs_since_last_fill > 0 && _gstate.last_pervote_bucket_fill > time_point() ) {
-         double additional_inflation = (_gstate4.continuous_rate * double(token_supply.amount) * double(usecs_since_last_fill)) / double(useconds_per_year);
+         const auto& gstate4 = _gstate4.get();
+         double additional_inflation = (gstate4.continuous_rate * double(token_supply.amount) * double(usecs_since_last_fill)) / double(useconds_per_year);
          check( additional_inflation <= double(std::numeric_limits<int64_t>::max() - ((1ll << 10) - 1)),
                 "overflow in calculating new tokens to be issued; inflation rate is too high" );
          int64_t new_tokens = (additional_inflation < 0.0) ? 0 : static_cast<int64_t>(additional_inflation);
 
-         int64_t to_producers     = (new_tokens * uint128_t(pay_factor_precision)) / _gstate4.inflation_pay_factor;
+         int64_t to_producers     = (new_tokens * uint128_t(pay_factor_precision)) / gstate4.inflation_pay_factor;
          int64_t to_savings       = new_tokens - to_producers;
-         int64_t to_per_block_pay = (to_producers * uint128_t(pay_factor_precision)) / _gstate4.votepay_factor;
+         int64_t to_per_block_pay = (to_producers * uint128_t(pay_factor_precision)) / gstate4.votepay_factor;
          int64_t to_per_vote_pay  = to_producers - to_per_block_pay;
 
          if( new_tokens > 0 ) {
@@ -114,6 +159,7 @@ namespace eosiosystem {
          _gstate.pervote_bucket          += to_per_vote_pay;
          _gstate.perblock_bucket         += to_per_block_pay;
          _gstate.last_pervote_bucket_fill = ct;
+         _gstate_changed = true;
       }
 
       auto prod2 = _producers2.find( owner.value );
@@ -138,9 +184,12 @@ namespace eosiosystem {
       // This is okay because in this case the producer will not get paid anything either way.
       // In fact it is desired behavior because the producers votes need to be counted in the global total_producer_votepay_share for the first time.
 
+      // the row is reset below, so the blocks of the current round are added here rather than to the row
+      const uint32_t unpaid_blocks = prod.unpaid_blocks + take_round_unpaid_blocks( owner );
+
       int64_t producer_per_block_pay = 0;
       if( _gstate.total_unpaid_blocks > 0 ) {
-         producer_per_block_pay = (_gstate.perblock_bucket * prod.unpaid_blocks) / _gstate.total_unpaid_blocks;
+         producer_per_block_pay = (_gstate.perblock_bucket * unpaid_blocks) / _gstate.total_unpaid_blocks;
       }
 
       double new_votepay_share = update_producer_votepay_share( prod2,
@@ -150,7 +199,7 @@ namespace eosiosystem {
                                  );
 
       int64_t producer_per_vote_pay = 0;
-      if( _gstate2.revision > 0 ) {
+      if( _gstate2.get().revision > 0 ) {
          double total_votepay_share = update_total_votepay_share( ct );
          if( total_votepay_share > 0 && !crossed_threshold ) {
             producer_per_vote_pay = int64_t((new_votepay_share * _gstate.pervote_bucket) / total_votepay_share);
@@ -169,7 +218,8 @@ namespace eosiosystem {
 
       _gstate.pervote_bucket      -= producer_per_vote_pay;
       _gstate.perblock_bucket     -= producer_per_block_pay;
-      _gstate.total_unpaid_blocks -= prod.unpaid_blocks;
+      _gstate.total_unpaid_blocks -= unpaid_blocks;
+      _gstate_changed = true;
 
       update_total_votepay_share( ct, -new_votepay_share, (updated_after_threshold ? prod.total_votes : 0.0) );
 
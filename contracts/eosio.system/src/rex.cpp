@@ -554,6 +554,13 @@ namespace eosiosystem {
          });
       }
 
+      /// transfer from eosio.ramfee to eosio.rex
+      if ( _gstate.ram_fee_proceeds.has_value() && _gstate.ram_fee_proceeds.value() > 0 && rex_available() ) {
+         channel_to_rex( ramfee_account, asset( _gstate.ram_fee_proceeds.value(), core_symbol() ) );
+         _gstate.ram_fee_proceeds.value() = 0;
+         _gstate_changed = true;
+      }
+
       /// process cpu loans
       {
          rex_cpu_loan_table cpu_loans( get_self(), get_self().value );
@@ -946,6 +953,24 @@ namespace eosiosystem {
 #endif
    }
 
+   /**
+    * @brief Updates ram fee proceeds to be transfered to REX pool
+    *
+    * @param fee - ram fee of a buyram or sellram, already transfered to eosio.ramfee
+    */
+   void system_contract::channel_ramfee_to_rex( const int64_t fee )
+   {
+#if CHANNEL_RAM_AND_NAMEBID_FEES_TO_REX
+      if ( rex_available() ) {
+         if ( !_gstate.ram_fee_proceeds.has_value() ) {
+            _gstate.ram_fee_proceeds.emplace( 0 );
+         }
+         _gstate.ram_fee_proceeds.value() += fee;
+         _gstate_changed = true;
+      }
+#endif
+   }
+
    /**
     * @brief Calculates maturity time of purchased REX tokens which is 4 days from end
     * of the day UTC
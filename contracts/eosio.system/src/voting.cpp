@@ -105,6 +105,7 @@ namespace eosiosystem {
 
    void system_contract::update_elected_producers( const block_timestamp& block_time ) {
       _gstate.last_producer_schedule_update = block_time;
+      _gstate_changed = true;
 
       auto idx = _producers.get_index<"prototalvote"_n>();
 
@@ -137,43 +138,59 @@ namespace eosiosystem {
       for( auto& item : top_producers )
          producers.push_back( std::move(item.first) );
 
+      // an unchanged set of names and authorities is already proposed or active, skip the intrinsic
+      auto packed_producers = eosio::pack( producers );
+      const auto schedule_hash = eosio::sha256( packed_producers.data(), packed_producers.size() );
+      const auto& last_hash = _gstate2.get().last_proposed_schedule_hash;
+      if( last_hash.has_value() && last_hash.value() == schedule_hash ) {
+         return;
+      }
+
+      // a rejected proposal (e.g. an earlier one still waiting to become pending) must be retried next round
       if( set_proposed_producers( producers ) >= 0 ) {
          _gstate.last_producer_schedule_size = static_cast<decltype(_gstate.last_producer_schedule_size)>( top_producers.size() );
+         _gstate2.modify().last_proposed_schedule_hash.emplace( schedule_hash );
       }
    }
 
-   double stake2vote( int64_t staked ) {
-      /// TODO subtract 2080 brings the large numbers closer to this decade
-      double weight = int64_t( (current_time_point().sec_since_epoch() - (block_timestamp::block_timestamp_epoch / 1000)) / (seconds_per_day * 7) )  / double( 52 );
-      return double(staked) * std::pow( 2, weight );
+   double system_contract::stake2vote( int64_t staked ) {
+      // the factor only changes once a week, so one pow per action is enough
+      if( _vote_decay_factor == 0.0 ) {
+         /// TODO subtract 2080 brings the large numbers closer to this decade
+         double weight = int64_t( (current_time_point().sec_since_epoch() - (block_timestamp::block_timestamp_epoch / 1000)) / (seconds_per_day * 7) )  / double( 52 );
+         _vote_decay_factor = std::pow( 2, weight );
+      }
+      return double(staked) * _vote_decay_factor;
    }
 
    double system_contract::update_total_votepay_share( const time_point& ct,
                                                        double additional_shares_delta,
                                                        double shares_rate_delta )
    {
+      auto& gstate2 = _gstate2.modify();
+      auto& gstate3 = _gstate3.modify();
       double delta_total_votepay_share = 0.0;
-      if( ct > _gstate3.last_vpay_state_update ) {
-         delta_total_votepay_share = _gstate3.total_vpay_share_change_rate
-                                       * double( (ct - _gstate3.last_vpay_state_update).count() / 1E6 );
+      if( ct > gstate3.last_vpay_state_update ) {
+         delta_total_votepay_share = gstate3.total_vpay_share_change_rate
+                                       * double( (ct - gstate3.last_vpay_state_update).count() / 1E6 );
       }
 
       delta_total_votepay_share += additional_shares_delta;
-      if( delta_total_votepay_share < 0 && _gstate2.total_producer_votepay_share < -delta_total_votepay_share ) {
-         _gstate2.total_producer_votepay_share = 0.0;
+      if( delta_total_votepay_share < 0 && gstate2.total_producer_votepay_share < -delta_total_votepay_share ) {
+         gstate2.total_producer_votepay_share = 0.0;
       } else {
-         _gstate2.total_producer_votepay_share += delta_total_votepay_share;
+         gstate2.total_producer_votepay_share += delta_total_votepay_share;
       }
 
-      if( shares_rate_delta < 0 && _gstate3.total_vpay_share_change_rate < -shares_rate_delta ) {
-         _gstate3.total_vpay_share_change_rate = 0.0;
+      if( shares_rate_delta < 0 && gstate3.total_vpay_share_change_rate < -shares_rate_delta ) {
+         gstate3.total_vpay_share_change_rate = 0.0;
       } else {
-         _gstate3.total_vpay_share_change_rate += shares_rate_delta;
+         gstate3.total_vpay_share_change_rate += shares_rate_delta;
       }
 
-      _gstate3.last_vpay_state_update = ct;
+      gstate3.last_vpay_state_update = ct;
 
-      return _gstate2.total_producer_votepay_share;
+      return gstate2.total_producer_votepay_share;
    }
 
    double system_contract::update_producer_votepay_share( const producers_table2::const_iterator& prod_itr,
@@ -187,6 +204,9 @@ namespace eosiosystem {
       }
 
       double new_votepay_share = prod_itr->votepay_share + delta_votepay_share;
+      if( !reset_to_zero && ct == prod_itr->last_votepay_share_update ) {
+         return new_votepay_share; // already up to date in this block
+      }
       _producers2.modify( prod_itr, same_payer, [&](auto& p) {
          if( reset_to_zero )
             p.votepay_share = 0.0;
@@ -210,6 +230,13 @@ namespace eosiosystem {
    }
 
    void system_contract::update_votes( const name& voter_name, const name& proxy, const std::vector<name>& producers, bool voting ) {
+      producer_delta_map producer_deltas;
+      update_votes( voter_name, proxy, producers, voting, producer_deltas );
+      apply_producer_deltas( producer_deltas, voting );
+   }
+
+   void system_contract::update_votes( const name& voter_name, const name& proxy, const std::vector<name>& producers, bool voting,
+                                       producer_delta_map& producer_deltas ) {
       //validate input
       if ( proxy ) {
          check( producers.size() == 0, "cannot vote for producers and proxy at same time" );
@@ -232,6 +259,7 @@ namespace eosiosystem {
        */
       if( _gstate.thresh_activated_stake_time == time_point() && voter->last_vote_weight <= 0.0 ) {
          _gstate.total_activated_stake += voter->staked;
+         _gstate_changed = true;
          if( _gstate.total_activated_stake >= min_activated_stake ) {
             _gstate.thresh_activated_stake_time = current_time_point();
          }
@@ -242,7 +270,6 @@ namespace eosiosystem {
          new_vote_weight += voter->proxied_vote_weight;
       }
 
-      std::map<name, std::pair<double, bool /*new*/> > producer_deltas;
       if ( voter->last_vote_weight > 0 ) {
          if( voter->proxy ) {
             auto old_proxy = _voters.find( voter->proxy.value );
@@ -250,12 +277,12 @@ namespace eosiosystem {
             _voters.modify( old_proxy, same_payer, [&]( auto& vp ) {
                   vp.proxied_vote_weight -= voter->last_vote_weight;
                });
-            propagate_weight_change( *old_proxy );
+            propagate_weight_change( *old_proxy, producer_deltas );
          } else {
             for( const auto& p : voter->producers ) {
                auto& d = producer_deltas[p];
-               d.first -= voter->last_vote_weight;
-               d.second = false;
+               d.delta -= voter->last_vote_weight;
+               d.direct = true;
             }
          }
       }
@@ -268,34 +295,138 @@ namespace eosiosystem {
             _voters.modify( new_proxy, same_payer, [&]( auto& vp ) {
                   vp.proxied_vote_weight += new_vote_weight;
                });
-            propagate_weight_change( *new_proxy );
+            propagate_weight_change( *new_proxy, producer_deltas );
          }
       } else {
          if( new_vote_weight >= 0 ) {
             for( const auto& p : producers ) {
                auto& d = producer_deltas[p];
-               d.first += new_vote_weight;
-               d.second = true;
+               d.delta += new_vote_weight;
+               d.new_vote = true;
+               d.direct = true;
             }
          }
       }
 
+      _voters.modify( voter, same_payer, [&]( auto& av ) {
+         av.last_vote_weight = new_vote_weight;
+         av.producers = producers;
+         av.proxy     = proxy;
+      });
+   }
+
+   void system_contract::regproxy( const name& proxy, bool isproxy ) {
+      require_auth( proxy );
+
+      auto pitr = _voters.find( proxy.value );
+      if ( pitr != _voters.end() ) {
+         check( isproxy != pitr->is_proxy, "action has no effect" );
+         check( !isproxy || !pitr->proxy, "account that uses a proxy is not allowed to become a proxy" );
+         _voters.modify( pitr, same_payer, [&]( auto& p ) {
+               p.is_proxy = isproxy;
+            });
+         propagate_weight_change( *pitr );
+      } else {
+         _voters.emplace( proxy, [&]( auto& p ) {
+               p.owner  = proxy;
+               p.is_proxy = isproxy;
+            });
+      }
+   }
+
+   void system_contract::refreshvotes( uint16_t max_voters ) {
+      check( max_voters > 0, "max_voters must be positive" );
+
+      producer_delta_map producer_deltas;
+      auto& gstate3 = _gstate3.modify();
+      auto itr = _voters.lower_bound( gstate3.next_vote_refresh.has_value() ? gstate3.next_vote_refresh.value().value : 0 );
+      for( uint16_t i = 0; i < max_voters && itr != _voters.end(); ++i, ++itr ) {
+         if( itr->last_vote_weight <= 0.0 || ( !itr->proxy && itr->producers.empty() ) ) {
+            continue;
+         }
+         double new_vote_weight = stake2vote( itr->staked );
+         if( itr->is_proxy ) {
+            new_vote_weight += itr->proxied_vote_weight;
+         }
+         /// same threshold as propagate_weight_change
+         if( fabs( new_vote_weight - itr->last_vote_weight ) > 1 ) {
+            const auto proxy     = itr->proxy;
+            const auto producers = itr->producers;
+            update_votes( itr->owner, proxy, producers, false, producer_deltas );
+         }
+      }
+      gstate3.next_vote_refresh.emplace( itr != _voters.end() ? itr->owner : name() );
+      if( !producer_deltas.empty() ) {
+         apply_producer_deltas( producer_deltas, false );
+      }
+   }
+
+   void system_contract::propagate_weight_change( const voter_info& voter ) {
+      producer_delta_map producer_deltas;
+      propagate_weight_change( voter, producer_deltas );
+      if( !producer_deltas.empty() ) {
+         apply_producer_deltas( producer_deltas, false );
+      }
+   }
+
+   void system_contract::propagate_weight_change( const voter_info& voter, producer_delta_map& producer_deltas ) {
+      // walks up the proxy chain, the producer rows are left to apply_producer_deltas
+      const voter_info* current = &voter;
+      while( current ) {
+         check( !current->proxy || !current->is_proxy, "account registered as a proxy is not allowed to use a proxy" );
+         double new_weight = stake2vote( current->staked );
+         if ( current->is_proxy ) {
+            new_weight += current->proxied_vote_weight;
+         }
+
+         const voter_info* next = nullptr;
+         /// don't propagate small changes (1 ~= epsilon)
+         if ( fabs( new_weight - current->last_vote_weight ) > 1 )  {
+            const double delta = new_weight - current->last_vote_weight;
+            if ( current->proxy ) {
+               auto& proxy = _voters.get( current->proxy.value, "proxy not found" ); //data corruption
+               _voters.modify( proxy, same_payer, [&]( auto& p ) {
+                     p.proxied_vote_weight += delta;
+                  }
+               );
+               next = &proxy;
+            } else {
+               for ( const auto& acnt : current->producers ) {
+                  auto& d = producer_deltas[acnt];
+                  d.delta += delta;
+                  d.propagated = true;
+               }
+            }
+         }
+         _voters.modify( *current, same_payer, [&]( auto& v ) {
+               v.last_vote_weight = new_weight;
+            }
+         );
+         current = next;
+      }
+   }
+
+   void system_contract::apply_producer_deltas( const producer_delta_map& producer_deltas, bool voting ) {
       const auto ct = current_time_point();
       double delta_change_rate         = 0.0;
       double total_inactive_vpay_share = 0.0;
       for( const auto& pd : producer_deltas ) {
          auto pitr = _producers.find( pd.first.value );
+         if( pd.second.propagated ) {
+            check( pitr != _producers.end(), "producer not found" ); //data corruption
+         }
          if( pitr != _producers.end() ) {
-            if( voting && !pitr->active() && pd.second.second /* from new set */ ) {
+            if( voting && !pitr->active() && pd.second.new_vote ) {
                check( false, ( "producer " + pitr->owner.to_string() + " is not currently registered" ).data() );
             }
             double init_total_votes = pitr->total_votes;
             _producers.modify( pitr, same_payer, [&]( auto& p ) {
-               p.total_votes += pd.second.first;
-               if ( p.total_votes < 0 ) { // floating point arithmetics can give small negative numbers
+               p.total_votes += pd.second.delta;
+               if ( pd.second.direct && p.total_votes < 0 ) { // floating point arithmetics can give small negative numbers
                   p.total_votes = 0;
                }
-               _gstate.total_producer_vote_weight += pd.second.first;
+               _gstate.total_producer_vote_weight += pd.second.delta;
+               _gstate_changed = true;
                //check( p.total_votes >= 0, "something bad happened" );
             });
             auto prod2 = _producers2.find( pd.first.value );
@@ -312,104 +443,20 @@ namespace eosiosystem {
                                           );
 
                if( !crossed_threshold ) {
-                  delta_change_rate += pd.second.first;
+                  delta_change_rate += pd.second.delta;
                } else if( !updated_after_threshold ) {
                   total_inactive_vpay_share += new_votepay_share;
                   delta_change_rate -= init_total_votes;
                }
             }
          } else {
-            if( pd.second.second ) {
+            if( pd.second.new_vote ) {
                check( false, ( "producer " + pd.first.to_string() + " is not registered" ).data() );
             }
          }
       }
 
       update_total_votepay_share( ct, -total_inactive_vpay_share, delta_change_rate );
-
-      _voters.modify( voter, same_payer, [&]( auto& av ) {
-         av.last_vote_weight = new_vote_weight;
-         av.producers = producers;
-         av.proxy     = proxy;
-      });
-   }
-
-   void system_contract::regproxy( const name& proxy, bool isproxy ) {
-      require_auth( proxy );
-
-      auto pitr = _voters.find( proxy.value );
-      if ( pitr != _voters.end() ) {
-         check( isproxy != pitr->is_proxy, "action has no effect" );
-         check( !isproxy || !pitr->proxy, "account that uses a proxy is not allowed to become a proxy" );
-         _voters.modify( pitr, same_payer, [&]( auto& p ) {
-               p.is_proxy = isproxy;
-            });
-         propagate_weight_change( *pitr );
-      } else {
-         _voters.emplace( proxy, [&]( auto& p ) {
-               p.owner  = proxy;
-               p.is_proxy = isproxy;
-            });
-      }
-   }
-
-   void system_contract::propagate_weight_change( const voter_info& voter ) {
-      check( !voter.proxy || !voter.is_proxy, "account registered as a proxy is not allowed to use a proxy" );
-      double new_weight = stake2vote( voter.staked );
-      if ( voter.is_proxy ) {
-         new_weight += voter.proxied_vote_weight;
-      }
-
-      /// don't propagate small changes (1 ~= epsilon)
-      if ( fabs( new_weight - voter.last_vote_weight ) > 1 )  {
-         if ( voter.proxy ) {
-            auto& proxy = _voters.get( voter.proxy.value, "proxy not found" ); //data corruption
-            _voters.modify( proxy, same_payer, [&]( auto& p ) {
-                  p.proxied_vote_weight += new_weight - voter.last_vote_weight;
-               }
-            );
-            propagate_weight_change( proxy );
-         } else {
-            auto delta = new_weight - voter.last_vote_weight;
-            const auto ct = current_time_point();
-            double delta_change_rate         = 0;
-            double total_inactive_vpay_share = 0;
-            for ( auto acnt : voter.producers ) {
-               auto& prod = _producers.get( acnt.value, "producer not found" ); //data corruption
-               const double init_total_votes = prod.total_votes;
-               _producers.modify( prod, same_payer, [&]( auto& p ) {
-                  p.total_votes += delta;
-                  _gstate.total_producer_vote_weight += delta;
-               });
-               auto prod2 = _producers2.find( acnt.value );
-               if ( prod2 != _producers2.end() ) {
-                  const auto last_claim_plus_3days = prod.last_claim_time + microseconds(3 * useconds_per_day);
-                  bool crossed_threshold       = (last_claim_plus_3days <= ct);
-                  bool updated_after_threshold = (last_claim_plus_3days <= prod2->last_votepay_share_update);
-                  // Note: updated_after_threshold implies cross_threshold
-
-                  double new_votepay_share = update_producer_votepay_share( prod2,
-                                                ct,
-                                                updated_after_threshold ? 0.0 : init_total_votes,
-                                                crossed_threshold && !updated_after_threshold // only reset votepay_share once after threshold
-                                             );
-
-                  if( !crossed_threshold ) {
-                     delta_change_rate += delta;
-                  } else if( !updated_after_threshold ) {
-                     total_inactive_vpay_share += new_votepay_share;
-                     delta_change_rate -= init_total_votes;
-                  }
-               }
-            }
-
-            update_total_votepay_share( ct, -total_inactive_vpay_share, delta_change_rate );
-         }
-      }
-      _voters.modify( voter, same_payer, [&]( auto& v ) {
-            v.last_vote_weight = new_weight;
-         }
-      );
    }
 
 } /// namespace eosiosystem
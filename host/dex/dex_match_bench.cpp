@@ -0,0 +1,350 @@
+/**
+ * Native benchmark of the matching engine in dex_match.hpp.
+ *
+ * Builds a synthetic order book in the in-memory multi_index, then feeds taker orders through
+ * the same matching loop as dex_contract::match_sympair, and reports fills/sec, database
+ * operations per fill and heap allocations per fill. Balance updates are out of scope here,
+ * only the order and deal tables are exercised.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+
+#include "dex_match.hpp"
+
+using namespace dex;
+
+static uint64_t g_allocations = 0;
+
+// kept out of line, or gcc sees malloc() paired with delete or new paired with free() once they are
+// inlined and warns -Wmismatched-new-delete
+__attribute__((noinline)) void *operator new(std::size_t size) {
+    ++g_allocations;
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void *operator new[](std::size_t size) { return operator new(size); }
+
+__attribute__((noinline)) void operator delete(void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+static const name DEX_ACCOUNT = "dex"_n;
+static const name BANK = "eosio.token"_n;
+static const extended_symbol BTC_SYMBOL = extended_symbol{symbol("BTC", 8), BANK};
+static const extended_symbol USD_SYMBOL = extended_symbol{symbol("USD", 4), BANK};
+
+// Quantities are whole multiples of QUANT_LOT and prices whole multiples of PRICE_TICK, so that
+// calc_coin_quant is exact. Otherwise the rounding of several partial fills at the same price
+// may add up over the frozen coins of a buy order and fail the match.
+constexpr int64_t QUANT_LOT = 1'0000;       // 0.00010000 BTC
+constexpr int64_t PRICE_TICK = 1'0000;      // 1.0000 USD
+constexpr int64_t MID_PRICE = 10000'0000;   // 10000.0000 USD
+constexpr int64_t MAKER_LOTS_MIN = 10;      // 0.00100000 BTC
+constexpr int64_t MAKER_LOTS_MAX = 1000;    // 0.10000000 BTC
+
+struct bench_config {
+    uint32_t depth        = 1000;  // resting limit orders per side
+    uint32_t takers       = 10000; // taker orders to match
+    uint32_t spread_bps   = 200;   // makers are placed within this distance of the mid price
+    double   market_ratio = 0.5;   // share of takers that are market orders, the rest are crossing limits
+    double   taker_size   = 3.0;   // mean taker size in units of mean maker size
+    uint32_t max_count    = DEX_MATCH_COUNT_MAX;
+    uint64_t seed         = 1;
+    bool     csv          = false;
+};
+
+struct bench_result {
+    uint64_t fills = 0;
+    uint64_t takers = 0;
+    double seconds = 0;
+    eosio::host::db_stats db;
+    uint64_t allocations = 0;
+};
+
+class order_book_generator {
+public:
+    order_book_generator(const bench_config &conf, const symbol_pair_t &sym_pair)
+        : _conf(conf), _sym_pair(sym_pair), _rng(conf.seed) {}
+
+    uint64_t place_maker(order_tbl &orders, const order_side_t &side) {
+        int64_t offset = std::uniform_int_distribution<int64_t>(1, max_offset_ticks())(_rng) * PRICE_TICK;
+        int64_t price = (side == order_side::BUY) ? MID_PRICE - offset : MID_PRICE + offset;
+        return place(orders, order_type::LIMIT, side, asset(maker_quant(1.0), asset_sym()), asset(price, coin_sym()));
+    }
+
+    uint64_t place_taker(order_tbl &orders) {
+        bool is_market = std::bernoulli_distribution(_conf.market_ratio)(_rng);
+        order_side_t side = std::bernoulli_distribution(0.5)(_rng) ? order_side::BUY : order_side::SELL;
+        int64_t quant = maker_quant(_conf.taker_size);
+
+        if (is_market) {
+            if (side == order_side::BUY) {
+                auto coins = calc_coin_quant(asset(quant, asset_sym()), asset(MID_PRICE, coin_sym()), coin_sym());
+                return place(orders, order_type::MARKET, side, coins, asset(0, coin_sym()));
+            }
+            return place(orders, order_type::MARKET, side, asset(quant, asset_sym()), asset(0, coin_sym()));
+        }
+        // cross the whole spread with some room, the fills happen at the maker prices
+        int64_t offset = 2 * max_offset_ticks() * PRICE_TICK;
+        int64_t price = (side == order_side::BUY) ? MID_PRICE + offset : MID_PRICE - offset;
+        return place(orders, order_type::LIMIT, side, asset(quant, asset_sym()), asset(price, coin_sym()));
+    }
+
+private:
+    symbol asset_sym() const { return _sym_pair.asset_symbol.get_symbol(); }
+    symbol coin_sym() const { return _sym_pair.coin_symbol.get_symbol(); }
+
+    int64_t max_offset_ticks() const {
+        return std::max<int64_t>(1, MID_PRICE / PRICE_TICK * _conf.spread_bps / 10000);
+    }
+
+    int64_t maker_quant(double scale) {
+        auto lots = std::uniform_int_distribution<int64_t>(MAKER_LOTS_MIN, MAKER_LOTS_MAX)(_rng);
+        return std::max<int64_t>(MAKER_LOTS_MIN, int64_t(lots * scale)) * QUANT_LOT;
+    }
+
+    // the same frozen quantity rules as dex_contract::new_order
+    uint64_t place(order_tbl &orders, const order_type_t &type, const order_side_t &side,
+                   const asset &limit_quant, const asset &price) {
+        asset frozen_quant = limit_quant;
+        if (side == order_side::BUY && type == order_type::LIMIT) {
+            frozen_quant = calc_coin_quant(limit_quant, price, coin_sym());
+        }
+        const auto &fee_symbol = (side == order_side::BUY && !_sym_pair.only_accept_coin_fee) ? asset_sym() : coin_sym();
+        auto order_id = ++_order_id;
+        auto now = current_block_time();
+        orders.emplace(DEX_ACCOUNT, [&](auto &order) {
+            order.order_id = order_id;
+            order.external_id = order_id;
+            order.owner = (side == order_side::BUY) ? "alice"_n : "bob"_n;
+            order.sympair_id = _sym_pair.sympair_id;
+            order.order_type = type;
+            order.order_side = side;
+            order.price = price;
+            order.limit_quant = limit_quant;
+            order.frozen_quant = frozen_quant;
+            order.taker_fee_ratio = _sym_pair.taker_fee_ratio;
+            order.maker_fee_ratio = _sym_pair.maker_fee_ratio;
+            order.matched_assets = asset(0, asset_sym());
+            order.matched_coins = asset(0, coin_sym());
+            order.matched_fee = asset(0, fee_symbol);
+            order.status = order_status::MATCHABLE;
+            order.created_at = now;
+            order.last_updated_at = now;
+            order.last_deal_id = 0;
+        });
+        return order_id;
+    }
+
+    const bench_config &_conf;
+    const symbol_pair_t &_sym_pair;
+    std::mt19937_64 _rng;
+    uint64_t _order_id = 0;
+};
+
+// the order book part of dex_contract::match_sympair
+static uint32_t match_book(order_tbl &orders, deal_table &deals, const symbol_pair_t &sym_pair,
+                           uint32_t max_count, uint64_t &deal_id, uint32_t &buy_makers, uint32_t &sell_makers) {
+    auto match_index = orders.get_index<static_cast<name::raw>(order_match_idx::index_name)>();
+    auto matching_pair_it = matching_pair_iterator(match_index, sym_pair);
+    uint32_t matched_count = 0;
+    while (matched_count < max_count && matching_pair_it.can_match()) {
+        auto &maker_it = matching_pair_it.maker_it();
+        auto &taker_it = matching_pair_it.taker_it();
+        const auto &matched_price = maker_it.stored_order().price;
+
+        asset matched_assets;
+        asset matched_coins;
+        matching_pair_it.calc_matched_amounts(matched_assets, matched_coins);
+        check(matched_assets.amount > 0 || matched_coins.amount > 0, "Invalid calc_matched_amounts!");
+
+        auto &buy_it = (taker_it.order_side() == order_side::BUY) ? taker_it : maker_it;
+        auto &sell_it = (taker_it.order_side() == order_side::SELL) ? taker_it : maker_it;
+        const auto &buy_order = buy_it.stored_order();
+        const auto &sell_order = sell_it.stored_order();
+
+        asset buy_fee = (matched_coins.symbol == buy_order.matched_fee.symbol) ?
+            calc_match_fee(buy_order, taker_it.order_side(), matched_coins) :
+            calc_match_fee(buy_order, taker_it.order_side(), matched_assets);
+        asset sell_fee = calc_match_fee(sell_order, taker_it.order_side(), matched_coins);
+
+        ++deal_id;
+        auto buy_order_id = buy_order.order_id;
+        auto sell_order_id = sell_order.order_id;
+        auto taker_side = taker_it.order_side();
+        buy_it.match(deal_id, matched_assets, matched_coins, buy_fee);
+        sell_it.match(deal_id, matched_assets, matched_coins, sell_fee);
+        CHECK(buy_it.is_completed() || sell_it.is_completed(), "Neither buy_order nor sell_order is completed");
+
+        asset buy_refund_coins(0, sym_pair.coin_symbol.get_symbol());
+        if (buy_it.is_completed()) {
+            buy_refund_coins = buy_it.get_refund_coins();
+        }
+        if (maker_it.is_completed()) {
+            ++(maker_it.order_side() == order_side::BUY ? buy_makers : sell_makers);
+        }
+
+        deals.emplace(DEX_ACCOUNT, [&](auto &deal_item) {
+            deal_item.id = deal_id;
+            deal_item.sympair_id = sym_pair.sympair_id;
+            deal_item.buy_order_id = buy_order_id;
+            deal_item.sell_order_id = sell_order_id;
+            deal_item.deal_assets = matched_assets;
+            deal_item.deal_coins = matched_coins;
+            deal_item.deal_price = matched_price;
+            deal_item.taker_side = taker_side;
+            deal_item.buy_fee = buy_fee;
+            deal_item.sell_fee = sell_fee;
+            deal_item.buy_refund_coins = buy_refund_coins;
+            deal_item.deal_time = current_block_time();
+        });
+
+        matched_count++;
+        matching_pair_it.complete_and_next(orders);
+    }
+    matching_pair_it.save_matching_order(orders);
+    return matched_count;
+}
+
+static bench_result run(const bench_config &conf) {
+    eosio::host::reset_database();
+
+    symbol_pair_t sym_pair;
+    sym_pair.sympair_id = 1;
+    sym_pair.asset_symbol = BTC_SYMBOL;
+    sym_pair.coin_symbol = USD_SYMBOL;
+    sym_pair.min_asset_quant = asset(1000, BTC_SYMBOL.get_symbol());
+    sym_pair.min_coin_quant = asset(1000, USD_SYMBOL.get_symbol());
+    sym_pair.latest_deal_price = asset(0, USD_SYMBOL.get_symbol());
+    sym_pair.taker_fee_ratio = DEX_TAKER_FEE_RATIO;
+    sym_pair.maker_fee_ratio = DEX_MAKER_FEE_RATIO;
+    sym_pair.only_accept_coin_fee = false;
+    sym_pair.enabled = true;
+
+    auto orders = make_order_table(DEX_ACCOUNT);
+    auto deals = make_deal_table(DEX_ACCOUNT);
+    order_book_generator generator(conf, sym_pair);
+    for (uint32_t i = 0; i < conf.depth; i++) {
+        generator.place_maker(orders, order_side::BUY);
+        generator.place_maker(orders, order_side::SELL);
+    }
+
+    bench_result result;
+    uint64_t deal_id = 0;
+    std::chrono::steady_clock::duration elapsed{0};
+    for (uint32_t i = 0; i < conf.takers; i++) {
+        eosio::host::produce_block();
+        generator.place_taker(orders);
+
+        uint32_t buy_makers = 0, sell_makers = 0;
+        auto db_before = eosio::host::stats();
+        auto allocations_before = g_allocations;
+        auto start = std::chrono::steady_clock::now();
+
+        result.fills += match_book(orders, deals, sym_pair, conf.max_count, deal_id, buy_makers, sell_makers);
+
+        elapsed += std::chrono::steady_clock::now() - start;
+        result.allocations += g_allocations - allocations_before;
+        auto db_delta = eosio::host::stats() - db_before;
+        result.db.finds += db_delta.finds;
+        result.db.lower_bounds += db_delta.lower_bounds;
+        result.db.upper_bounds += db_delta.upper_bounds;
+        result.db.nexts += db_delta.nexts;
+        result.db.previouses += db_delta.previouses;
+        result.db.stores += db_delta.stores;
+        result.db.updates += db_delta.updates;
+        result.db.removes += db_delta.removes;
+
+        // keep the book depth steady
+        for (; buy_makers > 0; buy_makers--) generator.place_maker(orders, order_side::BUY);
+        for (; sell_makers > 0; sell_makers--) generator.place_maker(orders, order_side::SELL);
+    }
+    result.takers = conf.takers;
+    result.seconds = std::chrono::duration<double>(elapsed).count();
+    return result;
+}
+
+static void usage(const char *prog) {
+    std::fprintf(stderr,
+        "Usage: %s [OPTION]...\n"
+        "  --depth N          resting limit orders per side (default 1000)\n"
+        "  --takers N         taker orders to match (default 10000)\n"
+        "  --spread-bps N     makers are placed within N bps of the mid price (default 200)\n"
+        "  --market-ratio R   share of market takers in [0,1] (default 0.5)\n"
+        "  --taker-size R     mean taker size in units of mean maker size (default 3)\n"
+        "  --max-count N      max fills per match call (default %u)\n"
+        "  --seed N           random seed (default 1)\n"
+        "  --csv              print one csv header and row\n",
+        prog, DEX_MATCH_COUNT_MAX);
+}
+
+int main(int argc, char **argv) {
+    bench_config conf;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--csv") {
+            conf.csv = true;
+        } else if (arg == "--depth" && has_value) {
+            conf.depth = std::stoul(argv[++i]);
+        } else if (arg == "--takers" && has_value) {
+            conf.takers = std::stoul(argv[++i]);
+        } else if (arg == "--spread-bps" && has_value) {
+            conf.spread_bps = std::stoul(argv[++i]);
+        } else if (arg == "--market-ratio" && has_value) {
+            conf.market_ratio = std::stod(argv[++i]);
+        } else if (arg == "--taker-size" && has_value) {
+            conf.taker_size = std::stod(argv[++i]);
+        } else if (arg == "--max-count" && has_value) {
+            conf.max_count = std::stoul(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            conf.seed = std::stoull(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    bench_result result;
+    try {
+        result = run(conf);
+    } catch (const eosio::check_failure &e) {
+        std::fprintf(stderr, "check failed: %s\n", e.what());
+        return 1;
+    }
+
+    double fills = result.fills > 0 ? double(result.fills) : 1.0;
+    double fills_per_sec = result.seconds > 0 ? result.fills / result.seconds : 0;
+    if (conf.csv) {
+        std::printf("depth,takers,spread_bps,market_ratio,fills,fills_per_sec,db_ops_per_fill,db_reads_per_fill,db_writes_per_fill,allocs_per_fill\n");
+        std::printf("%u,%u,%u,%.2f,%llu,%.0f,%.2f,%.2f,%.2f,%.2f\n", conf.depth, conf.takers, conf.spread_bps,
+                    conf.market_ratio, (unsigned long long)result.fills, fills_per_sec,
+                    result.db.total() / fills, result.db.reads() / fills, result.db.writes() / fills,
+                    result.allocations / fills);
+        return 0;
+    }
+    std::printf("depth=%u takers=%u spread_bps=%u market_ratio=%.2f taker_size=%.2f max_count=%u seed=%llu\n",
+                conf.depth, conf.takers, conf.spread_bps, conf.market_ratio, conf.taker_size, conf.max_count,
+                (unsigned long long)conf.seed);
+    std::printf("fills            : %llu\n", (unsigned long long)result.fills);
+    std::printf("match time       : %.3f s\n", result.seconds);
+    std::printf("fills/sec        : %.0f\n", fills_per_sec);
+    std::printf("db ops/fill      : %.2f (reads %.2f, writes %.2f)\n", result.db.total() / fills,
+                result.db.reads() / fills, result.db.writes() / fills);
+    std::printf("  find           : %.2f\n", result.db.finds / fills);
+    std::printf("  lower_bound    : %.2f\n", result.db.lower_bounds / fills);
+    std::printf("  upper_bound    : %.2f\n", result.db.upper_bounds / fills);
+    std::printf("  next/previous  : %.2f\n", (result.db.nexts + result.db.previouses) / fills);
+    std::printf("  store          : %.2f\n", result.db.stores / fills);
+    std::printf("  update         : %.2f\n", result.db.updates / fills);
+    std::printf("  remove         : %.2f\n", result.db.removes / fills);
+    std::printf("allocations/fill : %.2f\n", result.allocations / fills);
+    return 0;
+}
@@ -0,0 +1,309 @@
+#pragma once
+
+/**
+ * Off-chain mirror of the dex: rebuilds the open books, the balances and the recent deals from
+ * the rows and notifications of the contract, with the types of dex_states.hpp.
+ *
+ * A mirror bootstraps from the bookchunk notifications of the snapshot action, then follows the
+ * order, deal and account rows, e.g. the table deltas of a state history node, and the cancel
+ * actions. Every open order remembers the last deal applied to it, so a deal and the order row
+ * it updates may arrive in any order and more than once. Once order rows are followed, the orders
+ * closed by a deal or a cancel action are remembered until their final row arrives, so an older
+ * matchable row does not reopen them.
+ *
+ * Header only: the contract headers define non-inline functions, so they can only be compiled
+ * into one translation unit of a program, like for eosio-cpp.
+ */
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "dex_states.hpp"
+
+namespace dex::mirror {
+
+    /**
+     * The open limit orders of one side at one price
+     */
+    struct price_level {
+        int64_t price;
+        int64_t quant;    // open asset quantity
+        uint32_t orders;
+    };
+
+    /**
+     * The price levels of one side of a book in a flat vector, the best level at the back. New
+     * orders and fills are mostly near the best price, so they seldom move many levels.
+     */
+    class book_side {
+    public:
+        explicit book_side(bool is_buy) : _is_buy(is_buy) {}
+
+        void add(int64_t price, int64_t quant) {
+            auto it = lower_bound(price);
+            if (it == _levels.end() || it->price != price) it = _levels.insert(it, price_level{price, 0, 0});
+            it->quant += quant;
+            it->orders++;
+        }
+
+        // reduce the open quantity at price, and the order count if an order leaves the level
+        void reduce(int64_t price, int64_t quant, bool order_removed) {
+            auto it = lower_bound(price);
+            ASSERT(it != _levels.end() && it->price == price);
+            it->quant -= quant;
+            if (order_removed) it->orders--;
+            if (it->orders == 0) _levels.erase(it);
+        }
+
+        const price_level *best() const { return _levels.empty() ? nullptr : &_levels.back(); }
+
+        // from the worst to the best level
+        const std::vector<price_level> &levels() const { return _levels; }
+
+        bool is_buy() const { return _is_buy; }
+
+    private:
+        // buys ascend and sells descend by price, so the best price is the last
+        std::vector<price_level>::iterator lower_bound(int64_t price) {
+            return std::lower_bound(_levels.begin(), _levels.end(), price, [this](const price_level &l, int64_t p) {
+                return _is_buy ? l.price < p : l.price > p;
+            });
+        }
+
+        bool _is_buy;
+        std::vector<price_level> _levels;
+    };
+
+    /**
+     * An open order of the mirror. The open quantity is in the asset symbol, except for market
+     * buy orders which are in the coin symbol and are not on a price level.
+     */
+    struct open_order {
+        uint64_t sympair_id;
+        uint64_t last_deal_id;
+        name owner;
+        int64_t price;
+        int64_t open_quant;
+        bool is_buy;
+        bool is_limit;
+    };
+
+    struct deal_record {
+        uint64_t id;
+        uint64_t buy_order_id;
+        uint64_t sell_order_id;
+        int64_t deal_assets;
+        int64_t deal_coins;
+        int64_t deal_price;
+        bool taker_is_buy;
+    };
+
+    struct sympair_book {
+        book_side bids{true};
+        book_side asks{false};
+        uint32_t market_orders = 0;
+        std::deque<deal_record> deals; // the latest deals, the newest at the back
+    };
+
+    struct balance_key {
+        name user;
+        name bank;
+        symbol sym;
+
+        friend bool operator==(const balance_key &a, const balance_key &b) {
+            return a.user == b.user && a.bank == b.bank && a.sym == b.sym;
+        }
+    };
+
+    struct balance_key_hash {
+        size_t operator()(const balance_key &k) const {
+            uint64_t h = k.user.value * 0x9E3779B97F4A7C15ULL;
+            h ^= (k.bank.value + (h << 6) + (h >> 2));
+            h ^= (k.sym.raw() + (h << 6) + (h >> 2));
+            return size_t(h);
+        }
+    };
+
+    class book_mirror {
+    public:
+        // deal_history: the deals kept per symbol pair
+        explicit book_mirror(size_t deal_history = 1000) : _deal_history(deal_history) {}
+
+        /**
+         * The orders of a bookchunk notification, they include every deal up to last_deal_id
+         */
+        void on_book_chunk(uint64_t sympair_id, uint64_t last_deal_id, const std::vector<book_order_t> &orders) {
+            for (const auto &o : orders) {
+                bool is_buy = o.order_side == order_side::BUY;
+                bool is_limit = o.order_type == order_type::LIMIT;
+                int64_t open_quant = (is_buy && !is_limit) ? o.limit_quant - o.matched_coins
+                                                           : o.limit_quant - o.matched_assets;
+                upsert(o.order_id, open_order{sympair_id, last_deal_id, o.owner, o.price, open_quant, is_buy, is_limit});
+            }
+        }
+
+        /**
+         * A row of the order table, ignored if it is older than the deals applied to the order
+         */
+        void on_order(const order_t &row) {
+            _follows_order_rows = true;
+            auto it = _orders.find(row.order_id);
+            if (it != _orders.end() && row.last_deal_id < it->second.last_deal_id) return;
+            if (row.status != order_status::MATCHABLE) {
+                _closed.erase(row.order_id);
+                remove(row.order_id);
+                return;
+            }
+            auto closed_it = _closed.find(row.order_id);
+            if (closed_it != _closed.end()) {
+                if (row.last_deal_id <= closed_it->second) return;
+                _closed.erase(closed_it);
+            }
+            bool is_buy = row.order_side == order_side::BUY;
+            bool is_limit = row.order_type == order_type::LIMIT;
+            int64_t open_quant = (is_buy && !is_limit) ? row.limit_quant.amount - row.matched_coins.amount
+                                                       : row.limit_quant.amount - row.matched_assets.amount;
+            upsert(row.order_id, open_order{row.sympair_id, row.last_deal_id, row.owner, row.price.amount, open_quant,
+                                            is_buy, is_limit});
+        }
+
+        void on_cancel(uint64_t order_id) {
+            if (_follows_order_rows) _closed[order_id] = std::numeric_limits<uint64_t>::max();
+            remove(order_id);
+        }
+
+        /**
+         * A row of the deal table or the deal of a trace, applied to its orders which have not
+         * seen it yet. The order id 0 of the pool, route and auction sides is not an order.
+         */
+        void on_deal(const deal_item_t &deal) {
+            auto &book = _books[deal.sympair_id];
+            if (!book.deals.empty() && deal.id <= book.deals.back().id) return; // seen
+            if (deal.id > _last_deal_id) _last_deal_id = deal.id;
+            book.deals.push_back({deal.id, deal.buy_order_id, deal.sell_order_id, deal.deal_assets.amount,
+                                  deal.deal_coins.amount, deal.deal_price.amount, deal.taker_side == order_side::BUY});
+            if (book.deals.size() > _deal_history) book.deals.pop_front();
+
+            fill(book, deal.buy_order_id, deal.id, deal.deal_assets.amount, deal.deal_coins.amount);
+            fill(book, deal.sell_order_id, deal.id, deal.deal_assets.amount, deal.deal_coins.amount);
+        }
+
+        /**
+         * A row of the account table in the scope of user
+         */
+        void on_balance(const name &user, const account_t &row) {
+            const auto &quant = row.balance.quantity;
+            balance_key key{user, row.balance.contract, quant.symbol};
+            if (quant.amount == 0) {
+                _balances.erase(key);
+            } else {
+                _balances[key] = quant.amount;
+            }
+        }
+
+        const sympair_book *book(uint64_t sympair_id) const {
+            auto it = _books.find(sympair_id);
+            return it == _books.end() ? nullptr : &it->second;
+        }
+
+        const open_order *order(uint64_t order_id) const {
+            auto it = _orders.find(order_id);
+            return it == _orders.end() ? nullptr : &it->second;
+        }
+
+        int64_t balance(const name &user, const extended_symbol &sym) const {
+            auto it = _balances.find(balance_key{user, sym.get_contract(), sym.get_symbol()});
+            return it == _balances.end() ? 0 : it->second;
+        }
+
+        const std::unordered_map<uint64_t, sympair_book> &books() const { return _books; }
+        const std::unordered_map<uint64_t, open_order> &orders() const { return _orders; }
+        const std::unordered_map<balance_key, int64_t, balance_key_hash> &balances() const { return _balances; }
+        uint64_t last_deal_id() const { return _last_deal_id; }
+
+        /**
+         * @return the first price level which does not add up from the open orders, empty if none
+         */
+        std::string verify() const {
+            std::unordered_map<uint64_t, sympair_book> expected;
+            for (const auto &[id, o] : _orders) {
+                auto &book = expected[o.sympair_id];
+                if (o.is_limit) {
+                    (o.is_buy ? book.bids : book.asks).add(o.price, o.open_quant);
+                } else {
+                    book.market_orders++;
+                }
+            }
+            for (const auto &[sympair_id, book] : _books) {
+                auto &e = expected[sympair_id];
+                for (auto [side, expected_side] : {std::make_pair(&book.bids, &e.bids), std::make_pair(&book.asks, &e.asks)}) {
+                    const auto &a = side->levels(), &b = expected_side->levels();
+                    for (size_t i = 0; i < std::max(a.size(), b.size()); i++) {
+                        if (i >= a.size() || i >= b.size() || a[i].price != b[i].price || a[i].quant != b[i].quant ||
+                            a[i].orders != b[i].orders) {
+                            return "sympair " + std::to_string(sympair_id) + (side->is_buy() ? " bids" : " asks") +
+                                   " level " + std::to_string(i);
+                        }
+                    }
+                }
+                if (book.market_orders != e.market_orders) {
+                    return "sympair " + std::to_string(sympair_id) + " market orders";
+                }
+            }
+            return "";
+        }
+
+    private:
+        void upsert(uint64_t order_id, const open_order &order) {
+            remove(order_id);
+            if (order.open_quant <= 0) return;
+            auto &book = _books[order.sympair_id];
+            if (order.is_limit) {
+                (order.is_buy ? book.bids : book.asks).add(order.price, order.open_quant);
+            } else {
+                book.market_orders++;
+            }
+            _orders.emplace(order_id, order);
+        }
+
+        void remove(uint64_t order_id) {
+            auto it = _orders.find(order_id);
+            if (it == _orders.end()) return;
+            const auto &order = it->second;
+            auto &book = _books[order.sympair_id];
+            if (order.is_limit) {
+                (order.is_buy ? book.bids : book.asks).reduce(order.price, order.open_quant, true);
+            } else {
+                book.market_orders--;
+            }
+            _orders.erase(it);
+        }
+
+        void fill(sympair_book &book, uint64_t order_id, uint64_t deal_id, int64_t deal_assets, int64_t deal_coins) {
+            if (order_id == 0) return;
+            auto it = _orders.find(order_id);
+            if (it == _orders.end() || deal_id <= it->second.last_deal_id) return;
+            auto &order = it->second;
+            order.last_deal_id = deal_id;
+            int64_t quant = std::min((order.is_buy && !order.is_limit) ? deal_coins : deal_assets, order.open_quant);
+            if (quant == order.open_quant) {
+                if (_follows_order_rows) _closed[order_id] = deal_id;
+                remove(order_id);
+                return;
+            }
+            order.open_quant -= quant;
+            if (order.is_limit) (order.is_buy ? book.bids : book.asks).reduce(order.price, quant, false);
+        }
+
+        size_t _deal_history;
+        uint64_t _last_deal_id = 0;
+        std::unordered_map<uint64_t, sympair_book> _books;
+        std::unordered_map<uint64_t, open_order> _orders;
+        std::unordered_map<balance_key, int64_t, balance_key_hash> _balances;
+        bool _follows_order_rows = false;
+        std::unordered_map<uint64_t, uint64_t> _closed; // order id -> the deal which closed it, max if canceled
+    };
+
+}// namespace dex::mirror
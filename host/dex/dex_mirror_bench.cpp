@@ -0,0 +1,332 @@
+/**
+ * Native benchmark of the book mirror in dex_mirror.hpp.
+ *
+ * Generates a synthetic event stream of a busy book: a bookchunk bootstrap, then new and updated
+ * order rows, deals of resting orders followed by their order rows, cancels and balance rows.
+ * The stream is applied once as decoded structs and once as JSON lines through
+ * dex_mirror_json.hpp. It reports events/sec for both, checks that the two mirrors are identical
+ * and that their price levels add up from their open orders.
+ */
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "dex_mirror_json.hpp"
+
+using namespace dex;
+using namespace dex::mirror;
+
+static const name BANK = "eosio.token"_n;
+static const symbol BTC = symbol("BTC", 8);
+static const symbol USD = symbol("USD", 4);
+
+constexpr int64_t QUANT_LOT = 1'0000;       // 0.00010000 BTC
+constexpr int64_t PRICE_TICK = 1'0000;      // 1.0000 USD
+constexpr int64_t MID_PRICE = 10000'0000;   // 10000.0000 USD
+
+struct bench_config {
+    uint32_t depth   = 10000;   // open orders per side of the bootstrap
+    uint32_t events  = 1000000; // events after the bootstrap
+    uint32_t pairs   = 4;
+    uint32_t spread  = 500;     // orders are placed within this many ticks of the mid price
+    uint64_t seed    = 1;
+    bool     csv     = false;
+};
+
+struct mirror_event {
+    enum kind_t { book_chunk, order_row, deal_row, cancel_action, account_row } kind;
+    uint64_t sympair_id = 0;
+    uint64_t last_deal_id = 0;
+    std::vector<book_order_t> orders;
+    order_t order;
+    deal_item_t deal;
+    name user;
+    account_t account;
+};
+
+class event_generator {
+public:
+    explicit event_generator(const bench_config &conf) : _conf(conf), _rng(conf.seed) {}
+
+    std::vector<mirror_event> generate() {
+        std::vector<mirror_event> events;
+        for (uint64_t pair = 1; pair <= _conf.pairs; pair++) {
+            mirror_event chunk;
+            chunk.kind = mirror_event::book_chunk;
+            chunk.sympair_id = pair;
+            for (uint32_t i = 0; i < 2 * _conf.depth; i++) {
+                auto &o = new_order(pair);
+                chunk.orders.push_back({o.order_id, o.owner, o.order_type, o.order_side, o.price.amount,
+                                        o.limit_quant.amount, o.matched_assets.amount, o.matched_coins.amount});
+            }
+            events.push_back(std::move(chunk));
+        }
+
+        while (events.size() < _conf.events + _conf.pairs) {
+            uint32_t dice = std::uniform_int_distribution<uint32_t>(0, 99)(_rng);
+            if (dice < 40 || _open.empty()) {
+                uint64_t pair = std::uniform_int_distribution<uint64_t>(1, _conf.pairs)(_rng);
+                events.push_back(order_event(new_order(pair)));
+            } else if (dice < 75) {
+                add_deal(events);
+            } else if (dice < 90) {
+                size_t i = std::uniform_int_distribution<size_t>(0, _open.size() - 1)(_rng);
+                auto &o = _orders[_open[i]];
+                mirror_event cancel;
+                cancel.kind = mirror_event::cancel_action;
+                cancel.order.order_id = o.order_id;
+                events.push_back(cancel);
+                o.status = order_status::CANCELED;
+                events.push_back(order_event(o));
+                close(i);
+            } else {
+                mirror_event balance;
+                balance.kind = mirror_event::account_row;
+                balance.user = user(std::uniform_int_distribution<uint32_t>(0, 999)(_rng));
+                balance.account = {0, extended_asset(asset(std::uniform_int_distribution<int64_t>(0, 1'000'000'0000)(_rng), USD), BANK)};
+                events.push_back(balance);
+            }
+        }
+        return events;
+    }
+
+private:
+    order_t &new_order(uint64_t pair) {
+        order_t o;
+        o.order_id = ++_order_id;
+        o.owner = user(std::uniform_int_distribution<uint32_t>(0, 999)(_rng));
+        o.sympair_id = pair;
+        o.order_type = order_type::LIMIT;
+        o.order_side = std::bernoulli_distribution(0.5)(_rng) ? order_side::BUY : order_side::SELL;
+        int64_t offset = std::uniform_int_distribution<int64_t>(1, _conf.spread)(_rng) * PRICE_TICK;
+        o.price = asset(o.order_side == order_side::BUY ? MID_PRICE - offset : MID_PRICE + offset, USD);
+        o.limit_quant = asset(std::uniform_int_distribution<int64_t>(1, 100)(_rng) * QUANT_LOT, BTC);
+        o.matched_assets = asset(0, BTC);
+        o.matched_coins = asset(0, USD);
+        o.status = order_status::MATCHABLE;
+        o.last_deal_id = 0;
+        _open.push_back(o.order_id);
+        return _orders[o.order_id] = o;
+    }
+
+    // a taker of the pool or route, order id 0, fills a resting order partly or fully
+    void add_deal(std::vector<mirror_event> &events) {
+        size_t i = std::uniform_int_distribution<size_t>(0, _open.size() - 1)(_rng);
+        auto &o = _orders[_open[i]];
+        int64_t open_lots = (o.limit_quant.amount - o.matched_assets.amount) / QUANT_LOT;
+        int64_t lots = std::uniform_int_distribution<int64_t>(1, open_lots)(_rng);
+
+        mirror_event deal;
+        deal.kind = mirror_event::deal_row;
+        deal.deal.id = ++_deal_id;
+        deal.deal.sympair_id = o.sympair_id;
+        bool is_buy = o.order_side == order_side::BUY;
+        deal.deal.buy_order_id = is_buy ? o.order_id : 0;
+        deal.deal.sell_order_id = is_buy ? 0 : o.order_id;
+        deal.deal.deal_assets = asset(lots * QUANT_LOT, BTC);
+        deal.deal.deal_coins = asset(lots * QUANT_LOT * (o.price.amount / PRICE_TICK) / 1'0000, USD);
+        deal.deal.deal_price = o.price;
+        deal.deal.taker_side = is_buy ? order_side::SELL : order_side::BUY;
+        events.push_back(deal);
+
+        o.matched_assets += deal.deal.deal_assets;
+        o.matched_coins += deal.deal.deal_coins;
+        o.last_deal_id = _deal_id;
+        if (lots == open_lots) o.status = order_status::COMPLETED;
+        events.push_back(order_event(o));
+        if (lots == open_lots) close(i);
+    }
+
+    void close(size_t open_index) {
+        _orders.erase(_open[open_index]);
+        _open[open_index] = _open.back();
+        _open.pop_back();
+    }
+
+    static mirror_event order_event(const order_t &o) {
+        mirror_event e;
+        e.kind = mirror_event::order_row;
+        e.order = o;
+        return e;
+    }
+
+    static name user(uint32_t i) {
+        std::string s = "user";
+        for (uint32_t n = i; s.size() < 12; n /= 5) s.push_back(char('a' + n % 5));
+        return name(s);
+    }
+
+    const bench_config &_conf;
+    std::mt19937_64 _rng;
+    uint64_t _order_id = 0;
+    uint64_t _deal_id = 0;
+    std::unordered_map<uint64_t, order_t> _orders;
+    std::vector<uint64_t> _open;
+};
+
+static std::string to_json(const mirror_event &e) {
+    std::ostringstream ss;
+    auto str = [](const auto &v) { return "\"" + v.to_string() + "\""; };
+    switch (e.kind) {
+        case mirror_event::book_chunk: {
+            ss << R"({"action":"bookchunk","data":{"sympair_id":)" << e.sympair_id << R"(,"last_deal_id":)"
+               << e.last_deal_id << R"(,"orders":[)";
+            for (size_t i = 0; i < e.orders.size(); i++) {
+                const auto &o = e.orders[i];
+                ss << (i ? "," : "") << R"({"order_id":)" << o.order_id << R"(,"owner":)" << str(o.owner)
+                   << R"(,"order_type":)" << str(o.order_type) << R"(,"order_side":)" << str(o.order_side)
+                   << R"(,"price":)" << o.price << R"(,"limit_quant":)" << o.limit_quant << R"(,"matched_assets":)"
+                   << o.matched_assets << R"(,"matched_coins":)" << o.matched_coins << "}";
+            }
+            ss << R"(],"next_cursor":null}})";
+            break;
+        }
+        case mirror_event::order_row: {
+            const auto &o = e.order;
+            ss << R"({"table":"order","scope":"dex","row":{"order_id":)" << o.order_id << R"(,"external_id":0,"owner":)"
+               << str(o.owner) << R"(,"sympair_id":)" << o.sympair_id << R"(,"order_type":)" << str(o.order_type)
+               << R"(,"order_side":)" << str(o.order_side) << R"(,"price":)" << str(o.price) << R"(,"limit_quant":)"
+               << str(o.limit_quant) << R"(,"frozen_quant":)" << str(o.limit_quant) << R"(,"taker_fee_ratio":8,"maker_fee_ratio":4,"matched_assets":)"
+               << str(o.matched_assets) << R"(,"matched_coins":)" << str(o.matched_coins) << R"(,"matched_fee":"0.0000 USD","status":)"
+               << str(o.status) << R"(,"created_at":"2021-01-01T00:00:00.000","last_updated_at":"2021-01-01T00:00:00.000","last_deal_id":")"
+               << o.last_deal_id << R"("}})";
+            break;
+        }
+        case mirror_event::deal_row: {
+            const auto &d = e.deal;
+            ss << R"({"table":"deal","scope":"dex","row":{"id":)" << d.id << R"(,"sympair_id":)" << d.sympair_id
+               << R"(,"buy_order_id":)" << d.buy_order_id << R"(,"sell_order_id":)" << d.sell_order_id
+               << R"(,"deal_assets":)" << str(d.deal_assets) << R"(,"deal_coins":)" << str(d.deal_coins)
+               << R"(,"deal_price":)" << str(d.deal_price) << R"(,"taker_side":)" << str(d.taker_side)
+               << R"(,"buy_fee":"0.00000000 BTC","sell_fee":"0.0000 USD","buy_refund_coins":"0.0000 USD","memo":"pool","deal_time":"2021-01-01T00:00:00.000"}})";
+            break;
+        }
+        case mirror_event::cancel_action:
+            ss << R"({"action":"cancel","data":{"order_id":)" << e.order.order_id << "}}";
+            break;
+        case mirror_event::account_row:
+            ss << R"({"table":"account","scope":)" << str(e.user) << R"(,"row":{"id":0,"balance":{"quantity":)"
+               << str(e.account.balance.quantity) << R"(,"contract":)" << str(e.account.balance.contract) << "}}}";
+            break;
+    }
+    return ss.str();
+}
+
+static void apply(book_mirror &mirror, const mirror_event &e) {
+    switch (e.kind) {
+        case mirror_event::book_chunk:    mirror.on_book_chunk(e.sympair_id, e.last_deal_id, e.orders); break;
+        case mirror_event::order_row:     mirror.on_order(e.order); break;
+        case mirror_event::deal_row:      mirror.on_deal(e.deal); break;
+        case mirror_event::cancel_action: mirror.on_cancel(e.order.order_id); break;
+        case mirror_event::account_row:   mirror.on_balance(e.user, e.account); break;
+    }
+}
+
+// the first difference of the books, orders and balances of a and b, empty if none
+static std::string compare(const book_mirror &a, const book_mirror &b) {
+    if (a.orders().size() != b.orders().size()) return "open orders";
+    if (a.balances() != b.balances()) return "balances";
+    for (const auto &[sympair_id, book] : a.books()) {
+        const auto *other = b.book(sympair_id);
+        if (!other) return "sympair " + std::to_string(sympair_id);
+        for (auto [x, y] : {std::make_pair(&book.bids, &other->bids), std::make_pair(&book.asks, &other->asks)}) {
+            const auto &lx = x->levels(), &ly = y->levels();
+            if (lx.size() != ly.size()) return "levels of sympair " + std::to_string(sympair_id);
+            for (size_t i = 0; i < lx.size(); i++) {
+                if (lx[i].price != ly[i].price || lx[i].quant != ly[i].quant || lx[i].orders != ly[i].orders)
+                    return "level " + std::to_string(i) + " of sympair " + std::to_string(sympair_id);
+            }
+        }
+        if (book.deals.size() != other->deals.size()) return "deals of sympair " + std::to_string(sympair_id);
+    }
+    return "";
+}
+
+static void usage(const char *prog) {
+    std::fprintf(stderr,
+        "Usage: %s [OPTION]...\n"
+        "  --depth N          open orders per side of the bootstrap (default 10000)\n"
+        "  --events N         events after the bootstrap (default 1000000)\n"
+        "  --pairs N          symbol pairs (default 4)\n"
+        "  --spread N         orders are placed within N ticks of the mid price (default 500)\n"
+        "  --seed N           random seed (default 1)\n"
+        "  --csv              print one csv header and row\n",
+        prog);
+}
+
+int main(int argc, char **argv) {
+    bench_config conf;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--csv") {
+            conf.csv = true;
+        } else if (arg == "--depth" && has_value) {
+            conf.depth = std::stoul(argv[++i]);
+        } else if (arg == "--events" && has_value) {
+            conf.events = std::stoul(argv[++i]);
+        } else if (arg == "--pairs" && has_value) {
+            conf.pairs = std::stoul(argv[++i]);
+        } else if (arg == "--spread" && has_value) {
+            conf.spread = std::stoul(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            conf.seed = std::stoull(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (conf.pairs == 0 || conf.spread == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    auto events = event_generator(conf).generate();
+    std::vector<std::string> lines;
+    lines.reserve(events.size());
+    for (const auto &e : events) lines.push_back(to_json(e));
+
+    book_mirror struct_mirror, json_mirror;
+    double struct_seconds = 0, json_seconds = 0;
+    try {
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &e : events) apply(struct_mirror, e);
+        struct_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        json_reader reader;
+        start = std::chrono::steady_clock::now();
+        for (const auto &line : lines) apply_json_event(json_mirror, reader, line);
+        json_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "failed: %s\n", e.what());
+        return 1;
+    }
+
+    for (const auto &problem : {struct_mirror.verify(), json_mirror.verify(), compare(struct_mirror, json_mirror)}) {
+        if (!problem.empty()) {
+            std::fprintf(stderr, "mirror mismatch: %s\n", problem.c_str());
+            return 1;
+        }
+    }
+
+    size_t levels = 0;
+    for (const auto &[id, book] : struct_mirror.books()) levels += book.bids.levels().size() + book.asks.levels().size();
+    double struct_rate = struct_seconds > 0 ? events.size() / struct_seconds : 0;
+    double json_rate = json_seconds > 0 ? events.size() / json_seconds : 0;
+    if (conf.csv) {
+        std::printf("depth,events,pairs,open_orders,levels,struct_events_per_sec,json_events_per_sec\n");
+        std::printf("%u,%zu,%u,%zu,%zu,%.0f,%.0f\n", conf.depth, events.size(), conf.pairs,
+                    struct_mirror.orders().size(), levels, struct_rate, json_rate);
+        return 0;
+    }
+    std::printf("depth=%u events=%zu pairs=%u spread=%u seed=%llu\n", conf.depth, events.size(), conf.pairs,
+                conf.spread, (unsigned long long)conf.seed);
+    std::printf("open orders      : %zu (%zu bytes each)\n", struct_mirror.orders().size(), sizeof(open_order));
+    std::printf("price levels     : %zu (%zu bytes each)\n", levels, sizeof(price_level));
+    std::printf("struct events/s  : %.0f\n", struct_rate);
+    std::printf("json events/s    : %.0f\n", json_rate);
+    return 0;
+}
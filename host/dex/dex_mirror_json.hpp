@@ -0,0 +1,237 @@
+#pragma once
+
+/**
+ * Feeds a dex::mirror::book_mirror from JSON lines, one event per line, in the ABI JSON of the
+ * contract types as printed by nodeos, 64-bit integers either as numbers or as strings:
+ *
+ *   {"table":"order","scope":"dex","row":{...order_t...}}
+ *   {"table":"deal","scope":"dex","row":{...deal_item_t...}}
+ *   {"table":"account","scope":"<user>","row":{...account_t...}}
+ *   {"action":"bookchunk","data":{...bookchunk arguments...}}
+ *   {"action":"cancel","data":{"order_id":...}}
+ *
+ * The fields the mirror does not use are skipped, string escapes are kept as they are.
+ */
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "dex_mirror.hpp"
+
+namespace dex::mirror {
+
+    struct json_value {
+        enum kind_t : uint8_t { null_kind, bool_kind, number_kind, string_kind, array_kind, object_kind };
+
+        kind_t kind = null_kind;
+        std::string_view text;                // the number, the string without quotes, or true/false
+        std::vector<json_value> items;        // the items of an array, the values of an object
+        std::vector<std::string_view> keys;   // the keys of an object
+
+        // the value of key in an object, null if absent
+        const json_value &operator[](std::string_view key) const {
+            static const json_value null_value;
+            for (size_t i = 0; i < keys.size(); i++) {
+                if (keys[i] == key) return items[i];
+            }
+            return null_value;
+        }
+
+        bool is_null() const { return kind == null_kind; }
+
+        uint64_t as_uint() const {
+            check_kind(kind == number_kind || kind == string_kind, "integer");
+            uint64_t ret = 0;
+            for (char c : text) {
+                if (c < '0' || c > '9') throw std::runtime_error("invalid unsigned integer '" + std::string(text) + "'");
+                ret = ret * 10 + uint64_t(c - '0');
+            }
+            return ret;
+        }
+
+        int64_t as_int() const {
+            if (!text.empty() && text[0] == '-') {
+                json_value abs = *this;
+                abs.text.remove_prefix(1);
+                return -int64_t(abs.as_uint());
+            }
+            return int64_t(as_uint());
+        }
+
+        name as_name() const {
+            check_kind(kind == string_kind, "name");
+            return name(text);
+        }
+
+        asset as_asset() const {
+            check_kind(kind == string_kind, "asset");
+            return asset_from_string(text);
+        }
+
+    private:
+        void check_kind(bool ok, const char *expected) const {
+            if (!ok) throw std::runtime_error(std::string("expected a json ") + expected);
+        }
+    };
+
+    class json_reader {
+    public:
+        json_value parse(std::string_view text) {
+            _text = text;
+            _pos = 0;
+            json_value ret;
+            parse_value(ret);
+            skip_spaces();
+            if (_pos != _text.size()) fail("trailing characters");
+            return ret;
+        }
+
+    private:
+        void parse_value(json_value &v) {
+            skip_spaces();
+            if (_pos >= _text.size()) fail("unexpected end");
+            char c = _text[_pos];
+            if (c == '{') {
+                v.kind = json_value::object_kind;
+                _pos++;
+                if (consume('}')) return;
+                do {
+                    skip_spaces();
+                    v.keys.push_back(parse_string());
+                    skip_spaces();
+                    if (!consume(':')) fail("expected ':'");
+                    parse_value(v.items.emplace_back());
+                } while (consume(','));
+                if (!consume('}')) fail("expected '}'");
+            } else if (c == '[') {
+                v.kind = json_value::array_kind;
+                _pos++;
+                if (consume(']')) return;
+                do {
+                    parse_value(v.items.emplace_back());
+                } while (consume(','));
+                if (!consume(']')) fail("expected ']'");
+            } else if (c == '"') {
+                v.kind = json_value::string_kind;
+                v.text = parse_string();
+            } else {
+                size_t start = _pos;
+                while (_pos < _text.size() && std::string_view(",]} \t\r\n").find(_text[_pos]) == std::string_view::npos) _pos++;
+                v.text = _text.substr(start, _pos - start);
+                if (v.text == "null") {
+                    v.kind = json_value::null_kind;
+                } else if (v.text == "true" || v.text == "false") {
+                    v.kind = json_value::bool_kind;
+                } else if (!v.text.empty()) {
+                    v.kind = json_value::number_kind;
+                } else {
+                    fail("unexpected character");
+                }
+            }
+        }
+
+        std::string_view parse_string() {
+            if (!consume('"')) fail("expected '\"'");
+            size_t start = _pos;
+            while (_pos < _text.size() && _text[_pos] != '"') {
+                if (_text[_pos] == '\\') _pos++;
+                _pos++;
+            }
+            if (_pos >= _text.size()) fail("unterminated string");
+            return _text.substr(start, _pos++ - start);
+        }
+
+        bool consume(char c) {
+            skip_spaces();
+            if (_pos < _text.size() && _text[_pos] == c) {
+                _pos++;
+                return true;
+            }
+            return false;
+        }
+
+        void skip_spaces() {
+            while (_pos < _text.size() && (_text[_pos] == ' ' || _text[_pos] == '\t' || _text[_pos] == '\r' || _text[_pos] == '\n')) _pos++;
+        }
+
+        [[noreturn]] void fail(const char *msg) const {
+            throw std::runtime_error(std::string("json: ") + msg + " at " + std::to_string(_pos));
+        }
+
+        std::string_view _text;
+        size_t _pos = 0;
+    };
+
+    inline order_t order_from_json(const json_value &v) {
+        order_t o;
+        o.order_id = v["order_id"].as_uint();
+        o.owner = v["owner"].as_name();
+        o.sympair_id = v["sympair_id"].as_uint();
+        o.order_type = v["order_type"].as_name();
+        o.order_side = v["order_side"].as_name();
+        o.price = v["price"].as_asset();
+        o.limit_quant = v["limit_quant"].as_asset();
+        o.matched_assets = v["matched_assets"].as_asset();
+        o.matched_coins = v["matched_coins"].as_asset();
+        o.status = v["status"].as_name();
+        o.last_deal_id = v["last_deal_id"].as_uint();
+        return o;
+    }
+
+    inline deal_item_t deal_from_json(const json_value &v) {
+        deal_item_t d;
+        d.id = v["id"].as_uint();
+        d.sympair_id = v["sympair_id"].as_uint();
+        d.buy_order_id = v["buy_order_id"].as_uint();
+        d.sell_order_id = v["sell_order_id"].as_uint();
+        d.deal_assets = v["deal_assets"].as_asset();
+        d.deal_coins = v["deal_coins"].as_asset();
+        d.deal_price = v["deal_price"].as_asset();
+        d.taker_side = v["taker_side"].as_name();
+        return d;
+    }
+
+    inline book_order_t book_order_from_json(const json_value &v) {
+        return book_order_t{v["order_id"].as_uint(), v["owner"].as_name(), v["order_type"].as_name(),
+                            v["order_side"].as_name(), v["price"].as_int(), v["limit_quant"].as_int(),
+                            v["matched_assets"].as_int(), v["matched_coins"].as_int()};
+    }
+
+    /**
+     * Applies the event of one JSON line to mirror
+     * @return false if the table or the action of the event is not followed by the mirror
+     */
+    inline bool apply_json_event(book_mirror &mirror, json_reader &reader, std::string_view line) {
+        json_value event = reader.parse(line);
+        const auto &table = event["table"];
+        if (!table.is_null()) {
+            const auto &row = event["row"];
+            if (table.text == "order") {
+                mirror.on_order(order_from_json(row));
+            } else if (table.text == "deal") {
+                mirror.on_deal(deal_from_json(row));
+            } else if (table.text == "account") {
+                const auto &balance = row["balance"];
+                account_t account{row["id"].as_uint(),
+                                  extended_asset(balance["quantity"].as_asset(), balance["contract"].as_name())};
+                mirror.on_balance(event["scope"].as_name(), account);
+            } else {
+                return false;
+            }
+            return true;
+        }
+        const auto &action = event["action"];
+        const auto &data = event["data"];
+        if (action.text == "bookchunk") {
+            std::vector<book_order_t> orders;
+            for (const auto &o : data["orders"].items) orders.push_back(book_order_from_json(o));
+            mirror.on_book_chunk(data["sympair_id"].as_uint(), data["last_deal_id"].as_uint(), orders);
+        } else if (action.text == "cancel") {
+            mirror.on_cancel(data["order_id"].as_uint());
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+}// namespace dex::mirror
@@ -0,0 +1,754 @@
+/**
+ * Deterministic replay of DEX order flow, natively.
+ *
+ * Compiles dex.cpp against the in-memory eosio stand-ins and replays a stream of actions
+ * (deposit, neworder, cancel, match, withdraw, ...) through dex_contract, one host transaction
+ * per action: a failed action is reverted like on chain. It reports throughput and can write
+ * every fill, failure, inline transfer and the final book and balances to a file, so two builds
+ * of the contract can be compared line by line with --compare.
+ *
+ * Stream format, one action per line, '#' starts a comment, assets are written "1.0000 USD":
+ *   account <name>...
+ *   block [count]
+ *   setconfig <admin> <fee_collector> <maker_fee_ratio> <taker_fee_ratio> <max_match_count>
+ *   setsympair <precision,CODE@bank> <precision,CODE@bank> <min_asset_quant> <min_coin_quant> <only_accept_coin_fee> <enabled>
+ *   deposit <user> <bank> <quantity>
+ *   withdraw <user> <to> <bank> <quantity>
+ *   neworder <user> <sympair_id> <limit|market> <buy|sell> <limit_quant> <price> <external_id>
+ *   cancel <owner> <order_id>
+ *   match <matcher> <max_count> <sympair_id,...|*>
+ *   cleandata <max_count>
+ *   setpool <sympair_id> <fee_ratio> <enabled>
+ *   addliquidity <user> <sympair_id> <asset_quant> <coin_quant>
+ *   rmliquidity <user> <sympair_id> <shares>
+ *   setauction <sympair_id> <interval_blocks> <enabled>
+ *   clear <matcher> <sympair_id> <max_count>
+ *   routeorder <user> <sympair_id,...> <bank> <quantity> <min_output_bank> <min_output>
+ *   newtrigger <user> <sympair_id> <stop|takeprofit> <trigger_price> <limit|market> <buy|sell> <limit_quant> <price> <external_id>
+ *   canceltrig <owner> <trigger_id>
+ *   setrelaykey <user>
+ *   relayorders <user> <sympair_id> <limit|market> <buy|sell> <limit_quant> <price> <external_id> <nonce> [| <user> ...]
+ *   snapshot <sympair_id> <max_count>
+ *
+ * setrelaykey registers the host key of user, see eosio::host::make_public_key, and relayorders
+ * signs its orders with it. snapshot resumes after the last bookchunk of the previous snapshot of
+ * the symbol pair until one completes, then starts over.
+ */
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The contract is one translation unit, like for eosio-cpp: its headers define non-inline
+// functions, so dex.cpp of the contract directory chosen by the build is included here.
+#include DEX_CONTRACT_SOURCE
+
+using namespace dex;
+
+static const name DEX_ACCOUNT = "dex"_n;
+static const name BANK = "eosio.token"_n;
+
+struct replay_action {
+    size_t line = 0;
+    name action;
+    name first_receiver = DEX_ACCOUNT;
+    name authorizer;
+    std::optional<extended_asset> deposit;      // the transfer notified to the contract
+    std::function<void()> host_op;              // account and block directives
+    std::function<void(dex_contract &)> apply;  // contract actions
+};
+
+class stream_parser {
+public:
+    std::vector<replay_action> parse(std::istream &in) {
+        std::vector<replay_action> actions;
+        std::string line;
+        size_t line_no = 0;
+        while (std::getline(in, line)) {
+            line_no++;
+            auto comment = line.find('#');
+            if (comment != std::string::npos) line.erase(comment);
+            _tokens.clear();
+            _pos = 0;
+            std::istringstream ss(line);
+            for (std::string tok; ss >> tok;) _tokens.push_back(tok);
+            if (_tokens.empty()) continue;
+
+            _line_no = line_no;
+            actions.push_back(parse_action());
+            actions.back().line = line_no;
+        }
+        return actions;
+    }
+
+private:
+    replay_action parse_action() {
+        replay_action a;
+        auto cmd = next();
+        a.action = name(cmd);
+        if (cmd == "account") {
+            std::vector<name> names;
+            while (!done()) names.push_back(next_name());
+            a.host_op = [names]() {
+                for (const auto &n : names) eosio::host::create_account(n);
+            };
+        } else if (cmd == "block") {
+            uint64_t count = done() ? 1 : next_uint();
+            a.host_op = [count]() {
+                for (uint64_t i = 0; i < count; i++) eosio::host::produce_block();
+            };
+        } else if (cmd == "setconfig") {
+            dex::config conf = {true, next_name(), next_name(), (int64_t)next_uint(), (int64_t)next_uint(),
+                                (uint32_t)next_uint(), false, DATA_RECYCLE_SEC};
+            _admin = conf.dex_admin;
+            a.authorizer = DEX_ACCOUNT;
+            a.apply = [conf](dex_contract &c) { c.setconfig(conf); };
+        } else if (cmd == "setsympair") {
+            auto asset_sym = next_extended_symbol();
+            auto coin_sym = next_extended_symbol();
+            auto min_asset_quant = next_asset();
+            auto min_coin_quant = next_asset();
+            bool only_accept_coin_fee = next_uint() != 0;
+            bool enabled = next_uint() != 0;
+            a.authorizer = _admin;
+            a.apply = [=](dex_contract &c) {
+                c.setsympair(asset_sym, coin_sym, min_asset_quant, min_coin_quant, only_accept_coin_fee, enabled);
+            };
+        } else if (cmd == "deposit") {
+            auto user = next_name();
+            a.first_receiver = next_name();
+            auto quant = next_asset();
+            a.deposit = extended_asset(quant, a.first_receiver);
+            a.apply = [=](dex_contract &c) { c.ontransfer(user, DEX_ACCOUNT, quant, ""); };
+        } else if (cmd == "withdraw") {
+            auto user = next_name();
+            auto to = next_name();
+            auto bank = next_name();
+            auto quant = next_asset();
+            a.authorizer = user;
+            a.apply = [=](dex_contract &c) { c.withdraw(user, to, bank, quant, ""); };
+        } else if (cmd == "neworder") {
+            auto user = next_name();
+            auto sympair_id = next_uint();
+            auto type = next_name();
+            auto side = next_name();
+            auto limit_quant = next_asset();
+            auto price = next_asset();
+            auto external_id = next_uint();
+            a.authorizer = user;
+            a.apply = [=](dex_contract &c) {
+                c.neworder(user, sympair_id, type, side, limit_quant, limit_quant, price, external_id, std::nullopt);
+            };
+        } else if (cmd == "cancel") {
+            a.authorizer = next_name();
+            auto order_id = next_uint();
+            a.apply = [=](dex_contract &c) { c.cancel(order_id); };
+        } else if (cmd == "match") {
+            auto matcher = next_name();
+            auto max_count = (uint32_t)next_uint();
+            std::vector<uint64_t> sym_pairs;
+            auto ids = next();
+            if (ids != "*") {
+                std::istringstream ss(ids);
+                for (std::string id; std::getline(ss, id, ',');) sym_pairs.push_back(std::stoull(id));
+            }
+            a.authorizer = matcher;
+            a.apply = [=](dex_contract &c) { c.match(matcher, max_count, sym_pairs, ""); };
+        } else if (cmd == "cleandata") {
+            auto max_count = next_uint();
+            a.apply = [=](dex_contract &c) { c.cleandata(max_count); };
+        } else if (cmd == "setpool") {
+            auto sympair_id = next_uint();
+            auto fee_ratio = (int64_t)next_uint();
+            bool enabled = next_uint() != 0;
+            a.authorizer = _admin;
+            a.apply = [=](dex_contract &c) { c.setpool(sympair_id, fee_ratio, enabled); };
+        } else if (cmd == "addliquidity") {
+            auto user = next_name();
+            auto sympair_id = next_uint();
+            auto asset_quant = next_asset();
+            auto coin_quant = next_asset();
+            a.authorizer = user;
+            a.apply = [=](dex_contract &c) { c.addliquidity(user, sympair_id, asset_quant, coin_quant); };
+        } else if (cmd == "rmliquidity") {
+            auto user = next_name();
+            auto sympair_id = next_uint();
+            auto shares = next_uint();
+            a.authorizer = user;
+            a.apply = [=](dex_contract &c) { c.rmliquidity(user, sympair_id, shares); };
+        } else if (cmd == "routeorder") {
+            auto user = next_name();
+            std::vector<uint64_t> path;
+            std::istringstream ss(next());
+            for (std::string id; std::getline(ss, id, ',');) path.push_back(std::stoull(id));
+            auto bank = next_name();
+            auto quantity = extended_asset(next_asset(), bank);
+            auto min_output_bank = next_name();
+            auto min_output = extended_asset(next_asset(), min_output_bank);
+            a.authorizer = user;
+            a.apply = [=](dex_contract &c) { c.routeorder(user, path, quantity, min_output); };
+        } else if (cmd == "newtrigger") {
+            auto user = next_name();
+            auto sympair_id = next_uint();
+            auto trigger_type = next_name();
+            auto trigger_price = next_asset();
+            auto type = next_name();
+            auto side = next_name();
+            auto limit_quant = next_asset();
+            auto price = next_asset();
+            auto external_id = next_uint();
+            a.authorizer = user;
+            a.apply = [=](dex_contract &c) {
+                c.newtrigger(user, sympair_id, trigger_type, trigger_price, type, side, limit_quant, price, external_id);
+            };
+        } else if (cmd == "canceltrig") {
+            a.authorizer = next_name();
+            auto trigger_id = next_uint();
+            a.apply = [=](dex_contract &c) { c.canceltrig(trigger_id); };
+        } else if (cmd == "setrelaykey") {
+            auto user = next_name();
+            a.authorizer = user;
+            a.apply = [=](dex_contract &c) { c.setrelaykey(user, eosio::host::make_public_key(user)); };
+        } else if (cmd == "relayorders") {
+            std::vector<relay_order_t> orders;
+            do {
+                relay_order_t order;
+                order.user = next_name();
+                order.sympair_id = next_uint();
+                order.order_type = next_name();
+                order.order_side = next_name();
+                order.limit_quant = next_asset();
+                order.price = next_asset();
+                order.external_id = next_uint();
+                order.nonce = next_uint();
+                order.sig = eosio::host::sign(make_relay_order_digest(eosio::get_chain_id(), DEX_ACCOUNT, order),
+                                              eosio::host::make_public_key(order.user));
+                orders.push_back(order);
+            } while (!done() && next() == "|");
+            a.authorizer = _admin;
+            a.apply = [=](dex_contract &c) { c.relayorders(orders); };
+        } else if (cmd == "setauction") {
+            auto sympair_id = next_uint();
+            auto interval_blocks = (uint32_t)next_uint();
+            bool enabled = next_uint() != 0;
+            a.authorizer = _admin;
+            a.apply = [=](dex_contract &c) { c.setauction(sympair_id, interval_blocks, enabled); };
+        } else if (cmd == "clear") {
+            auto matcher = next_name();
+            auto sympair_id = next_uint();
+            auto max_count = (uint32_t)next_uint();
+            a.authorizer = matcher;
+            a.apply = [=](dex_contract &c) { c.clear(matcher, sympair_id, max_count, ""); };
+        } else if (cmd == "snapshot") {
+            auto sympair_id = next_uint();
+            auto max_count = (uint32_t)next_uint();
+            auto cursors = _snapshot_cursors;
+            a.apply = [=](dex_contract &c) {
+                auto &cursor = (*cursors)[sympair_id];
+                c.snapshot(sympair_id, cursor, max_count);
+                for (const auto &sent : eosio::host::sent_actions()) {
+                    if (sent.action == "bookchunk"_n)
+                        cursor = std::get<3>(std::any_cast<const dex_contract::bookchunk_action::args_type &>(sent.data));
+                }
+            };
+        } else {
+            fail("unknown action '" + cmd + "'");
+        }
+        if (!done()) fail("unexpected argument '" + next() + "'");
+        return a;
+    }
+
+    bool done() const { return _pos >= _tokens.size(); }
+
+    const std::string &next() {
+        if (done()) fail("missing argument");
+        return _tokens[_pos++];
+    }
+
+    name next_name() { return name(next()); }
+
+    uint64_t next_uint() { return std::stoull(next()); }
+
+    asset next_asset() {
+        auto amount = next();
+        return asset_from_string(amount + " " + next());
+    }
+
+    // precision,CODE@bank
+    extended_symbol next_extended_symbol() {
+        const auto &s = next();
+        auto comma = s.find(',');
+        auto at = s.find('@');
+        if (comma == std::string::npos || at == std::string::npos || at < comma) fail("invalid extended symbol '" + s + "'");
+        symbol sym(std::string_view(s).substr(comma + 1, at - comma - 1), (uint8_t)std::stoul(s.substr(0, comma)));
+        return extended_symbol{sym, name(std::string_view(s).substr(at + 1))};
+    }
+
+    [[noreturn]] void fail(const std::string &msg) const {
+        throw std::runtime_error("line " + std::to_string(_line_no) + ": " + msg);
+    }
+
+    std::vector<std::string> _tokens;
+    size_t _pos = 0;
+    size_t _line_no = 0;
+    name _admin = DEX_ACCOUNT;
+    std::shared_ptr<std::map<uint64_t, std::optional<book_cursor_t>>> _snapshot_cursors =
+        std::make_shared<std::map<uint64_t, std::optional<book_cursor_t>>>();
+};
+
+struct generator_config {
+    uint64_t orders       = 100000;
+    uint32_t users        = 100;
+    uint32_t pairs        = 2;
+    uint64_t seed         = 1;
+    uint32_t cancel_pct   = 10; // of the actions
+    uint32_t withdraw_pct = 1;  // of the actions
+    uint32_t market_pct   = 10; // of the orders
+    uint32_t match_every  = 10; // actions between two match actions
+    uint32_t auto_match   = 0;  // max_match_count of the config, 0 matches by the match action only
+};
+
+/**
+ * Generates a random but reproducible order flow: users trade every symbol pair around a price
+ * that walks randomly, and cancel, withdraw and match in between. Quantities are whole lots and
+ * prices whole ticks, see dex_match_bench.cpp.
+ */
+class flow_generator {
+public:
+    static constexpr int64_t QUANT_LOT   = 100'0000;       // 0.01000000 asset
+    static constexpr int64_t PRICE_TICK  = 100;            // 0.0100 USD
+    static constexpr int64_t START_TICKS = 10000;          // 100.0000 USD
+    static constexpr int64_t USER_COINS  = 1'0000'0000'0000; // 100000000.0000 USD
+    static constexpr int64_t USER_ASSETS = 10'0000'0000'0000; // 100000.00000000 asset
+
+    explicit flow_generator(const generator_config &conf) : _conf(conf), _rng_state(conf.seed) {}
+
+    std::string generate() {
+        std::ostringstream out;
+        const symbol coin_sym("USD", 4);
+        out << "# dex_replay --generate " << _conf.orders << " --users " << _conf.users << " --pairs " << _conf.pairs
+            << " --seed " << _conf.seed << "\n";
+        out << "account dex dex.admin dex.fee dex.matcher " << BANK.to_string() << "\n";
+        for (uint32_t u = 0; u < _conf.users; u++) {
+            out << "account " << user(u).to_string() << "\n";
+        }
+        out << "setconfig dex.admin dex.fee 4 8 " << _conf.auto_match << "\n";
+        for (uint32_t p = 0; p < _conf.pairs; p++) {
+            auto asset_sym = pair_symbol(p);
+            out << "setsympair " << asset_sym.to_string() << "@" << BANK.to_string() << " " << coin_sym.to_string() << "@"
+                << BANK.to_string() << " " << asset(1, asset_sym).to_string() << " " << asset(1, coin_sym).to_string()
+                << " 0 1\n";
+            _mid_ticks.push_back(START_TICKS);
+        }
+        for (uint32_t u = 0; u < _conf.users; u++) {
+            out << "deposit " << user(u).to_string() << " " << BANK.to_string() << " " << asset(USER_COINS, coin_sym).to_string() << "\n";
+            for (uint32_t p = 0; p < _conf.pairs; p++) {
+                out << "deposit " << user(u).to_string() << " " << BANK.to_string() << " "
+                    << asset(USER_ASSETS, pair_symbol(p)).to_string() << "\n";
+            }
+        }
+        out << "block\n";
+
+        std::vector<uint32_t> order_owners(1); // order ids start at 1
+        for (uint64_t i = 0; i < _conf.orders; i++) {
+            auto u = (uint32_t)random(_conf.users);
+            auto roll = random(100);
+            if (roll < _conf.cancel_pct && order_owners.size() > 1) {
+                auto order_id = 1 + random(order_owners.size() - 1);
+                out << "cancel " << user(order_owners[order_id]).to_string() << " " << order_id << "\n";
+            } else if (roll < _conf.cancel_pct + _conf.withdraw_pct) {
+                out << "withdraw " << user(u).to_string() << " " << user(u).to_string() << " " << BANK.to_string() << " "
+                    << asset(10000, coin_sym).to_string() << "\n";
+            } else {
+                auto p = (uint32_t)random(_conf.pairs);
+                auto &mid = _mid_ticks[p];
+                mid = std::max<int64_t>(1000, mid + (int64_t)random(3) - 1);
+                bool is_buy = random(2) == 0;
+                bool is_market = random(100) < _conf.market_pct;
+                int64_t lots = 1 + (int64_t)random(100);
+                asset quant(lots * QUANT_LOT, pair_symbol(p));
+                asset price(0, coin_sym);
+                if (is_market) {
+                    if (is_buy) quant = asset(lots * mid * PRICE_TICK, coin_sym);
+                } else {
+                    price.amount = (mid + (int64_t)random(101) - 50) * PRICE_TICK;
+                }
+                out << "neworder " << user(u).to_string() << " " << (p + 1) << (is_market ? " market" : " limit")
+                    << (is_buy ? " buy " : " sell ") << quant.to_string() << " " << price.to_string() << " " << i << "\n";
+                order_owners.push_back(u);
+            }
+            if (_conf.match_every > 0 && (i + 1) % _conf.match_every == 0) {
+                out << "match dex.matcher " << DEX_MATCH_COUNT_MAX << " *\n";
+            }
+            if ((i + 1) % 20 == 0) {
+                out << "block\n";
+            }
+        }
+        return out.str();
+    }
+
+    static name user(uint32_t i) {
+        std::string s = "user";
+        for (int d = 0; d < 6; d++, i /= 26) s += char('a' + i % 26);
+        return name(s);
+    }
+
+    static symbol pair_symbol(uint32_t p) {
+        std::string code = "A";
+        for (int d = 0; d < 2; d++, p /= 26) code += char('A' + p % 26);
+        return symbol(code, 8);
+    }
+
+private:
+    // splitmix64, so that the stream does not depend on the standard library distributions
+    uint64_t random(uint64_t bound) {
+        uint64_t z = (_rng_state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return (z ^ (z >> 31)) % bound;
+    }
+
+    const generator_config &_conf;
+    uint64_t _rng_state;
+    std::vector<int64_t> _mid_ticks;
+};
+
+struct replay_result {
+    uint64_t actions = 0;
+    uint64_t failed = 0;
+    uint64_t orders = 0;
+    uint64_t fills = 0;
+    double seconds = 0;
+    eosio::host::db_stats db;
+};
+
+/**
+ * Replays the actions and writes the observable results: fills, failures, inline transfers,
+ * then the final orders and balances.
+ */
+class replayer {
+public:
+    explicit replayer(std::ostream *out) : _out(out) {}
+
+    replay_result run(const std::vector<replay_action> &actions) {
+        eosio::host::reset_database();
+        replay_result result;
+        for (const auto &a : actions) {
+            if (a.host_op) {
+                a.host_op();
+                continue;
+            }
+            result.actions++;
+            if (execute(a, result)) {
+                if (a.action == "neworder"_n) result.orders++;
+                record_effects(a, result);
+            } else {
+                result.failed++;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @return the problems found: every token must be accounted for by deposits, withdrawals,
+     * balances and the unmatched frozen quantities of open orders
+     */
+    std::vector<std::string> check_conservation() {
+        std::map<std::pair<name, symbol>, int64_t> held;
+        for (const auto &user : eosio::host::accounts()) {
+            auto account_tbl = make_account_table(DEX_ACCOUNT, user);
+            for (const auto &a : account_tbl) {
+                held[{a.balance.contract, a.balance.quantity.symbol}] += a.balance.quantity.amount;
+            }
+        }
+        auto sympair_tbl = make_sympair_table(DEX_ACCOUNT);
+        auto order_tbl = make_order_table(DEX_ACCOUNT);
+        for (const auto &o : order_tbl) {
+            if (o.status != order_status::MATCHABLE) continue;
+            const auto &sym_pair = sympair_tbl.get(o.sympair_id);
+            if (o.order_side == order_side::BUY) {
+                auto frozen_coins = o.frozen_quant - o.matched_coins;
+                if (o.matched_fee.symbol == o.frozen_quant.symbol) frozen_coins -= o.matched_fee; // coin fee
+                held[{sym_pair.coin_symbol.get_contract(), o.frozen_quant.symbol}] += frozen_coins.amount;
+            } else {
+                held[{sym_pair.asset_symbol.get_contract(), o.frozen_quant.symbol}] += (o.frozen_quant - o.matched_assets).amount;
+            }
+        }
+        auto trigger_tbl = make_trigger_table(DEX_ACCOUNT);
+        for (const auto &t : trigger_tbl) {
+            const auto &sym_pair = sympair_tbl.get(t.sympair_id);
+            const auto &bank = (t.order_side == order_side::BUY) ? sym_pair.coin_symbol.get_contract() :
+                    sym_pair.asset_symbol.get_contract();
+            held[{bank, t.frozen_quant.symbol}] += t.frozen_quant.amount;
+        }
+        auto pool_tbl = make_pool_table(DEX_ACCOUNT);
+        for (const auto &p : pool_tbl) {
+            const auto &sym_pair = sympair_tbl.get(p.sympair_id);
+            held[{sym_pair.asset_symbol.get_contract(), p.asset_reserve.symbol}] += p.asset_reserve.amount;
+            held[{sym_pair.coin_symbol.get_contract(), p.coin_reserve.symbol}] += p.coin_reserve.amount;
+        }
+
+        std::vector<std::string> problems;
+        auto expected = _deposited;
+        for (const auto &w : _withdrawn) expected[w.first] -= w.second;
+        for (const auto &h : held) expected.try_emplace(h.first, 0);
+        for (const auto &e : expected) {
+            auto h = held[e.first];
+            if (h != e.second) {
+                problems.push_back(e.first.first.to_string() + " " + e.first.second.to_string() + ": held " +
+                                   std::to_string(h) + " != deposited - withdrawn " + std::to_string(e.second));
+            }
+        }
+        return problems;
+    }
+
+    void write_final_state() {
+        if (!_out) return;
+        auto order_tbl = make_order_table(DEX_ACCOUNT);
+        for (const auto &o : order_tbl) {
+            *_out << "order " << o.order_id << " " << o.owner.to_string() << " " << o.status.to_string() << " "
+                  << o.matched_assets.to_string() << " " << o.matched_coins.to_string() << " " << o.matched_fee.to_string()
+                  << " " << o.last_deal_id << "\n";
+        }
+        for (const auto &user : eosio::host::accounts()) {
+            auto account_tbl = make_account_table(DEX_ACCOUNT, user);
+            for (const auto &a : account_tbl) {
+                *_out << "balance " << user.to_string() << " " << a.balance.to_string() << "\n";
+            }
+        }
+    }
+
+private:
+    bool execute(const replay_action &a, replay_result &result) {
+        auto &authorizers = eosio::host::authorizers();
+        authorizers.clear();
+        if (a.authorizer.value) authorizers.insert(a.authorizer);
+        eosio::host::sent_actions().clear();
+
+        auto db_before = eosio::host::stats();
+        auto start = std::chrono::steady_clock::now();
+        bool ok = true;
+        try {
+            eosio::host::transaction_session trx;
+            {
+                dex_contract contract(DEX_ACCOUNT, a.first_receiver, eosio::datastream<const char *>(nullptr, 0));
+                a.apply(contract);
+            }
+            trx.commit();
+        } catch (const eosio::check_failure &e) {
+            ok = false;
+            if (_out) *_out << "failed " << a.line << " " << a.action.to_string() << ": " << e.what() << "\n";
+        }
+        result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto db_diff = eosio::host::stats() - db_before;
+        result.db.finds += db_diff.finds;
+        result.db.lower_bounds += db_diff.lower_bounds;
+        result.db.upper_bounds += db_diff.upper_bounds;
+        result.db.nexts += db_diff.nexts;
+        result.db.previouses += db_diff.previouses;
+        result.db.stores += db_diff.stores;
+        result.db.updates += db_diff.updates;
+        result.db.removes += db_diff.removes;
+        return ok;
+    }
+
+    void record_effects(const replay_action &a, replay_result &result) {
+        if (a.deposit) {
+            _deposited[{a.deposit->contract, a.deposit->quantity.symbol}] += a.deposit->quantity.amount;
+        }
+
+        auto deal_tbl = make_deal_table(DEX_ACCOUNT);
+        for (auto it = deal_tbl.find(_last_deal_id + 1); it != deal_tbl.end(); it = deal_tbl.find(_last_deal_id + 1)) {
+            _last_deal_id = it->id;
+            result.fills++;
+            if (_out) {
+                *_out << "deal " << it->id << " " << it->sympair_id << " " << it->buy_order_id << " " << it->sell_order_id
+                      << " " << it->deal_assets.to_string() << " " << it->deal_coins.to_string() << " "
+                      << it->deal_price.to_string() << " " << it->taker_side.to_string() << " " << it->buy_fee.to_string()
+                      << " " << it->sell_fee.to_string() << " " << it->buy_refund_coins.to_string() << "\n";
+            }
+        }
+
+        for (const auto &sent : eosio::host::sent_actions()) {
+            if (sent.action == "bookchunk"_n) {
+                write_bookchunk(std::any_cast<const dex_contract::bookchunk_action::args_type &>(sent.data));
+                continue;
+            }
+            if (sent.action != "transfer"_n) continue;
+            const auto &args = std::any_cast<const token::transfer_action::args_type &>(sent.data);
+            const auto &quant = std::get<2>(args);
+            _withdrawn[{sent.account, quant.symbol}] += quant.amount;
+            if (_out) {
+                *_out << "transfer " << sent.account.to_string() << " " << std::get<0>(args).to_string() << " "
+                      << std::get<1>(args).to_string() << " " << quant.to_string() << "\n";
+            }
+        }
+    }
+
+    void write_bookchunk(const dex_contract::bookchunk_action::args_type &args) {
+        if (!_out) return;
+        const auto &[sympair_id, last_deal_id, orders, next_cursor] = args;
+        *_out << "bookchunk " << sympair_id << " " << last_deal_id << " " << orders.size() << " "
+              << (next_cursor ? std::to_string(next_cursor->order_id) : "end") << "\n";
+        for (const auto &o : orders) {
+            *_out << "book " << o.order_id << " " << o.owner.to_string() << " " << o.order_type.to_string() << " "
+                  << o.order_side.to_string() << " " << o.price << " " << o.limit_quant << " " << o.matched_assets
+                  << " " << o.matched_coins << "\n";
+        }
+    }
+
+    std::ostream *_out;
+    uint64_t _last_deal_id = 0;
+    std::map<std::pair<name, symbol>, int64_t> _deposited;
+    std::map<std::pair<name, symbol>, int64_t> _withdrawn;
+};
+
+/**
+ * @return 0 if the files are identical, otherwise prints the first difference
+ */
+static int compare_files(const std::string &path_a, const std::string &path_b) {
+    std::ifstream a(path_a), b(path_b);
+    if (!a || !b) {
+        std::fprintf(stderr, "can not open %s\n", !a ? path_a.c_str() : path_b.c_str());
+        return 2;
+    }
+    std::string line_a, line_b;
+    for (uint64_t line = 1;; line++) {
+        bool has_a = bool(std::getline(a, line_a));
+        bool has_b = bool(std::getline(b, line_b));
+        if (!has_a && !has_b) {
+            std::printf("identical: %llu lines\n", (unsigned long long)(line - 1));
+            return 0;
+        }
+        if (has_a != has_b || line_a != line_b) {
+            std::printf("first difference at line %llu\n", (unsigned long long)line);
+            std::printf("< %s\n", has_a ? line_a.c_str() : "<end of file>");
+            std::printf("> %s\n", has_b ? line_b.c_str() : "<end of file>");
+            return 1;
+        }
+    }
+}
+
+static void usage(const char *prog) {
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --input <file>       replay the action stream in <file>\n"
+        "  --generate <n>       replay a generated stream of <n> actions, the default\n"
+        "  --users <n>          generated users (default 100)\n"
+        "  --pairs <n>          generated symbol pairs (default 2)\n"
+        "  --seed <n>           generator seed (default 1)\n"
+        "  --cancel-pct <n>     generated cancels in percent of the actions (default 10)\n"
+        "  --market-pct <n>     generated market orders in percent of the orders (default 10)\n"
+        "  --match-every <n>    actions between generated match actions (default 10)\n"
+        "  --auto-match <n>     max_match_count of the generated config (default 0)\n"
+        "  --write-stream <f>   save the generated stream to <f>\n"
+        "  --out <file>         write fills, failures, transfers, final orders and balances to <file>\n"
+        "  --check              verify that the tokens held by the contract match deposits minus withdrawals\n"
+        "  --csv                print the summary as a csv row\n"
+        "  --compare <a> <b>    compare two --out files of different builds\n",
+        prog);
+}
+
+int main(int argc, char **argv) {
+    generator_config gen_conf;
+    std::string input, stream_out, out_path;
+    bool check = false, csv = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--compare" && i + 2 < argc) {
+            return compare_files(argv[i + 1], argv[i + 2]);
+        } else if (arg == "--check") {
+            check = true;
+        } else if (arg == "--csv") {
+            csv = true;
+        } else if (arg == "--input" && has_value) {
+            input = argv[++i];
+        } else if (arg == "--generate" && has_value) {
+            gen_conf.orders = std::stoull(argv[++i]);
+        } else if (arg == "--users" && has_value) {
+            gen_conf.users = std::stoul(argv[++i]);
+        } else if (arg == "--pairs" && has_value) {
+            gen_conf.pairs = std::stoul(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            gen_conf.seed = std::stoull(argv[++i]);
+        } else if (arg == "--cancel-pct" && has_value) {
+            gen_conf.cancel_pct = std::stoul(argv[++i]);
+        } else if (arg == "--market-pct" && has_value) {
+            gen_conf.market_pct = std::stoul(argv[++i]);
+        } else if (arg == "--match-every" && has_value) {
+            gen_conf.match_every = std::stoul(argv[++i]);
+        } else if (arg == "--auto-match" && has_value) {
+            gen_conf.auto_match = std::stoul(argv[++i]);
+        } else if (arg == "--write-stream" && has_value) {
+            stream_out = argv[++i];
+        } else if (arg == "--out" && has_value) {
+            out_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (gen_conf.users == 0 || gen_conf.pairs == 0 || gen_conf.pairs > 26 * 26) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<replay_action> actions;
+    try {
+        if (!input.empty()) {
+            std::ifstream in(input);
+            if (!in) {
+                std::fprintf(stderr, "can not open %s\n", input.c_str());
+                return 1;
+            }
+            actions = stream_parser().parse(in);
+        } else {
+            auto stream = flow_generator(gen_conf).generate();
+            if (!stream_out.empty()) std::ofstream(stream_out) << stream;
+            std::istringstream in(stream);
+            actions = stream_parser().parse(in);
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "invalid stream: %s\n", e.what());
+        return 1;
+    }
+
+    std::unique_ptr<std::ofstream> out;
+    if (!out_path.empty()) out = std::make_unique<std::ofstream>(out_path);
+
+    replayer replay(out.get());
+    auto result = replay.run(actions);
+    replay.write_final_state();
+
+    double actions_per_sec = result.seconds > 0 ? result.actions / result.seconds : 0;
+    double fills_per_sec = result.seconds > 0 ? result.fills / result.seconds : 0;
+    double per_action = result.actions > 0 ? double(result.actions) : 1.0;
+    if (csv) {
+        std::printf("actions,failed,orders,fills,seconds,actions_per_sec,fills_per_sec,db_ops_per_action\n");
+        std::printf("%llu,%llu,%llu,%llu,%.3f,%.0f,%.0f,%.2f\n", (unsigned long long)result.actions,
+                    (unsigned long long)result.failed, (unsigned long long)result.orders, (unsigned long long)result.fills,
+                    result.seconds, actions_per_sec, fills_per_sec, result.db.total() / per_action);
+    } else {
+        std::printf("actions          : %llu (failed %llu)\n", (unsigned long long)result.actions, (unsigned long long)result.failed);
+        std::printf("orders           : %llu\n", (unsigned long long)result.orders);
+        std::printf("fills            : %llu\n", (unsigned long long)result.fills);
+        std::printf("contract time    : %.3f s\n", result.seconds);
+        std::printf("actions/sec      : %.0f\n", actions_per_sec);
+        std::printf("fills/sec        : %.0f\n", fills_per_sec);
+        std::printf("db ops/action    : %.2f (reads %.2f, writes %.2f)\n", result.db.total() / per_action,
+                    result.db.reads() / per_action, result.db.writes() / per_action);
+    }
+
+    if (check) {
+        auto problems = replay.check_conservation();
+        for (const auto &p : problems) std::fprintf(stderr, "conservation: %s\n", p.c_str());
+        if (!problems.empty()) return 1;
+    }
+    return 0;
+}
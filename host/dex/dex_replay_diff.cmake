@@ -0,0 +1,17 @@
+# Replays the same generated stream with two builds and fails on the first differing fill,
+# failure, transfer, order or balance.
+set(REPLAY_ARGS --generate 200000 --users 200 --pairs 3 --seed 7)
+
+execute_process(COMMAND ${REPLAY} ${REPLAY_ARGS} --out ${WORK_DIR}/replay_current.out RESULT_VARIABLE result)
+if(result)
+   message(FATAL_ERROR "replay of the current build failed")
+endif()
+execute_process(COMMAND ${BASELINE} ${REPLAY_ARGS} --out ${WORK_DIR}/replay_baseline.out RESULT_VARIABLE result)
+if(result)
+   message(FATAL_ERROR "replay of the baseline build failed")
+endif()
+execute_process(COMMAND ${REPLAY} --compare ${WORK_DIR}/replay_baseline.out ${WORK_DIR}/replay_current.out
+                RESULT_VARIABLE result)
+if(result)
+   message(FATAL_ERROR "the current build differs from the baseline")
+endif()
@@ -0,0 +1,159 @@
+/**
+ * Native benchmark of the per-fill arithmetic of the dex.
+ *
+ * A fill converts the deal assets into coins at the maker price, takes the maker and taker fees
+ * and, for a market buy, converts the remaining coins back into assets. This runs those four
+ * conversions over synthetic fills with the former multiply_decimal/divide_decimal of utils.hpp
+ * and with the fixed_point.hpp kernel, reports ns/fill for both and checks that they agree.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "dex_const.hpp"
+#include "fixed_point.hpp"
+
+using namespace dex;
+
+namespace legacy {
+
+    // verbatim from utils.hpp before fixed_point.hpp
+    template<typename T>
+    int128_t divide_decimal(int128_t a, int128_t b, int128_t precision) {
+        int128_t tmp = 10 * a * precision  / b;
+        CHECK(tmp >= std::numeric_limits<T>::min() && tmp <= std::numeric_limits<T>::max(),
+              "overflow exception of divide_decimal");
+        return (tmp + 5) / 10;
+    }
+
+    template<typename T>
+    int128_t multiply_decimal(int128_t a, int128_t b, int128_t precision) {
+        int128_t tmp = 10 * a * b / precision;
+        CHECK(tmp >= std::numeric_limits<T>::min() && tmp <= std::numeric_limits<T>::max(),
+              "overflow exception of multiply_decimal");
+        return (tmp + 5) / 10;
+    }
+
+}// namespace legacy
+
+struct fill_input {
+    int64_t asset_amount;   // deal assets, precision 8
+    int64_t price;          // maker price, precision 4
+    int64_t coin_amount;    // coins left of a market buy, precision 4
+    int64_t maker_ratio;
+    int64_t taker_ratio;
+};
+
+constexpr int64_t ASSET_PRECISION = 1'0000'0000;
+
+struct legacy_kernel {
+    static int64_t run(const fill_input &f) {
+        int64_t coins = legacy::multiply_decimal<int64_t>(f.asset_amount, f.price, ASSET_PRECISION);
+        int64_t maker_fee = legacy::multiply_decimal<int64_t>(coins, f.maker_ratio, RATIO_PRECISION);
+        int64_t taker_fee = legacy::multiply_decimal<int64_t>(f.asset_amount, f.taker_ratio, RATIO_PRECISION);
+        int64_t assets = legacy::divide_decimal<int64_t>(f.coin_amount, f.price, ASSET_PRECISION);
+        return coins ^ (maker_fee << 1) ^ (taker_fee << 2) ^ (assets << 3);
+    }
+};
+
+struct fixed_point_kernel {
+    static int64_t run(const fill_input &f) {
+        int64_t coins = mul_div_round(f.asset_amount, f.price, ASSET_PRECISION);
+        int64_t maker_fee = mul_div_round(coins, f.maker_ratio, RATIO_PRECISION);
+        int64_t taker_fee = mul_div_round(f.asset_amount, f.taker_ratio, RATIO_PRECISION);
+        int64_t assets = mul_div_round(f.coin_amount, ASSET_PRECISION, f.price);
+        return coins ^ (maker_fee << 1) ^ (taker_fee << 2) ^ (assets << 3);
+    }
+};
+
+static std::vector<fill_input> make_fills(uint32_t count, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    // log-uniform amounts from 1e-8 to 1e4 BTC, prices from 0.01 to 1e6 USD, market buys up to 1e7 USD
+    auto log_uniform = [&](int64_t lo, int64_t hi) {
+        std::uniform_real_distribution<double> dist(std::log(double(lo)), std::log(double(hi)));
+        return int64_t(std::exp(dist(rng)));
+    };
+    std::vector<fill_input> fills(count);
+    for (auto &f : fills) {
+        f.asset_amount = log_uniform(1, 10000'0000'0000LL);
+        f.price = log_uniform(100, 1000000'0000LL);
+        f.coin_amount = log_uniform(1, 10000000'0000LL);
+        f.maker_ratio = std::uniform_int_distribution<int64_t>(0, 30)(rng);
+        f.taker_ratio = std::uniform_int_distribution<int64_t>(0, 60)(rng);
+    }
+    return fills;
+}
+
+template<typename kernel_t>
+static double run(const std::vector<fill_input> &fills, uint32_t rounds, int64_t &checksum) {
+    checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (const auto &f : fills) checksum += kernel_t::run(f);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds * 1e9 / (double(fills.size()) * rounds);
+}
+
+static void usage(const char *prog) {
+    std::fprintf(stderr,
+        "Usage: %s [OPTION]...\n"
+        "  --fills N          synthetic fills (default 1000000)\n"
+        "  --rounds N         passes over the fills (default 10)\n"
+        "  --seed N           random seed (default 1)\n"
+        "  --csv              print one csv header and row\n",
+        prog);
+}
+
+int main(int argc, char **argv) {
+    uint32_t fill_count = 1000000;
+    uint32_t rounds = 10;
+    uint64_t seed = 1;
+    bool csv = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--csv") {
+            csv = true;
+        } else if (arg == "--fills" && has_value) {
+            fill_count = std::stoul(argv[++i]);
+        } else if (arg == "--rounds" && has_value) {
+            rounds = std::stoul(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            seed = std::stoull(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<fill_input> fills = make_fills(fill_count, seed);
+    int64_t legacy_sum = 0, fixed_point_sum = 0;
+    double legacy_ns = 0, fixed_point_ns = 0;
+    try {
+        legacy_ns = run<legacy_kernel>(fills, rounds, legacy_sum);
+        fixed_point_ns = run<fixed_point_kernel>(fills, rounds, fixed_point_sum);
+    } catch (const eosio::check_failure &e) {
+        std::fprintf(stderr, "check failed: %s\n", e.what());
+        return 1;
+    }
+    if (legacy_sum != fixed_point_sum) {
+        std::fprintf(stderr, "checksum mismatch: legacy %lld, fixed_point %lld\n", (long long)legacy_sum,
+                     (long long)fixed_point_sum);
+        return 1;
+    }
+
+    if (csv) {
+        std::printf("fills,rounds,legacy_ns_per_fill,fixed_point_ns_per_fill,speedup\n");
+        std::printf("%u,%u,%.2f,%.2f,%.2f\n", fill_count, rounds, legacy_ns, fixed_point_ns, legacy_ns / fixed_point_ns);
+        return 0;
+    }
+    std::printf("fills=%u rounds=%u seed=%llu\n", fill_count, rounds, (unsigned long long)seed);
+    std::printf("legacy      : %.2f ns/fill\n", legacy_ns);
+    std::printf("fixed_point : %.2f ns/fill\n", fixed_point_ns);
+    std::printf("speedup     : %.2fx\n", legacy_ns / fixed_point_ns);
+    return 0;
+}
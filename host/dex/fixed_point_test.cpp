@@ -0,0 +1,172 @@
+/**
+ * Edge-case test of the fixed-point kernel in fixed_point.hpp.
+ *
+ * Every function is checked against an exact 128-bit reference over the cross product of the
+ * boundary values (0, 1, the precisions, the ratio range, values around c, around 2^32, 2^62 and
+ * INT64_MAX), then over random operands of every magnitude. mul_div_round is also checked to be
+ * bit-identical to the multiply_decimal/divide_decimal it replaces wherever those did not overflow.
+ */
+#include <cstdio>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "dex_const.hpp"
+#include "fixed_point.hpp"
+
+using namespace dex;
+
+static const int64_t INT64_MAX_V = std::numeric_limits<int64_t>::max();
+
+// the former utils.hpp rounding: (10 * a * b / c + 5) / 10, failing if 10 * a * b / c is out of int64
+static bool legacy_mul_div(int64_t a, int64_t b, int64_t c, int64_t &ret) {
+    // 10 * a * b must not overflow int128 either
+    if (uint128_t(a) * uint64_t(b) > (uint128_t(std::numeric_limits<int128_t>::max()) / 10)) return false;
+    int128_t tmp = 10 * int128_t(a) * b / c;
+    if (tmp < std::numeric_limits<int64_t>::min() || tmp > INT64_MAX_V) return false;
+    ret = int64_t((tmp + 5) / 10);
+    return true;
+}
+
+enum class rounding { floor, ceil, round };
+
+static bool reference(rounding mode, int64_t a, int64_t b, int64_t c, int64_t &ret) {
+    uint128_t p = uint128_t(a) * uint64_t(b);
+    uint128_t q = 0;
+    switch (mode) {
+        case rounding::floor: q = p / uint64_t(c); break;
+        case rounding::ceil:  q = (p + uint64_t(c) - 1) / uint64_t(c); break;
+        case rounding::round: q = (2 * p + uint64_t(c)) / (2 * uint128_t(uint64_t(c))); break;
+    }
+    if (q > uint64_t(INT64_MAX_V)) return false;
+    ret = int64_t(q);
+    return true;
+}
+
+static bool kernel(rounding mode, int64_t a, int64_t b, int64_t c, int64_t &ret) {
+    try {
+        switch (mode) {
+            case rounding::floor: ret = mul_div_floor(a, b, c); break;
+            case rounding::ceil:  ret = mul_div_ceil(a, b, c); break;
+            case rounding::round: ret = mul_div_round(a, b, c); break;
+        }
+        return true;
+    } catch (const eosio::check_failure &) {
+        return false;
+    }
+}
+
+static const char *mode_name(rounding mode) {
+    switch (mode) {
+        case rounding::floor: return "mul_div_floor";
+        case rounding::ceil:  return "mul_div_ceil";
+        default:              return "mul_div_round";
+    }
+}
+
+struct test_stats {
+    uint64_t cases = 0;
+    uint64_t overflows = 0;
+    uint64_t legacy_cases = 0;
+    uint64_t failures = 0;
+};
+
+static void check_case(test_stats &stats, int64_t a, int64_t b, int64_t c) {
+    for (rounding mode : {rounding::floor, rounding::ceil, rounding::round}) {
+        int64_t expected = 0, actual = 0;
+        bool expected_ok = reference(mode, a, b, c, expected);
+        bool actual_ok = kernel(mode, a, b, c, actual);
+        ++stats.cases;
+        if (!expected_ok) ++stats.overflows;
+        if (expected_ok != actual_ok || (expected_ok && expected != actual)) {
+            if (++stats.failures <= 20)
+                std::printf("FAIL %s(%lld, %lld, %lld): expected %s%lld, actual %s%lld\n", mode_name(mode),
+                            (long long)a, (long long)b, (long long)c, expected_ok ? "" : "overflow ",
+                            (long long)expected, actual_ok ? "" : "overflow ", (long long)actual);
+        }
+        if (mode == rounding::round) {
+            int64_t legacy = 0;
+            if (legacy_mul_div(a, b, c, legacy)) {
+                ++stats.legacy_cases;
+                if (!actual_ok || legacy != actual) {
+                    if (++stats.failures <= 20)
+                        std::printf("FAIL legacy(%lld, %lld, %lld): legacy %lld, actual %s%lld\n", (long long)a,
+                                    (long long)b, (long long)c, (long long)legacy, actual_ok ? "" : "overflow ",
+                                    (long long)actual);
+                }
+            }
+        }
+    }
+}
+
+static std::vector<int64_t> boundary_values() {
+    std::set<int64_t> values;
+    auto add_around = [&](int64_t v) {
+        for (int64_t d = -1; d <= 1; d++) {
+            if ((d < 0 && v < -d) || (d > 0 && v > INT64_MAX_V - d)) continue;
+            values.insert(v + d);
+        }
+    };
+    int64_t p = 1;
+    for (int i = 0; i <= 18; i++) {
+        add_around(p);
+        add_around(p / 2);
+        add_around(p * 5);
+        if (i < 18) p *= 10;
+    }
+    add_around(0);
+    add_around(3);
+    add_around(7);
+    add_around(RATIO_PRECISION);
+    add_around(int64_t(1) << 31);
+    add_around(int64_t(1) << 32);
+    add_around(int64_t(1) << 62);
+    add_around(INT64_MAX_V / 2);
+    add_around(INT64_MAX_V);
+    add_around(3037000499LL);   // floor(sqrt(INT64_MAX))
+    add_around(4294967295LL);   // floor(sqrt(UINT64_MAX))
+    return std::vector<int64_t>(values.begin(), values.end());
+}
+
+int main() {
+    test_stats stats;
+
+    std::vector<int64_t> values = boundary_values();
+    for (int64_t a : values)
+        for (int64_t b : values)
+            for (int64_t c : values)
+                if (c > 0) check_case(stats, a, b, c);
+
+    // every remainder of the small divisors, where the rounding decisions are dense
+    for (int64_t c = 1; c <= 64; c++)
+        for (int64_t a = 0; a <= 256; a++)
+            for (int64_t b : {int64_t(1), int64_t(3), c, c - 1, c + 1, INT64_MAX_V / c})
+                if (b >= 0) check_case(stats, a, b, c);
+
+    std::mt19937_64 rng(1);
+    for (int i = 0; i < 1000000; i++) {
+        auto random_value = [&](bool positive) {
+            int bits = std::uniform_int_distribution<int>(0, 63)(rng);
+            int64_t v = int64_t(rng() >> (64 - bits - 1) >> 1);
+            return positive && v == 0 ? 1 : v;
+        };
+        check_case(stats, random_value(false), random_value(false), random_value(true));
+    }
+
+    // negative operands and non-positive divisors are rejected
+    for (auto [a, b, c] : {std::make_tuple(-1, 1, 1), std::make_tuple(1, -1, 1), std::make_tuple(1, 1, 0),
+                           std::make_tuple(1, 1, -1)}) {
+        int64_t ret = 0;
+        ++stats.cases;
+        if (kernel(rounding::round, a, b, c, ret)) {
+            ++stats.failures;
+            std::printf("FAIL mul_div_round(%d, %d, %d) should fail, actual %lld\n", a, b, c, (long long)ret);
+        }
+    }
+
+    std::printf("fixed_point_test: %llu cases, %llu overflows, %llu compared with the legacy rounding, %llu failures\n",
+                (unsigned long long)stats.cases, (unsigned long long)stats.overflows,
+                (unsigned long long)stats.legacy_cases, (unsigned long long)stats.failures);
+    return stats.failures == 0 ? 0 : 1;
+}
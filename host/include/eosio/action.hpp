@@ -0,0 +1,86 @@
+#pragma once
+
+#include <any>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "check.hpp"
+#include "host.hpp"
+#include "name.hpp"
+
+namespace eosio {
+
+    struct permission_level {
+        permission_level(name a, name p) : actor(a), permission(p) {}
+        permission_level() {}
+
+        name actor;
+        name permission;
+
+        friend bool operator==(const permission_level &a, const permission_level &b) {
+            return a.actor == b.actor && a.permission == b.permission;
+        }
+    };
+
+    inline bool has_auth(name n) { return host::authorizers().count(n) > 0; }
+
+    inline void require_auth(name n) {
+        check(has_auth(n), "missing authority of " + n.to_string());
+    }
+
+    inline void require_recipient(name) {}
+
+    namespace host {
+
+        /**
+         * An inline action sent by contract code, with its arguments as a tuple of the action
+         * parameter types.
+         */
+        struct sent_action {
+            name account;
+            name action;
+            std::vector<permission_level> authorization;
+            std::any data;
+        };
+
+        inline std::vector<sent_action> &sent_actions() {
+            static std::vector<sent_action> a;
+            return a;
+        }
+
+        template<typename F>
+        struct action_args;
+
+        template<typename C, typename R, typename... Args>
+        struct action_args<R (C::*)(Args...)> {
+            using type = std::tuple<std::decay_t<Args>...>;
+        };
+
+    }// namespace host
+
+    /**
+     * Stand-in for eosio::action_wrapper: send() appends to host::sent_actions() instead of
+     * scheduling the inline action.
+     */
+    template<name::raw Name, auto Action>
+    struct action_wrapper {
+        using args_type = typename host::action_args<decltype(Action)>::type;
+
+        static constexpr name action_name = name(Name);
+
+        action_wrapper(name code, std::vector<permission_level> &&perms) : code_name(code), permissions(std::move(perms)) {}
+
+        action_wrapper(name code, const permission_level &perm) : code_name(code), permissions({perm}) {}
+
+        template<typename... Args>
+        void send(Args &&...args) const {
+            host::sent_actions().push_back({code_name, action_name, permissions,
+                                            std::any(args_type(std::forward<Args>(args)...))});
+        }
+
+        name code_name;
+        std::vector<permission_level> permissions;
+    };
+
+}// namespace eosio
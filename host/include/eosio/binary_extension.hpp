@@ -0,0 +1,50 @@
+#pragma once
+
+#include <optional>
+#include <utility>
+#include "check.hpp"
+
+namespace eosio {
+
+    /**
+     * In-memory stand-in for eosio::binary_extension, rows are not serialized so it only has to hold
+     * the optional value.
+     */
+    template<typename T>
+    class binary_extension {
+    public:
+        binary_extension() = default;
+        binary_extension(const T &v) : _value(v) {}
+
+        bool has_value() const { return _value.has_value(); }
+
+        T &value() {
+            check(has_value(), "cannot get value of empty binary_extension");
+            return *_value;
+        }
+
+        const T &value() const {
+            check(has_value(), "cannot get value of empty binary_extension");
+            return *_value;
+        }
+
+        T value_or(const T &def = {}) const { return has_value() ? *_value : def; }
+
+        T &operator*() { return value(); }
+        const T &operator*() const { return value(); }
+        T *operator->() { return &value(); }
+        const T *operator->() const { return &value(); }
+
+        template<typename... Args>
+        binary_extension &emplace(Args &&... args) {
+            _value.emplace(std::forward<Args>(args)...);
+            return *this;
+        }
+
+        void reset() { _value.reset(); }
+
+    private:
+        std::optional<T> _value;
+    };
+
+} // namespace eosio
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace eosio {
+
+    /**
+     * Thrown in place of eosio_assert when contract code runs natively.
+     */
+    struct check_failure : public std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    inline void check(bool pred, const char *msg) {
+        if (!pred) throw check_failure(msg);
+    }
+
+    inline void check(bool pred, const std::string &msg) {
+        if (!pred) throw check_failure(msg);
+    }
+
+    inline void check(bool pred, std::string_view msg) {
+        if (!pred) throw check_failure(std::string(msg));
+    }
+
+    inline void check(bool pred, uint64_t code) {
+        if (!pred) throw check_failure("assertion failure with error code: " + std::to_string(code));
+    }
+
+}// namespace eosio
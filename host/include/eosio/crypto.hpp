@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <variant>
+#include <vector>
+#include "check.hpp"
+#include "fixed_bytes.hpp"
+#include "name.hpp"
+
+namespace eosio {
+
+    // the ecc forms of the CDT key and signature variants; the webauthn forms are not used natively
+    using ecc_public_key = std::array<char, 33>;
+    using ecc_signature = std::array<char, 65>;
+    using public_key = std::variant<ecc_public_key>;
+    using signature = std::variant<ecc_signature>;
+
+    /**
+     * SHA-256 like the intrinsic, so that digests computed natively match the chain.
+     */
+    inline checksum256 sha256(const char *data, uint32_t length) {
+        static constexpr uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        auto rotr = [](uint32_t x, int n) { return (x >> n) | (x << (32 - n)); };
+
+        uint64_t bit_len = uint64_t(length) * 8;
+        size_t padded_len = (length + 9 + 63) / 64 * 64;
+        std::vector<uint8_t> msg(padded_len, 0);
+        std::memcpy(msg.data(), data, length);
+        msg[length] = 0x80;
+        for (int i = 0; i < 8; i++) msg[padded_len - 1 - i] = uint8_t(bit_len >> (8 * i));
+
+        for (size_t chunk = 0; chunk < padded_len; chunk += 64) {
+            uint32_t w[64];
+            for (int i = 0; i < 16; i++) {
+                const uint8_t *p = &msg[chunk + i * 4];
+                w[i] = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+            }
+            for (int i = 16; i < 64; i++) {
+                uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+            for (int i = 0; i < 64; i++) {
+                uint32_t t1 = hh + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+                uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                hh = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+            }
+            h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+        }
+
+        std::array<uint8_t, 32> bytes;
+        for (int i = 0; i < 32; i++) bytes[i] = uint8_t(h[i / 4] >> (24 - 8 * (i % 4)));
+        return checksum256(bytes);
+    }
+
+    namespace host {
+
+        // a key per account for native runs, there is no secret key behind it
+        inline public_key make_public_key(const name &account) {
+            auto hash = sha256(reinterpret_cast<const char *>(&account.value), sizeof(account.value)).extract_as_byte_array();
+            ecc_public_key key{};
+            key[0] = 2;
+            std::memcpy(key.data() + 1, hash.data(), hash.size());
+            return key;
+        }
+
+        /**
+         * The signature that the assert_recover_key stand-in accepts for digest and key. It is
+         * derived from the public key only, so it proves nothing: native runs exercise the digest
+         * and the checks around it, not the cryptography.
+         */
+        inline signature sign(const checksum256 &digest, const public_key &key) {
+            auto digest_bytes = digest.extract_as_byte_array();
+            const auto &key_bytes = std::get<ecc_public_key>(key);
+            std::array<char, 32 + 33> buf;
+            std::memcpy(buf.data(), digest_bytes.data(), 32);
+            std::memcpy(buf.data() + 32, key_bytes.data(), key_bytes.size());
+            auto hash = sha256(buf.data(), buf.size()).extract_as_byte_array();
+            ecc_signature sig{};
+            sig[0] = 0x1f;
+            std::memcpy(sig.data() + 1, hash.data(), hash.size());
+            std::memcpy(sig.data() + 33, hash.data(), hash.size());
+            return sig;
+        }
+
+    }// namespace host
+
+    inline void assert_recover_key(const checksum256 &digest, const signature &sig, const public_key &pubkey) {
+        check(sig == host::sign(digest, pubkey), "Error expected key different than recovered key");
+    }
+
+}// namespace eosio
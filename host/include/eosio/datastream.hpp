@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+// the CDT datastream brings in the containers it can serialize, contract code relies on that
+
+namespace eosio {
+
+    /**
+     * Stand-in for eosio::datastream; native callers pass typed arguments, so only the buffer
+     * bounds are kept.
+     */
+    template<typename T>
+    class datastream {
+    public:
+        datastream(T start, size_t s) : _start(start), _pos(start), _end(start + s) {}
+
+        T pos() const { return _pos; }
+        size_t tellp() const { return size_t(_pos - _start); }
+        size_t remaining() const { return size_t(_end - _pos); }
+
+    private:
+        T _start;
+        T _pos;
+        T _end;
+    };
+
+}// namespace eosio
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "action.hpp"
+#include "asset.hpp"
+#include "check.hpp"
+#include "contract.hpp"
+#include "datastream.hpp"
+#include "fixed_bytes.hpp"
+#include "host.hpp"
+#include "multi_index.hpp"
+#include "name.hpp"
+#include "print.hpp"
+#include "singleton.hpp"
+#include "symbol.hpp"
+#include "system.hpp"
+#include "time.hpp"
+#include "types.hpp"
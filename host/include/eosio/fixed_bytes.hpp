@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include "types.hpp"
+
+namespace eosio {
+
+    /**
+     * Native stand-in for eosio::fixed_bytes, stored as big-endian uint128_t words so that
+     * comparisons follow the same order as the on-chain secondary index.
+     */
+    template<size_t Size>
+    class fixed_bytes {
+    private:
+        static constexpr size_t count_words() { return (Size + 15) / 16; }
+        static constexpr size_t padded_bytes() { return count_words() * 16 - Size; }
+
+    public:
+        typedef uint128_t word_t;
+
+        static constexpr size_t num_words() { return count_words(); }
+
+        constexpr fixed_bytes() : _data() {}
+
+        template<typename Word, typename... Rest>
+        static fixed_bytes<Size> make_from_word_sequence(Rest... rest) {
+            static_assert(std::is_integral<Word>::value && std::is_unsigned<Word>::value,
+                          "Word must be an unsigned integral type");
+            constexpr size_t word_count = sizeof...(Rest);
+            static_assert(word_count * sizeof(Word) <= Size, "too many words supplied to make_from_word_sequence");
+
+            const Word words[word_count] = {static_cast<Word>(rest)...};
+            std::array<uint8_t, Size> bytes{};
+            size_t pos = Size - word_count * sizeof(Word);
+            for (size_t w = 0; w < word_count; ++w) {
+                for (size_t b = sizeof(Word); b > 0; --b) {
+                    bytes[pos++] = static_cast<uint8_t>(words[w] >> (8 * (b - 1)));
+                }
+            }
+            return fixed_bytes<Size>(bytes);
+        }
+
+        explicit fixed_bytes(const std::array<uint8_t, Size> &arr) : _data() {
+            size_t pos = padded_bytes();
+            for (size_t i = 0; i < Size; ++i, ++pos) {
+                auto &w = _data[pos / 16];
+                w |= word_t(arr[i]) << (8 * (15 - pos % 16));
+            }
+        }
+
+        std::array<uint8_t, Size> extract_as_byte_array() const {
+            std::array<uint8_t, Size> arr{};
+            size_t pos = padded_bytes();
+            for (size_t i = 0; i < Size; ++i, ++pos) {
+                arr[i] = static_cast<uint8_t>(_data[pos / 16] >> (8 * (15 - pos % 16)));
+            }
+            return arr;
+        }
+
+        const auto &get_array() const { return _data; }
+
+        friend bool operator==(const fixed_bytes &a, const fixed_bytes &b) { return a._data == b._data; }
+        friend bool operator!=(const fixed_bytes &a, const fixed_bytes &b) { return a._data != b._data; }
+        friend bool operator<(const fixed_bytes &a, const fixed_bytes &b) { return a._data < b._data; }
+        friend bool operator>(const fixed_bytes &a, const fixed_bytes &b) { return a._data > b._data; }
+        friend bool operator<=(const fixed_bytes &a, const fixed_bytes &b) { return a._data <= b._data; }
+        friend bool operator>=(const fixed_bytes &a, const fixed_bytes &b) { return a._data >= b._data; }
+
+    private:
+        std::array<word_t, count_words()> _data;
+    };
+
+    typedef fixed_bytes<20> checksum160;
+    typedef fixed_bytes<32> checksum256;
+
+}// namespace eosio
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <vector>
+#include "name.hpp"
+#include "time.hpp"
+
+/**
+ * Controls for running contract code natively: the chain clock, the accounts and authorizations,
+ * the in-memory database with its undo log, and the database operation counters that stand in
+ * for billed db intrinsics.
+ */
+namespace eosio { namespace host {
+
+    struct db_stats {
+        uint64_t finds        = 0; // db_find, db_get by primary or secondary key
+        uint64_t lower_bounds = 0; // db_lowerbound, db_idx_lowerbound
+        uint64_t upper_bounds = 0; // db_upperbound, db_idx_upperbound
+        uint64_t nexts        = 0; // db_next, db_idx_next
+        uint64_t previouses   = 0; // db_previous, db_idx_previous
+        uint64_t stores       = 0; // db_store, including secondary index rows
+        uint64_t updates      = 0; // db_update, including secondary index rows
+        uint64_t removes      = 0; // db_remove, including secondary index rows
+
+        uint64_t reads() const { return finds + lower_bounds + upper_bounds + nexts + previouses; }
+        uint64_t writes() const { return stores + updates + removes; }
+        uint64_t total() const { return reads() + writes(); }
+
+        db_stats operator-(const db_stats &o) const {
+            db_stats r;
+            r.finds        = finds - o.finds;
+            r.lower_bounds = lower_bounds - o.lower_bounds;
+            r.upper_bounds = upper_bounds - o.upper_bounds;
+            r.nexts        = nexts - o.nexts;
+            r.previouses   = previouses - o.previouses;
+            r.stores       = stores - o.stores;
+            r.updates      = updates - o.updates;
+            r.removes      = removes - o.removes;
+            return r;
+        }
+    };
+
+    inline db_stats &stats() {
+        static db_stats s;
+        return s;
+    }
+
+    /**
+     * Undo records of the running transaction, empty when no transaction_session is open.
+     */
+    struct undo_state {
+        bool enabled = false;
+        std::vector<std::function<void()>> log;
+    };
+
+    inline undo_state &undo() {
+        static undo_state u;
+        return u;
+    }
+
+    /**
+     * Applies the writes of one transaction atomically: unless commit() is called, the table
+     * writes made since construction are reverted on destruction, like a failed transaction.
+     */
+    class transaction_session {
+    public:
+        transaction_session() {
+            undo().log.clear();
+            undo().enabled = true;
+        }
+
+        ~transaction_session() {
+            if (undo().enabled) {
+                rollback();
+            }
+        }
+
+        transaction_session(const transaction_session &) = delete;
+        transaction_session &operator=(const transaction_session &) = delete;
+
+        void commit() {
+            undo().log.clear();
+            undo().enabled = false;
+        }
+
+        void rollback() {
+            auto &log = undo().log;
+            undo().enabled = false;
+            for (auto it = log.rbegin(); it != log.rend(); ++it) {
+                (*it)();
+            }
+            log.clear();
+        }
+    };
+
+    inline std::vector<std::function<void()>> &table_clearers() {
+        static std::vector<std::function<void()>> clearers;
+        return clearers;
+    }
+
+    /**
+     * Drop every in-memory table and singleton and reset the counters.
+     */
+    inline void reset_database() {
+        for (auto &clear : table_clearers()) {
+            clear();
+        }
+        stats() = db_stats();
+        undo().log.clear();
+    }
+
+    inline std::set<name> &accounts() {
+        static std::set<name> a;
+        return a;
+    }
+
+    inline void create_account(const name &account) { accounts().insert(account); }
+
+    /**
+     * The actors that signed the running action.
+     */
+    inline std::set<name> &authorizers() {
+        static std::set<name> a;
+        return a;
+    }
+
+    inline time_point &block_time() {
+        static time_point t(seconds(1577836800)); // 2020-01-01T00:00:00
+        return t;
+    }
+
+    inline void set_block_time(const time_point &t) { block_time() = t; }
+
+    inline void produce_block() { block_time() += milliseconds(block_timestamp::block_interval_ms); }
+
+}}// namespace eosio::host
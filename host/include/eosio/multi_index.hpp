@@ -0,0 +1,424 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "check.hpp"
+#include "host.hpp"
+#include "name.hpp"
+
+namespace eosio {
+
+    template<class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+    struct const_mem_fun {
+        typedef typename std::remove_reference<Type>::type result_type;
+
+        Type operator()(const Class &x) const { return (x.*PtrToMemberFunction)(); }
+    };
+
+    template<name::raw IndexName, typename Extractor>
+    struct indexed_by {
+        enum constants { index_name = static_cast<uint64_t>(IndexName) };
+        typedef Extractor secondary_extractor_type;
+    };
+
+    static constexpr name same_payer{};
+
+    /**
+     * In-memory stand-in for eosio::multi_index.
+     *
+     * Rows live in a per (code, scope) store shared by every instance of the same table type, so
+     * contract code that re-opens a table sees the rows written earlier. Secondary indices are
+     * ordered by (secondary key, primary key) like the chain database. Every database intrinsic
+     * the real implementation would call is counted in host::stats(). Writes are recorded in the
+     * undo log while a host::transaction_session is open.
+     */
+    template<name::raw TableName, typename T, typename... Indices>
+    class multi_index {
+    private:
+        template<typename Index>
+        using secondary_key_t = typename std::decay<typename Index::secondary_extractor_type::result_type>::type;
+
+        template<typename Key>
+        struct secondary_entry {
+            Key key;
+            uint64_t primary;
+            const T *obj;
+        };
+
+        template<typename Key>
+        struct secondary_less {
+            bool operator()(const secondary_entry<Key> &a, const secondary_entry<Key> &b) const {
+                if (a.key < b.key) return true;
+                if (b.key < a.key) return false;
+                return a.primary < b.primary;
+            }
+        };
+
+        template<typename Key>
+        using secondary_set = std::set<secondary_entry<Key>, secondary_less<Key>>;
+
+        struct table_store {
+            std::map<uint64_t, T> rows;
+            std::tuple<secondary_set<secondary_key_t<Indices>>...> secondaries;
+        };
+
+        using store_map = std::map<std::pair<uint64_t, uint64_t>, table_store>;
+
+        static store_map &stores() {
+            static store_map s;
+            static bool registered = (host::table_clearers().push_back([]() { s.clear(); }), true);
+            (void)registered;
+            return s;
+        }
+
+        template<typename Key>
+        static bool key_equal(const Key &a, const Key &b) { return !(a < b) && !(b < a); }
+
+        template<size_t I>
+        using index_type_at = typename std::tuple_element<I, std::tuple<Indices...>>::type;
+
+        template<size_t I>
+        static secondary_key_t<index_type_at<I>> extract_key(const T &obj) {
+            return typename index_type_at<I>::secondary_extractor_type{}(obj);
+        }
+
+        template<uint64_t IndexName>
+        static constexpr size_t index_position() {
+            constexpr uint64_t names[] = {static_cast<uint64_t>(Indices::index_name)..., 0};
+            for (size_t i = 0; i < sizeof...(Indices); ++i) {
+                if (names[i] == IndexName) return i;
+            }
+            return sizeof...(Indices);
+        }
+
+        template<size_t... Is>
+        static void insert_secondaries(table_store &store, const T &obj, std::index_sequence<Is...>) {
+            (std::get<Is>(store.secondaries).insert({extract_key<Is>(obj), obj.primary_key(), &obj}), ...);
+        }
+
+        template<size_t... Is>
+        static void erase_secondaries(table_store &store, const T &obj, std::index_sequence<Is...>) {
+            (std::get<Is>(store.secondaries).erase({extract_key<Is>(obj), obj.primary_key(), nullptr}), ...);
+        }
+
+        template<size_t... Is>
+        auto extract_keys(const T &obj, std::index_sequence<Is...>) {
+            return std::make_tuple(extract_key<Is>(obj)...);
+        }
+
+        template<size_t I, typename Keys>
+        void update_secondary(const Keys &old_keys, const T &obj) {
+            const auto &old_key = std::get<I>(old_keys);
+            auto new_key = extract_key<I>(obj);
+            if (!key_equal(old_key, new_key)) {
+                auto &set = std::get<I>(_store->secondaries);
+                set.erase({old_key, obj.primary_key(), nullptr});
+                set.insert({new_key, obj.primary_key(), &obj});
+                ++host::stats().updates;
+            }
+        }
+
+        template<typename Keys, size_t... Is>
+        void update_secondaries(const Keys &old_keys, const T &obj, std::index_sequence<Is...>) {
+            (update_secondary<Is>(old_keys, obj), ...);
+        }
+
+        using index_seq = std::index_sequence_for<Indices...>;
+
+        // the undo records below restore rows without counting database operations
+        void log_undo_emplace(uint64_t pk) {
+            if (!host::undo().enabled) return;
+            host::undo().log.push_back([store = _store, pk]() {
+                auto it = store->rows.find(pk);
+                erase_secondaries(*store, it->second, index_seq{});
+                store->rows.erase(it);
+            });
+        }
+
+        void log_undo_modify(const T &old_obj) {
+            if (!host::undo().enabled) return;
+            host::undo().log.push_back([store = _store, old_obj]() {
+                auto it = store->rows.find(old_obj.primary_key());
+                erase_secondaries(*store, it->second, index_seq{});
+                it->second = old_obj;
+                insert_secondaries(*store, it->second, index_seq{});
+            });
+        }
+
+        void log_undo_erase(const T &old_obj) {
+            if (!host::undo().enabled) return;
+            host::undo().log.push_back([store = _store, old_obj]() {
+                auto res = store->rows.emplace(old_obj.primary_key(), old_obj);
+                insert_secondaries(*store, res.first->second, index_seq{});
+            });
+        }
+
+    public:
+        struct const_iterator {
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type        = const T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const T *;
+            using reference         = const T &;
+
+            const_iterator() = default;
+            explicit const_iterator(typename std::map<uint64_t, T>::const_iterator it) : _it(it) {}
+
+            const T &operator*() const { return _it->second; }
+            const T *operator->() const { return &_it->second; }
+
+            const_iterator &operator++() {
+                ++host::stats().nexts;
+                ++_it;
+                return *this;
+            }
+            const_iterator operator++(int) {
+                const_iterator tmp = *this;
+                ++(*this);
+                return tmp;
+            }
+            const_iterator &operator--() {
+                ++host::stats().previouses;
+                --_it;
+                return *this;
+            }
+            const_iterator operator--(int) {
+                const_iterator tmp = *this;
+                --(*this);
+                return tmp;
+            }
+
+            friend bool operator==(const const_iterator &a, const const_iterator &b) { return a._it == b._it; }
+            friend bool operator!=(const const_iterator &a, const const_iterator &b) { return a._it != b._it; }
+
+            typename std::map<uint64_t, T>::const_iterator _it;
+        };
+
+        template<size_t I>
+        class index {
+        public:
+            using index_type = index_type_at<I>;
+            using key_type   = secondary_key_t<index_type>;
+            using set_type   = secondary_set<key_type>;
+
+            static constexpr uint64_t index_name = static_cast<uint64_t>(index_type::index_name);
+
+            struct const_iterator {
+                using iterator_category = std::bidirectional_iterator_tag;
+                using value_type        = const T;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const T *;
+                using reference         = const T &;
+
+                const_iterator() = default;
+                explicit const_iterator(typename set_type::const_iterator it) : _it(it) {}
+
+                const T &operator*() const { return *_it->obj; }
+                const T *operator->() const { return _it->obj; }
+
+                const_iterator &operator++() {
+                    ++host::stats().nexts;
+                    ++_it;
+                    return *this;
+                }
+                const_iterator operator++(int) {
+                    const_iterator tmp = *this;
+                    ++(*this);
+                    return tmp;
+                }
+                const_iterator &operator--() {
+                    ++host::stats().previouses;
+                    --_it;
+                    return *this;
+                }
+                const_iterator operator--(int) {
+                    const_iterator tmp = *this;
+                    --(*this);
+                    return tmp;
+                }
+
+                friend bool operator==(const const_iterator &a, const const_iterator &b) { return a._it == b._it; }
+                friend bool operator!=(const const_iterator &a, const const_iterator &b) { return a._it != b._it; }
+
+                typename set_type::const_iterator _it;
+            };
+
+            explicit index(multi_index *mi) : _multidx(mi) {}
+
+            const_iterator cbegin() const {
+                ++host::stats().lower_bounds;
+                return const_iterator(set().begin());
+            }
+            const_iterator begin() const { return cbegin(); }
+
+            const_iterator cend() const { return const_iterator(set().end()); }
+            const_iterator end() const { return cend(); }
+
+            const_iterator lower_bound(const key_type &key) const {
+                ++host::stats().lower_bounds;
+                return const_iterator(set().lower_bound({key, 0, nullptr}));
+            }
+
+            const_iterator upper_bound(const key_type &key) const {
+                ++host::stats().upper_bounds;
+                return const_iterator(set().upper_bound({key, std::numeric_limits<uint64_t>::max(), nullptr}));
+            }
+
+            const_iterator find(const key_type &key) const {
+                ++host::stats().finds;
+                auto it = set().lower_bound({key, 0, nullptr});
+                if (it == set().end() || !key_equal(it->key, key)) {
+                    return cend();
+                }
+                return const_iterator(it);
+            }
+
+            const T &get(const key_type &key, const char *error_msg = "unable to find secondary key") const {
+                auto result = find(key);
+                check(result != cend(), error_msg);
+                return *result;
+            }
+
+            const_iterator require_find(const key_type &key, const char *error_msg = "unable to find secondary key") const {
+                auto result = find(key);
+                check(result != cend(), error_msg);
+                return result;
+            }
+
+            const_iterator iterator_to(const T &obj) const {
+                return const_iterator(set().find({extract_key<I>(obj), obj.primary_key(), nullptr}));
+            }
+
+            template<typename Lambda>
+            void modify(const_iterator itr, name payer, Lambda &&updater) {
+                check(itr != cend(), "cannot pass end iterator to modify");
+                _multidx->modify(*itr, payer, std::forward<Lambda>(updater));
+            }
+
+            const_iterator erase(const_iterator itr) {
+                check(itr != cend(), "cannot pass end iterator to erase");
+                const_iterator next(std::next(itr._it));
+                _multidx->erase(*itr);
+                return next;
+            }
+
+            name get_code() const { return _multidx->get_code(); }
+            uint64_t get_scope() const { return _multidx->get_scope(); }
+
+        private:
+            const set_type &set() const { return std::get<I>(_multidx->_store->secondaries); }
+
+            multi_index *_multidx;
+        };
+
+        multi_index(name code, uint64_t scope)
+            : _code(code), _scope(scope), _store(&stores()[std::make_pair(code.value, scope)]) {}
+
+        name get_code() const { return _code; }
+        uint64_t get_scope() const { return _scope; }
+
+        const_iterator cbegin() const {
+            ++host::stats().lower_bounds;
+            return const_iterator(_store->rows.begin());
+        }
+        const_iterator begin() const { return cbegin(); }
+
+        const_iterator cend() const { return const_iterator(_store->rows.end()); }
+        const_iterator end() const { return cend(); }
+
+        uint64_t available_primary_key() const {
+            if (_store->rows.empty()) return 0;
+            auto last = _store->rows.rbegin()->first;
+            check(last < std::numeric_limits<uint64_t>::max() - 1, "next primary key in table is at autoincrement limit");
+            return last + 1;
+        }
+
+        template<name::raw IndexName>
+        auto get_index() {
+            constexpr size_t pos = index_position<static_cast<uint64_t>(IndexName)>();
+            static_assert(pos < sizeof...(Indices), "name provided is not the name of any secondary index within multi_index");
+            return index<pos>(this);
+        }
+
+        const_iterator iterator_to(const T &obj) const {
+            return const_iterator(_store->rows.find(obj.primary_key()));
+        }
+
+        const_iterator find(uint64_t primary) const {
+            ++host::stats().finds;
+            return const_iterator(_store->rows.find(primary));
+        }
+
+        const_iterator require_find(uint64_t primary, const char *error_msg = "unable to find key") const {
+            auto itr = find(primary);
+            check(itr != cend(), error_msg);
+            return itr;
+        }
+
+        const T &get(uint64_t primary, const char *error_msg = "unable to find key") const {
+            auto itr = find(primary);
+            check(itr != cend(), error_msg);
+            return *itr;
+        }
+
+        template<typename Lambda>
+        const_iterator emplace(name /* payer */, Lambda &&constructor) {
+            T obj;
+            constructor(obj);
+            auto pk = obj.primary_key();
+            auto res = _store->rows.emplace(pk, std::move(obj));
+            check(res.second, "could not insert object, most likely a uniqueness constraint was violated");
+            insert_secondaries(*_store, res.first->second, index_seq{});
+            host::stats().stores += 1 + sizeof...(Indices);
+            log_undo_emplace(pk);
+            return const_iterator(res.first);
+        }
+
+        template<typename Lambda>
+        void modify(const_iterator itr, name payer, Lambda &&updater) {
+            check(itr != cend(), "cannot pass end iterator to modify");
+            modify(*itr, payer, std::forward<Lambda>(updater));
+        }
+
+        template<typename Lambda>
+        void modify(const T &obj, name /* payer */, Lambda &&updater) {
+            auto &mutable_obj = const_cast<T &>(obj);
+            auto pk = obj.primary_key();
+            auto old_keys = extract_keys(obj, index_seq{});
+            log_undo_modify(obj);
+
+            updater(mutable_obj);
+
+            check(pk == obj.primary_key(), "updater cannot change primary key when modifying an object");
+            ++host::stats().updates;
+            update_secondaries(old_keys, obj, index_seq{});
+        }
+
+        const_iterator erase(const_iterator itr) {
+            check(itr != cend(), "cannot pass end iterator to erase");
+            log_undo_erase(*itr);
+            erase_secondaries(*_store, *itr, index_seq{});
+            host::stats().removes += 1 + sizeof...(Indices);
+            return const_iterator(_store->rows.erase(itr._it));
+        }
+
+        void erase(const T &obj) {
+            auto itr = _store->rows.find(obj.primary_key());
+            check(itr != _store->rows.end(), "object passed to erase is not in multi_index");
+            erase(const_iterator(itr));
+        }
+
+    private:
+        name _code;
+        uint64_t _scope;
+        table_store *_store;
+    };
+
+}// namespace eosio
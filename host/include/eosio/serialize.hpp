@@ -0,0 +1,5 @@
+#pragma once
+
+// native callers pass typed rows, so the CDT serialization of a struct is not needed
+#define EOSLIB_SERIALIZE(TYPE, MEMBERS)
+#define EOSLIB_SERIALIZE_DERIVED(TYPE, BASE, MEMBERS)
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "fixed_bytes.hpp"
+#include "host.hpp"
+#include "time.hpp"
+
+namespace eosio {
+
+    inline time_point current_time_point() { return host::block_time(); }
+
+    inline block_timestamp current_block_time() { return block_timestamp(host::block_time()); }
+
+    inline bool is_account(const name &n) { return host::accounts().count(n) > 0; }
+
+    // native runs are on a single chain, any fixed id does
+    inline checksum256 get_chain_id() { return checksum256(); }
+
+}// namespace eosio
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+
+namespace eosio {
+
+    class microseconds {
+    public:
+        explicit microseconds(int64_t c = 0) : _count(c) {}
+
+        int64_t count() const { return _count; }
+        int64_t to_seconds() const { return _count / 1000000; }
+
+        microseconds &operator+=(const microseconds &c) { _count += c._count; return *this; }
+        microseconds &operator-=(const microseconds &c) { _count -= c._count; return *this; }
+
+        friend microseconds operator+(const microseconds &l, const microseconds &r) { return microseconds(l._count + r._count); }
+        friend microseconds operator-(const microseconds &l, const microseconds &r) { return microseconds(l._count - r._count); }
+
+        friend bool operator==(const microseconds &a, const microseconds &b) { return a._count == b._count; }
+        friend bool operator!=(const microseconds &a, const microseconds &b) { return a._count != b._count; }
+        friend bool operator<(const microseconds &a, const microseconds &b) { return a._count < b._count; }
+        friend bool operator<=(const microseconds &a, const microseconds &b) { return a._count <= b._count; }
+        friend bool operator>(const microseconds &a, const microseconds &b) { return a._count > b._count; }
+        friend bool operator>=(const microseconds &a, const microseconds &b) { return a._count >= b._count; }
+
+        int64_t _count;
+    };
+
+    inline microseconds seconds(int64_t s) { return microseconds(s * 1000000); }
+    inline microseconds milliseconds(int64_t s) { return microseconds(s * 1000); }
+    inline microseconds minutes(int64_t m) { return seconds(60 * m); }
+    inline microseconds hours(int64_t h) { return minutes(60 * h); }
+    inline microseconds days(int64_t d) { return hours(24 * d); }
+
+    class time_point {
+    public:
+        explicit time_point(microseconds e = microseconds()) : elapsed(e) {}
+
+        const microseconds &time_since_epoch() const { return elapsed; }
+        uint32_t sec_since_epoch() const { return uint32_t(elapsed.count() / 1000000); }
+
+        time_point &operator+=(const microseconds &m) { elapsed += m; return *this; }
+        time_point &operator-=(const microseconds &m) { elapsed -= m; return *this; }
+        time_point operator+(const microseconds &m) const { return time_point(elapsed + m); }
+        time_point operator-(const microseconds &m) const { return time_point(elapsed - m); }
+        microseconds operator-(const time_point &m) const { return microseconds(elapsed.count() - m.elapsed.count()); }
+
+        bool operator==(const time_point &t) const { return elapsed == t.elapsed; }
+        bool operator!=(const time_point &t) const { return elapsed != t.elapsed; }
+        bool operator<(const time_point &t) const { return elapsed < t.elapsed; }
+        bool operator<=(const time_point &t) const { return elapsed <= t.elapsed; }
+        bool operator>(const time_point &t) const { return elapsed > t.elapsed; }
+        bool operator>=(const time_point &t) const { return elapsed >= t.elapsed; }
+
+        microseconds elapsed;
+    };
+
+    class time_point_sec {
+    public:
+        time_point_sec() : utc_seconds(0) {}
+        explicit time_point_sec(uint32_t seconds) : utc_seconds(seconds) {}
+        time_point_sec(const time_point &t) : utc_seconds(uint32_t(t.time_since_epoch().count() / 1000000ll)) {}
+
+        operator time_point() const { return time_point(eosio::seconds(utc_seconds)); }
+        uint32_t sec_since_epoch() const { return utc_seconds; }
+
+        time_point_sec operator+(uint32_t offset) const { return time_point_sec(utc_seconds + offset); }
+        time_point_sec operator-(uint32_t offset) const { return time_point_sec(utc_seconds - offset); }
+
+        friend bool operator==(const time_point_sec &a, const time_point_sec &b) { return a.utc_seconds == b.utc_seconds; }
+        friend bool operator!=(const time_point_sec &a, const time_point_sec &b) { return a.utc_seconds != b.utc_seconds; }
+        friend bool operator<(const time_point_sec &a, const time_point_sec &b) { return a.utc_seconds < b.utc_seconds; }
+        friend bool operator<=(const time_point_sec &a, const time_point_sec &b) { return a.utc_seconds <= b.utc_seconds; }
+        friend bool operator>(const time_point_sec &a, const time_point_sec &b) { return a.utc_seconds > b.utc_seconds; }
+        friend bool operator>=(const time_point_sec &a, const time_point_sec &b) { return a.utc_seconds >= b.utc_seconds; }
+
+        uint32_t utc_seconds;
+    };
+
+    class block_timestamp {
+    public:
+        explicit block_timestamp(uint32_t s = 0) : slot(s) {}
+        block_timestamp(const time_point &t) { set_time_point(t); }
+        block_timestamp(const time_point_sec &t) { set_time_point(t); }
+
+        time_point to_time_point() const { return (time_point)(*this); }
+
+        operator time_point() const {
+            int64_t msec = slot * (int64_t)block_interval_ms;
+            msec += block_timestamp_epoch;
+            return time_point(milliseconds(msec));
+        }
+
+        bool operator==(const block_timestamp &t) const { return slot == t.slot; }
+        bool operator!=(const block_timestamp &t) const { return slot != t.slot; }
+        bool operator<(const block_timestamp &t) const { return slot < t.slot; }
+        bool operator>(const block_timestamp &t) const { return slot > t.slot; }
+        bool operator<=(const block_timestamp &t) const { return slot <= t.slot; }
+        bool operator>=(const block_timestamp &t) const { return slot >= t.slot; }
+
+        uint32_t slot;
+        static constexpr int32_t block_interval_ms = 500;
+        static constexpr int64_t block_timestamp_epoch = 946684800000ll; // epoch is year 2000
+
+    private:
+        void set_time_point(const time_point &t) {
+            int64_t micro_since_epoch = t.time_since_epoch().count();
+            int64_t msec_since_epoch = micro_since_epoch / 1000;
+            slot = uint32_t((msec_since_epoch - block_timestamp_epoch) / int64_t(block_interval_ms));
+        }
+
+        void set_time_point(const time_point_sec &t) {
+            int64_t sec_since_epoch = t.sec_since_epoch();
+            slot = uint32_t((sec_since_epoch * 1000 - block_timestamp_epoch) / block_interval_ms);
+        }
+    };
+
+    typedef block_timestamp block_timestamp_type;
+
+}// namespace eosio
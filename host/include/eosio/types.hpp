@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+// The CDT libc exposes the 128-bit integers under these names
+typedef __int128 int128_t;
+typedef unsigned __int128 uint128_t;
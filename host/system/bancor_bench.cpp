@@ -0,0 +1,165 @@
+/**
+ * Native benchmark of the bancor conversions of the RAM market.
+ *
+ * Runs get_bancor_output, as buyram and sellram do, and get_bancor_input, as buyrambytes does,
+ * over synthetic RAM market reserves with the former double implementation and with the 128-bit
+ * integer one of exchange_state.cpp, reports ns/op for both and how many results differ.
+ *
+ * The host compiles doubles to hardware floats, a contract runs them through softfloat, so the
+ * integer math gains more on chain than measured here.
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <eosio.system/exchange_state.hpp>
+
+using namespace eosiosystem;
+
+namespace legacy {
+
+    // verbatim from exchange_state.cpp before the integer implementation
+    int64_t get_bancor_output( int64_t inp_reserve, int64_t out_reserve, int64_t inp ) {
+        const double ib = inp_reserve;
+        const double ob = out_reserve;
+        const double in = inp;
+
+        int64_t out = int64_t( (in * ob) / (ib + in) );
+
+        if ( out < 0 ) out = 0;
+
+        return out;
+    }
+
+    int64_t get_bancor_input( int64_t out_reserve, int64_t inp_reserve, int64_t out ) {
+        const double ob = out_reserve;
+        const double ib = inp_reserve;
+
+        int64_t inp = (ib * out) / (ob - out);
+
+        if ( inp < 0 ) inp = 0;
+
+        return inp;
+    }
+
+}// namespace legacy
+
+struct conversion_input {
+    int64_t ram_reserve;    // bytes
+    int64_t core_reserve;   // core token units, precision 4
+    int64_t payment;        // core token units of a buyram
+    int64_t bytes;          // bytes of a sellram or a buyrambytes
+};
+
+struct legacy_kernel {
+    static int64_t run(const conversion_input &c) {
+        int64_t bought = legacy::get_bancor_output(c.core_reserve, c.ram_reserve, c.payment);
+        int64_t sold = legacy::get_bancor_output(c.ram_reserve, c.core_reserve, c.bytes);
+        int64_t cost = legacy::get_bancor_input(c.ram_reserve, c.core_reserve, c.bytes);
+        return bought ^ (sold << 1) ^ (cost << 2);
+    }
+};
+
+struct integer_kernel {
+    static int64_t run(const conversion_input &c) {
+        int64_t bought = exchange_state::get_bancor_output(c.core_reserve, c.ram_reserve, c.payment);
+        int64_t sold = exchange_state::get_bancor_output(c.ram_reserve, c.core_reserve, c.bytes);
+        int64_t cost = exchange_state::get_bancor_input(c.ram_reserve, c.core_reserve, c.bytes);
+        return bought ^ (sold << 1) ^ (cost << 2);
+    }
+};
+
+static std::vector<conversion_input> make_conversions(uint32_t count, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    // log-uniform reserves of 16 GiB to 1 TiB of RAM against 1e5 to 1e11 core tokens, payments up
+    // to 1e7 core tokens and up to 1 GiB of RAM per conversion
+    auto log_uniform = [&](double lo, double hi) {
+        std::uniform_real_distribution<double> dist(std::log(lo), std::log(hi));
+        return int64_t(std::exp(dist(rng)));
+    };
+    std::vector<conversion_input> conversions(count);
+    for (auto &c : conversions) {
+        c.ram_reserve = log_uniform(0x1p34, 0x1p40);
+        c.core_reserve = log_uniform(1e9, 1e15);
+        c.payment = log_uniform(1, 1e11);
+        c.bytes = log_uniform(1, 0x1p30);
+    }
+    return conversions;
+}
+
+template<typename kernel_t>
+static double run(const std::vector<conversion_input> &conversions, uint32_t rounds, std::vector<int64_t> &results) {
+    results.assign(conversions.size(), 0);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < conversions.size(); i++) results[i] += kernel_t::run(conversions[i]);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // three conversions per input
+    return seconds * 1e9 / (3.0 * double(conversions.size()) * rounds);
+}
+
+static void usage(const char *prog) {
+    std::fprintf(stderr,
+        "Usage: %s [OPTION]...\n"
+        "  --ops N            synthetic market states, three conversions each (default 1000000)\n"
+        "  --rounds N         passes over the market states (default 10)\n"
+        "  --seed N           random seed (default 1)\n"
+        "  --csv              print one csv header and row\n",
+        prog);
+}
+
+int main(int argc, char **argv) {
+    uint32_t op_count = 1000000;
+    uint32_t rounds = 10;
+    uint64_t seed = 1;
+    bool csv = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--csv") {
+            csv = true;
+        } else if (arg == "--ops" && has_value) {
+            op_count = std::stoul(argv[++i]);
+        } else if (arg == "--rounds" && has_value) {
+            rounds = std::stoul(argv[++i]);
+        } else if (arg == "--seed" && has_value) {
+            seed = std::stoull(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<conversion_input> conversions = make_conversions(op_count, seed);
+    std::vector<int64_t> legacy_results, integer_results;
+    double legacy_ns = 0, integer_ns = 0;
+    try {
+        legacy_ns = run<legacy_kernel>(conversions, rounds, legacy_results);
+        integer_ns = run<integer_kernel>(conversions, rounds, integer_results);
+    } catch (const eosio::check_failure &e) {
+        std::fprintf(stderr, "check failed: %s\n", e.what());
+        return 1;
+    }
+    // the double results may be one unit off, see bancor_test
+    uint32_t differences = 0;
+    for (size_t i = 0; i < conversions.size(); i++) {
+        if (legacy_results[i] != integer_results[i]) differences++;
+    }
+
+    if (csv) {
+        std::printf("ops,rounds,legacy_ns_per_op,integer_ns_per_op,speedup,differences\n");
+        std::printf("%u,%u,%.2f,%.2f,%.2f,%u\n", op_count, rounds, legacy_ns, integer_ns, legacy_ns / integer_ns,
+                    differences);
+        return 0;
+    }
+    std::printf("ops=%u rounds=%u seed=%llu\n", op_count, rounds, (unsigned long long)seed);
+    std::printf("legacy      : %.2f ns/op\n", legacy_ns);
+    std::printf("integer     : %.2f ns/op\n", integer_ns);
+    std::printf("speedup     : %.2fx\n", legacy_ns / integer_ns);
+    std::printf("differences : %u of %u market states\n", differences, op_count);
+    return 0;
+}
@@ -0,0 +1,208 @@
+/**
+ * Differential test of the integer bancor math in exchange_state.cpp.
+ *
+ * get_bancor_output and get_bancor_input are checked to return exactly the floor of their
+ * quotient, using the 128-bit product, over the cross product of the boundary values, random
+ * operands of every magnitude and RAM market shaped reserves. Each result is also compared with
+ * the former double implementation wherever its operands are exact doubles, where it may differ
+ * by its rounding error only: at most one unit, or a relative 2^-50 for results above 2^53.
+ */
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <eosio.system/exchange_state.hpp>
+
+using namespace eosiosystem;
+
+static const int64_t INT64_MAX_V = std::numeric_limits<int64_t>::max();
+
+namespace legacy {
+
+    // verbatim from exchange_state.cpp before the integer implementation
+    int64_t get_bancor_output( int64_t inp_reserve, int64_t out_reserve, int64_t inp ) {
+        const double ib = inp_reserve;
+        const double ob = out_reserve;
+        const double in = inp;
+
+        int64_t out = int64_t( (in * ob) / (ib + in) );
+
+        if ( out < 0 ) out = 0;
+
+        return out;
+    }
+
+    int64_t get_bancor_input( int64_t out_reserve, int64_t inp_reserve, int64_t out ) {
+        const double ob = out_reserve;
+        const double ib = inp_reserve;
+
+        int64_t inp = (ib * out) / (ob - out);
+
+        if ( inp < 0 ) inp = 0;
+
+        return inp;
+    }
+
+}// namespace legacy
+
+struct test_stats {
+    uint64_t cases = 0;
+    uint64_t legacy_cases = 0;
+    uint64_t legacy_differences = 0;
+    uint64_t failures = 0;
+};
+
+static void fail(test_stats &stats, const char *fn, int64_t a, int64_t b, int64_t c, const char *what, int64_t actual) {
+    if (++stats.failures <= 20)
+        std::printf("FAIL %s(%lld, %lld, %lld): %s, actual %lld\n", fn, (long long)a, (long long)b, (long long)c, what,
+                        (long long)actual);
+}
+
+// a double result may only be off by its own rounding error
+static bool close_to_legacy(int64_t actual, int64_t legacy) {
+    double tolerance = std::max(1.0, std::ldexp(double(actual), -50));
+    return std::fabs(double(actual) - double(legacy)) <= tolerance;
+}
+
+// the legacy conversions are only compared where their operands convert to double exactly, above
+// that a difference like ob - out loses any number of digits, and where the int64 conversion of
+// their result is defined
+static bool exact_in_double(int64_t v) {
+    return v <= (int64_t(1) << 53);
+}
+
+// r == floor(num / den)
+static bool is_floor(int64_t r, uint128_t num, uint128_t den) {
+    return r >= 0 && uint128_t(r) * den <= num && (uint128_t(r) + 1) * den > num;
+}
+
+static void check_output(test_stats &stats, int64_t ib, int64_t ob, int64_t in) {
+    ++stats.cases;
+    int64_t r = exchange_state::get_bancor_output(ib, ob, in);
+    if (in <= 0 || ob <= 0 || int128_t(ib) + in <= 0) {
+        if (r != 0) fail(stats, "get_bancor_output", ib, ob, in, "expected 0", r);
+        return;
+    }
+    uint128_t num = uint128_t(in) * uint64_t(ob);
+    uint128_t den = uint128_t(int128_t(ib) + in);
+    if (ib < 0) {
+        // the output reserve caps what a negative input reserve would give
+        if (uint128_t(ob) * den <= num ? r != ob : !is_floor(r, num, den))
+            fail(stats, "get_bancor_output", ib, ob, in, "not the capped floor", r);
+        return;
+    }
+    if (!is_floor(r, num, den)) fail(stats, "get_bancor_output", ib, ob, in, "not the floor", r);
+    if (r > ob || (ib > 0 && r == ob)) fail(stats, "get_bancor_output", ib, ob, in, "not below the output reserve", r);
+
+    if (exact_in_double(ob) && exact_in_double(ib) && exact_in_double(in)) {
+        ++stats.legacy_cases;
+        int64_t l = legacy::get_bancor_output(ib, ob, in);
+        if (l != r) {
+            ++stats.legacy_differences;
+            if (!close_to_legacy(r, l)) fail(stats, "get_bancor_output", ib, ob, in, "too far from legacy", r);
+        }
+    }
+}
+
+static void check_input(test_stats &stats, int64_t ob, int64_t ib, int64_t out) {
+    ++stats.cases;
+    int64_t r = 0;
+    bool ok = true;
+    try {
+        r = exchange_state::get_bancor_input(ob, ib, out);
+    } catch (const eosio::check_failure &) {
+        ok = false;
+    }
+    if (out <= 0 || ib <= 0) {
+        if (!ok || r != 0) fail(stats, "get_bancor_input", ob, ib, out, "expected 0", r);
+        return;
+    }
+    if (out >= ob) {
+        if (ok) fail(stats, "get_bancor_input", ob, ib, out, "expected a check failure", r);
+        return;
+    }
+    uint128_t num = uint128_t(ib) * uint64_t(out);
+    uint128_t den = uint128_t(ob - out);
+    bool fits = num / den <= uint128_t(INT64_MAX_V);
+    if (ok != fits) {
+        fail(stats, "get_bancor_input", ob, ib, out, fits ? "unexpected check failure" : "expected an overflow", r);
+        return;
+    }
+    if (!ok) return;
+    if (!is_floor(r, num, den)) fail(stats, "get_bancor_input", ob, ib, out, "not the floor", r);
+
+    if (exact_in_double(ob) && exact_in_double(ib) && double(ib) * double(out) / double(ob - out) < 0x1p62) {
+        ++stats.legacy_cases;
+        int64_t l = legacy::get_bancor_input(ob, ib, out);
+        if (l != r) {
+            ++stats.legacy_differences;
+            if (!close_to_legacy(r, l)) fail(stats, "get_bancor_input", ob, ib, out, "too far from legacy", r);
+        }
+    }
+}
+
+static std::vector<int64_t> boundary_values() {
+    std::set<int64_t> values;
+    auto add_around = [&](int64_t v) {
+        for (int64_t d = -1; d <= 1; d++) {
+            if ((d < 0 && v < -d) || (d > 0 && v > INT64_MAX_V - d)) continue;
+            values.insert(v + d);
+        }
+    };
+    int64_t p = 1;
+    for (int i = 0; i <= 18; i++) {
+        add_around(p);
+        if (i < 18) p *= 10;
+    }
+    add_around(0);
+    add_around(int64_t(1) << 32);
+    add_around(int64_t(1) << 36);   // 64 GiB of RAM
+    add_around(int64_t(1) << 53);
+    add_around(int64_t(1) << 62);
+    add_around(INT64_MAX_V);
+    values.insert(-1);
+    values.insert(std::numeric_limits<int64_t>::min());
+    return std::vector<int64_t>(values.begin(), values.end());
+}
+
+int main() {
+    test_stats stats;
+
+    std::vector<int64_t> values = boundary_values();
+    for (int64_t a : values)
+        for (int64_t b : values)
+            for (int64_t c : values) {
+                check_output(stats, a, b, c);
+                if (b >= 0) check_input(stats, a, b, c);
+            }
+
+    std::mt19937_64 rng(1);
+    auto random_value = [&]() {
+        int bits = std::uniform_int_distribution<int>(0, 63)(rng);
+        return int64_t(rng() >> (64 - bits - 1) >> 1);
+    };
+    for (int i = 0; i < 1000000; i++) {
+        check_output(stats, random_value(), random_value(), random_value());
+        check_input(stats, random_value(), random_value(), random_value());
+    }
+
+    // RAM market: 16 GiB to 1 TiB of RAM against 1e5 to 1e11 core tokens of 4 decimals
+    auto log_uniform = [&](double lo, double hi) {
+        std::uniform_real_distribution<double> dist(std::log(lo), std::log(hi));
+        return int64_t(std::exp(dist(rng)));
+    };
+    for (int i = 0; i < 1000000; i++) {
+        int64_t ram = log_uniform(0x1p34, 0x1p40);
+        int64_t core = log_uniform(1e9, 1e15);
+        check_output(stats, core, ram, log_uniform(1, 1e11));   // buyram
+        check_output(stats, ram, core, log_uniform(1, 1e10));   // sellram
+        check_input(stats, ram, core, log_uniform(1, 1e9));     // buyrambytes
+    }
+
+    std::printf("bancor_test: %llu cases, %llu compared with the double implementation, %llu differ, %llu failures\n",
+                    (unsigned long long)stats.cases, (unsigned long long)stats.legacy_cases,
+                    (unsigned long long)stats.legacy_differences, (unsigned long long)stats.failures);
+    return stats.failures == 0 ? 0 : 1;
+}
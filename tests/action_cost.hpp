@@ -0,0 +1,189 @@
+#pragma once
+
+#include <eosio/testing/tester.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <map>
+
+namespace eosio_cost {
+
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+/**
+ * Resource usage of one transaction, taken from its trace.
+ */
+struct action_cost {
+   std::string workload;
+   std::string action;
+   uint64_t    cpu_us    = 0; // billed cpu
+   uint64_t    net_bytes = 0; // billed net
+   int64_t     ram_delta = 0; // sum of the ram deltas of all accounts, including inline actions
+};
+
+inline std::string get_env( const char* name, const std::string& def = "" ) {
+   const char* v = std::getenv( name );
+   return v ? std::string(v) : def;
+}
+
+/**
+ * Push a single action in its own transaction. The tester bills every transaction a fixed
+ * DEFAULT_BILLED_CPU_TIME_US, so pass 0 to have the controller bill the measured cpu time like
+ * a producing node does.
+ */
+inline transaction_trace_ptr push_billed_action( base_tester& t, const account_name& code, const action_name& act_name,
+                                                 const account_name& actor, const fc::variant_object& data ) {
+   signed_transaction trx;
+   trx.actions.emplace_back( t.get_action( code, act_name, vector<permission_level>{{actor, config::active_name}}, data ) );
+   t.set_transaction_headers( trx );
+   trx.sign( t.get_private_key( actor, "active" ), t.control->get_chain_id() );
+   return t.push_transaction( trx, fc::time_point::maximum(), 0 );
+}
+
+/**
+ * Collects the costs of a benchmark test case and writes them as csv and json to
+ * $COST_REPORT_DIR (default: the working directory).
+ *
+ * finish() can check the costs against a baseline: ram and net must not grow, cpu may grow by
+ * COST_CPU_TOLERANCE_PCT percent (default 25). Every workload needs a baseline row. The check is
+ * off unless requested:
+ *   COST_BASELINE_CHECK=1        compare with the baseline checked in with the test case
+ *   COST_BASELINE_DIR=<dir>      compare with <dir>/<report name>.json
+ *   COST_BASELINE_UPDATE=1       write the current report to <dir>/<report name>.json instead of
+ *                                comparing, to refresh the checked-in numbers
+ */
+class cost_report {
+public:
+   explicit cost_report( const std::string& name ) : _name(name) {}
+
+   const action_cost& record( const std::string& workload, const std::string& action, const transaction_trace_ptr& trace ) {
+      BOOST_REQUIRE( trace && trace->receipt );
+      action_cost c;
+      c.workload  = workload;
+      c.action    = action;
+      c.cpu_us    = trace->receipt->cpu_usage_us;
+      c.net_bytes = trace->net_usage;
+      for( const auto& at : trace->action_traces ) {
+         for( const auto& d : at.account_ram_deltas ) {
+            c.ram_delta += d.delta;
+         }
+      }
+      BOOST_TEST_MESSAGE( _name << ": " << workload << " cpu_us=" << c.cpu_us << " net_bytes=" << c.net_bytes
+                          << " ram_delta=" << c.ram_delta );
+      _costs.push_back( c );
+      return _costs.back();
+   }
+
+   const std::vector<action_cost>& costs() const { return _costs; }
+
+   fc::variant to_variant() const {
+      fc::variants rows;
+      for( const auto& c : _costs ) {
+         rows.emplace_back( fc::mutable_variant_object()
+            ("workload",  c.workload)
+            ("action",    c.action)
+            ("cpu_us",    c.cpu_us)
+            ("net_bytes", c.net_bytes)
+            ("ram_delta", c.ram_delta) );
+      }
+      return fc::mutable_variant_object()("name", _name)("costs", rows);
+   }
+
+   void write_csv( const std::string& path ) const {
+      std::ofstream out( path );
+      out << "workload,action,cpu_us,net_bytes,ram_delta\n";
+      for( const auto& c : _costs ) {
+         out << c.workload << "," << c.action << "," << c.cpu_us << "," << c.net_bytes << "," << c.ram_delta << "\n";
+      }
+   }
+
+   void write_json( const std::string& path ) const {
+      fc::json::save_to_file( to_variant(), path, true );
+   }
+
+   static std::vector<action_cost> from_variant( const fc::variant& report ) {
+      std::vector<action_cost> costs;
+      for( const auto& row : report["costs"].get_array() ) {
+         action_cost c;
+         c.workload  = row["workload"].as_string();
+         c.action    = row["action"].as_string();
+         c.cpu_us    = row["cpu_us"].as_uint64();
+         c.net_bytes = row["net_bytes"].as_uint64();
+         c.ram_delta = row["ram_delta"].as_int64();
+         costs.push_back( c );
+      }
+      return costs;
+   }
+
+   /**
+    * @return one message per workload that regressed against the baseline or has no baseline
+    */
+   std::vector<std::string> compare_baseline( const std::vector<action_cost>& baseline, double cpu_tolerance_pct ) const {
+      std::map<std::string, const action_cost*> current;
+      for( const auto& c : _costs ) {
+         current[c.workload] = &c;
+      }
+
+      std::vector<std::string> regressions;
+      for( const auto& base : baseline ) {
+         auto itr = current.find( base.workload );
+         if( itr == current.end() ) {
+            regressions.push_back( base.workload + ": missing from the current run" );
+            continue;
+         }
+         const auto& c = *itr->second;
+         if( c.cpu_us > base.cpu_us * (100.0 + cpu_tolerance_pct) / 100.0 ) {
+            regressions.push_back( base.workload + ": cpu_us " + std::to_string(c.cpu_us) + " > baseline " + std::to_string(base.cpu_us) );
+         }
+         if( c.net_bytes > base.net_bytes ) {
+            regressions.push_back( base.workload + ": net_bytes " + std::to_string(c.net_bytes) + " > baseline " + std::to_string(base.net_bytes) );
+         }
+         if( c.ram_delta > base.ram_delta ) {
+            regressions.push_back( base.workload + ": ram_delta " + std::to_string(c.ram_delta) + " > baseline " + std::to_string(base.ram_delta) );
+         }
+         current.erase( itr );
+      }
+      for( const auto& c : current ) {
+         regressions.push_back( c.first + ": no baseline" );
+      }
+      return regressions;
+   }
+
+   /**
+    * Write the reports, then check them against baseline or the baseline file, or update the file, as
+    * requested by the environment.
+    */
+   void finish( const std::vector<action_cost>& baseline ) const {
+      auto report_dir = get_env( "COST_REPORT_DIR", "." );
+      write_csv( report_dir + "/" + _name + ".csv" );
+      write_json( report_dir + "/" + _name + ".json" );
+
+      auto baseline_dir = get_env( "COST_BASELINE_DIR" );
+      std::vector<action_cost> expected = baseline;
+      if( !baseline_dir.empty() ) {
+         auto baseline_path = baseline_dir + "/" + _name + ".json";
+         if( get_env( "COST_BASELINE_UPDATE" ) == "1" ) {
+            write_json( baseline_path );
+            return;
+         }
+         BOOST_REQUIRE_MESSAGE( fc::exists( baseline_path ), "cost baseline not found: " + baseline_path );
+         expected = from_variant( fc::json::from_file( baseline_path ) );
+      } else if( get_env( "COST_BASELINE_CHECK" ) != "1" ) {
+         return;
+      }
+      auto tolerance = std::stod( get_env( "COST_CPU_TOLERANCE_PCT", "25" ) );
+      for( const auto& r : compare_baseline( expected, tolerance ) ) {
+         BOOST_ERROR( _name + ": " + r );
+      }
+   }
+
+private:
+   std::string _name;
+   std::vector<action_cost> _costs;
+};
+
+} /// namespace eosio_cost
@@ -0,0 +1,308 @@
+#include "dex_tester.hpp"
+#include "action_cost.hpp"
+
+using namespace eosio_cost;
+using namespace eosio_system;
+
+/**
+ * Scripted workloads that record the billed cpu, net and ram of dex and system actions.
+ * With COST_BASELINE_CHECK=1 each test case fails when a cost goes over the baseline checked in
+ * before it, see cost_report.
+ *
+ * The baselines are estimated ceilings, not measured numbers: net and ram allow for the transaction
+ * and the rows each workload writes, cpu leaves room for slow machines. Replace them with a measured
+ * run (COST_BASELINE_DIR=<dir> COST_BASELINE_UPDATE=1) before turning the check on by default.
+ */
+class dex_cost_tester : public dex_tester {
+public:
+   dex_cost_tester( const std::string& report_name ) : report( report_name ) {}
+
+   transaction_trace_ptr push_cost( const std::string& workload, const name& signer, const action_name& act,
+                                    const variant_object& data ) {
+      auto trace = push_billed_action( *this, N(dex), act, signer, data );
+      report.record( workload, act.to_string(), trace );
+      produce_blocks( 1 );
+      return trace;
+   }
+
+   mvo limit_order( const name& user, const name& side, const asset& quant, const asset& price ) {
+      return mvo()
+         ( "user", user )
+         ( "sympair_id", 1 )
+         ( "order_type", "limit" )
+         ( "order_side", side )
+         ( "limit_quant", quant )
+         ( "frozen_quant", quant )
+         ( "price", price )
+         ( "external_id", ++external_id )
+         ( "order_config_ex", fc::variant() );
+   }
+
+   uint64_t place_order( const name& user, const name& side, const asset& quant, const asset& price ) {
+      EXECUTE_ACTION( push_action( user, N(neworder), limit_order( user, side, quant, price ) ) );
+      return ++order_id;
+   }
+
+   void setconfig_recycle_sec( int64_t data_recycle_sec ) {
+      EXECUTE_ACTION( setconfig( mvo()
+         ("dex_enabled", true)
+         ("dex_admin", N(dex.admin))
+         ("dex_fee_collector", N(dex.fee))
+         ("taker_fee_ratio", 8)
+         ("maker_fee_ratio", 4)
+         ("max_match_count", uint32_t(0))
+         ("admin_sign_required", false)
+         ("data_recycle_sec", data_recycle_sec) ) );
+   }
+
+   // k resting sells and one buy that takes all of them
+   uint64_t prepare_fills( uint32_t k ) {
+      for( uint32_t i = 0; i < k; i++ ) {
+         place_order( N(bob), N(sell), ASSET("0.00100000 BTC"), ASSET("10000.0000 USD") );
+      }
+      asset buy_quant( 100000 * k, symbol(8, "BTC") );
+      return place_order( N(alice), N(buy), buy_quant, ASSET("10000.0000 USD") );
+   }
+
+   transaction_trace_ptr match_cost( const std::string& workload, uint32_t max_count ) {
+      return push_cost( workload, N(dex.matcher), N(match), mvo()
+         ("matcher", N(dex.matcher))
+         ("max_count", max_count)
+         ("sym_pairs", std::vector<uint64_t>{1})
+         ("memo", "") );
+   }
+
+   cost_report report;
+   uint64_t external_id = 0;
+   uint64_t order_id    = 0;
+};
+
+class system_cost_tester : public eosio_system_tester {
+public:
+   system_cost_tester( const std::string& report_name ) : report( report_name ) {}
+
+   transaction_trace_ptr push_cost( const std::string& workload, const name& signer, const action_name& act,
+                                    const variant_object& data ) {
+      auto trace = push_billed_action( *this, config::system_account_name, act, signer, data );
+      report.record( workload, act.to_string(), trace );
+      produce_blocks( 1 );
+      return trace;
+   }
+
+   cost_report report;
+};
+
+BOOST_AUTO_TEST_SUITE(cost_benchmark_tests)
+
+// workload, action, cpu_us, net_bytes, ram_delta
+static const std::vector<action_cost> dex_neworder_baseline = {
+   { "neworder depth=0",   "neworder", 20000, 256, 2560 },
+   { "neworder depth=10",  "neworder", 20000, 256, 2048 },
+   { "neworder depth=100", "neworder", 20000, 256, 2048 },
+   { "neworder depth=500", "neworder", 20000, 256, 2048 },
+};
+
+BOOST_AUTO_TEST_CASE( dex_neworder_cost ) try {
+   dex_cost_tester t( "dex_neworder_cost" );
+   t.init_config();
+   t.init_sym_pair();
+   EXECUTE_ACTION( t.deposit( N(alice), ASSET("1000.0000 USD") ) );
+   EXECUTE_ACTION( t.deposit( N(bob), ASSET("0.10000000 BTC") ) );
+
+   // resting orders per side, none of them crossing
+   uint32_t depth = 0;
+   for( uint32_t checkpoint : { 0, 10, 100, 500 } ) {
+      for( ; depth < checkpoint; depth++ ) {
+         t.place_order( N(alice), N(buy), ASSET("0.00010000 BTC"), asset( 90000000 - depth * 10000, symbol(4, "USD") ) );
+         t.place_order( N(bob), N(sell), ASSET("0.00010000 BTC"), asset( 110000000 + depth * 10000, symbol(4, "USD") ) );
+      }
+      t.produce_blocks( 1 );
+      t.push_cost( "neworder depth=" + std::to_string(depth), N(alice), N(neworder),
+                   t.limit_order( N(alice), N(buy), ASSET("0.00010000 BTC"), ASSET("9500.0000 USD") ) );
+      t.order_id++;
+   }
+   t.report.finish( dex_neworder_baseline );
+} FC_LOG_AND_RETHROW()
+
+static const std::vector<action_cost> dex_match_baseline = {
+   { "match fills=1",  "match", 20000,  192, 4096 },
+   { "match fills=10", "match", 40000,  192, 8192 },
+   { "match fills=25", "match", 60000,  192, 16384 },
+   { "match fills=50", "match", 100000, 192, 28672 },
+};
+
+BOOST_AUTO_TEST_CASE( dex_match_cost ) try {
+   dex_cost_tester t( "dex_match_cost" );
+   t.init_config();
+   t.init_sym_pair();
+   EXECUTE_ACTION( t.deposit( N(alice), ASSET("1000.0000 USD") ) );
+   EXECUTE_ACTION( t.deposit( N(bob), ASSET("0.10000000 BTC") ) );
+
+   for( uint32_t fills : { 1, 10, 25, 50 } ) {
+      auto buy_order_id = t.prepare_fills( fills );
+      t.produce_blocks( 1 );
+      t.match_cost( "match fills=" + std::to_string(fills), fills );
+      BOOST_REQUIRE_EQUAL( t.get_order( buy_order_id )["status"].as_string(), "completed" );
+   }
+   t.report.finish( dex_match_baseline );
+} FC_LOG_AND_RETHROW()
+
+static const std::vector<action_cost> dex_cancel_baseline = {
+   { "cancel", "cancel", 20000, 192, 256 },
+};
+
+BOOST_AUTO_TEST_CASE( dex_cancel_cost ) try {
+   dex_cost_tester t( "dex_cancel_cost" );
+   t.init_config();
+   t.init_sym_pair();
+   EXECUTE_ACTION( t.deposit( N(alice), ASSET("100.0000 USD") ) );
+
+   auto order_id = t.place_order( N(alice), N(buy), ASSET("0.00100000 BTC"), ASSET("10000.0000 USD") );
+   t.produce_blocks( 1 );
+   t.push_cost( "cancel", N(alice), N(cancel), mvo()("order_id", order_id) );
+   BOOST_REQUIRE_EQUAL( t.get_order( order_id )["status"].as_string(), "canceled" );
+   t.report.finish( dex_cancel_baseline );
+} FC_LOG_AND_RETHROW()
+
+static const std::vector<action_cost> dex_cleandata_baseline = {
+   { "cleandata count=10", "cleandata", 40000, 192, 0 },
+};
+
+BOOST_AUTO_TEST_CASE( dex_cleandata_cost ) try {
+   dex_cost_tester t( "dex_cleandata_cost" );
+   t.init_config();
+   t.setconfig_recycle_sec( 1 );
+   t.init_sym_pair();
+   EXECUTE_ACTION( t.deposit( N(alice), ASSET("1000.0000 USD") ) );
+   EXECUTE_ACTION( t.deposit( N(bob), ASSET("0.10000000 BTC") ) );
+
+   t.prepare_fills( 10 );
+   EXECUTE_ACTION( t.match( 10, {1}, "" ) );
+   t.produce_block( fc::seconds(10) );
+   t.push_cost( "cleandata count=10", N(dex.matcher), N(cleandata), mvo()("max_count", 10) );
+   t.report.finish( dex_cleandata_baseline );
+} FC_LOG_AND_RETHROW()
+
+static const std::vector<action_cost> system_voteproducer_baseline = {
+   { "voteproducer producers=1",  "voteproducer", 20000, 192, 512 },
+   { "voteproducer producers=10", "voteproducer", 30000, 256, 512 },
+   { "voteproducer producers=30", "voteproducer", 50000, 448, 512 },
+};
+
+BOOST_AUTO_TEST_CASE( system_voteproducer_cost ) try {
+   system_cost_tester t( "system_voteproducer_cost" );
+   std::vector<account_name> producer_names;
+   {
+      const std::string root("defproducer");
+      for( char c = 'a'; c <= 'z'; ++c ) {
+         producer_names.emplace_back(root + std::string(1, c));
+      }
+      const std::string root2("abcproducer");
+      for( char c = 'a'; c <= 'd'; ++c ) {
+         producer_names.emplace_back(root2 + std::string(1, c));
+      }
+      t.setup_producer_accounts(producer_names);
+      for( const auto& p : producer_names ) {
+         BOOST_REQUIRE_EQUAL( t.success(), t.regproducer(p) );
+      }
+   }
+   t.transfer( "eosio", "alice1111111", core_sym::from_string("1000.0000"), "eosio" );
+   BOOST_REQUIRE_EQUAL( t.success(), t.stake( "alice1111111", core_sym::from_string("100.0000"), core_sym::from_string("100.0000") ) );
+
+   for( size_t count : { 1, 10, 30 } ) {
+      t.push_cost( "voteproducer producers=" + std::to_string(count), N(alice1111111), N(voteproducer), mvo()
+         ("voter", N(alice1111111))
+         ("proxy", name(0))
+         ("producers", vector<account_name>(producer_names.begin(), producer_names.begin() + count)) );
+   }
+   t.report.finish( system_voteproducer_baseline );
+} FC_LOG_AND_RETHROW()
+
+static const std::vector<action_cost> system_buyram_baseline = {
+   { "buyram",                "buyram",      20000, 192, 256 },
+   { "buyram receiver=other", "buyram",      20000, 192, 256 },
+   { "buyrambytes",           "buyrambytes", 20000, 192, 256 },
+   { "sellram",               "sellram",     20000, 192, 256 },
+};
+
+BOOST_AUTO_TEST_CASE( system_buyram_cost ) try {
+   system_cost_tester t( "system_buyram_cost" );
+   t.transfer( "eosio", "alice1111111", core_sym::from_string("1000.0000"), "eosio" );
+
+   t.push_cost( "buyram", N(alice1111111), N(buyram), mvo()
+      ("payer", N(alice1111111))
+      ("receiver", N(alice1111111))
+      ("quant", core_sym::from_string("10.0000")) );
+   t.push_cost( "buyram receiver=other", N(alice1111111), N(buyram), mvo()
+      ("payer", N(alice1111111))
+      ("receiver", N(bob111111111))
+      ("quant", core_sym::from_string("10.0000")) );
+   t.push_cost( "buyrambytes", N(alice1111111), N(buyrambytes), mvo()
+      ("payer", N(alice1111111))
+      ("receiver", N(alice1111111))
+      ("bytes", 1024) );
+   t.push_cost( "sellram", N(alice1111111), N(sellram), mvo()
+      ("account", N(alice1111111))
+      ("bytes", 1024) );
+   t.report.finish( system_buyram_baseline );
+} FC_LOG_AND_RETHROW()
+
+static const std::vector<action_cost> system_delegatebw_baseline = {
+   { "delegatebw self",           "delegatebw",   20000, 224, 512 },
+   { "delegatebw self again",     "delegatebw",   20000, 224, 512 },
+   { "delegatebw other",          "delegatebw",   20000, 224, 512 },
+   { "delegatebw other transfer", "delegatebw",   20000, 224, 1024 },
+   { "undelegatebw",              "undelegatebw", 20000, 224, 1536 },
+};
+
+BOOST_AUTO_TEST_CASE( system_delegatebw_cost ) try {
+   system_cost_tester t( "system_delegatebw_cost" );
+   t.transfer( "eosio", "alice1111111", core_sym::from_string("1000.0000"), "eosio" );
+
+   auto delegatebw = [&]( const std::string& workload, const name& receiver, bool transfer ) {
+      t.push_cost( workload, N(alice1111111), N(delegatebw), mvo()
+         ("from", N(alice1111111))
+         ("receiver", receiver)
+         ("stake_net_quantity", core_sym::from_string("10.0000"))
+         ("stake_cpu_quantity", core_sym::from_string("10.0000"))
+         ("transfer", transfer) );
+   };
+   delegatebw( "delegatebw self", N(alice1111111), false );
+   delegatebw( "delegatebw self again", N(alice1111111), false );
+   delegatebw( "delegatebw other", N(bob111111111), false );
+   delegatebw( "delegatebw other transfer", N(carol1111111), true );
+   t.push_cost( "undelegatebw", N(alice1111111), N(undelegatebw), mvo()
+      ("from", N(alice1111111))
+      ("receiver", N(alice1111111))
+      ("unstake_net_quantity", core_sym::from_string("5.0000"))
+      ("unstake_cpu_quantity", core_sym::from_string("5.0000")) );
+   t.report.finish( system_delegatebw_baseline );
+} FC_LOG_AND_RETHROW()
+
+static const std::vector<action_cost> system_runrex_baseline = {
+   { "rexexec idle",            "rexexec", 20000, 192, 256 },
+   { "rexexec expired_loans=5", "rexexec", 40000, 192, 512 },
+};
+
+BOOST_AUTO_TEST_CASE( system_runrex_cost ) try {
+   system_cost_tester t( "system_runrex_cost" );
+   const asset init_balance = core_sym::from_string("40000.0000");
+   const std::vector<account_name> accounts = { N(aliceaccount), N(bobbyaccount) };
+   account_name alice = accounts[0], bob = accounts[1];
+   t.setup_rex_accounts( accounts, init_balance );
+   BOOST_REQUIRE_EQUAL( t.success(), t.buyrex( alice, core_sym::from_string("25000.0000") ) );
+
+   t.push_cost( "rexexec idle", alice, N(rexexec), mvo()("user", alice)("max", 2) );
+
+   const uint32_t loans = 5;
+   for( uint32_t i = 0; i < loans; i++ ) {
+      BOOST_REQUIRE_EQUAL( t.success(), t.rentcpu( bob, bob, core_sym::from_string("1.0000") ) );
+      t.produce_blocks( 1 );
+   }
+   // let the loans expire
+   t.produce_block( fc::days(31) );
+   t.push_cost( "rexexec expired_loans=" + std::to_string(loans), alice, N(rexexec), mvo()("user", alice)("max", loans) );
+   t.report.finish( system_runrex_baseline );
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
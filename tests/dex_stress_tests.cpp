@@ -0,0 +1,215 @@
+#include "dex_tester.hpp"
+#include "action_cost.hpp"
+
+using namespace eosio_cost;
+
+/**
+ * Book depth scaling: loads resting orders over many accounts and symbol pairs, and measures the
+ * billed cpu and ram of neworder, match and cancel on the first pair as the book grows.
+ *
+ * The default size keeps the regular test run short, the capacity run is
+ *   DEX_STRESS_MAX_DEPTH=100000 DEX_STRESS_ACCOUNTS=2000 unit_test --run_test=dex_stress_tests
+ */
+class dex_stress_tester : public dex_tester {
+public:
+   static constexpr uint32_t ORDERS_PER_TRX = 50;
+   static constexpr uint32_t TRX_PER_BLOCK  = 20;
+
+   dex_stress_tester( const std::string& report_name ) : report( report_name ) {
+      max_depth     = std::stoul( get_env( "DEX_STRESS_MAX_DEPTH", "4000" ) );
+      account_count = std::stoul( get_env( "DEX_STRESS_ACCOUNTS", "200" ) );
+      sympair_count = std::stoul( get_env( "DEX_STRESS_SYMPAIRS", "4" ) );
+      BOOST_REQUIRE( sympair_count > 0 && sympair_count <= 26 );
+      BOOST_REQUIRE( account_count > 0 );
+
+      init_config();
+      EXECUTE_ACTION( eosio_token.create( N(dex.admin), COIN_SUPPLY ) );
+      EXECUTE_ACTION( eosio_token.issue( N(dex.admin), COIN_SUPPLY, "" ) );
+      for( uint32_t i = 0; i < sympair_count; i++ ) {
+         symbol sym( 8, std::string( 3, char('A' + i) ).c_str() );
+         asset supply( ASSET_SUPPLY_AMOUNT, sym );
+         EXECUTE_ACTION( eosio_token.create( N(dex.admin), supply ) );
+         EXECUTE_ACTION( eosio_token.issue( N(dex.admin), supply, "" ) );
+         EXECUTE_ACTION( setsympair( extended_symbol{sym, BANK}, extended_symbol{COIN_SYMBOL, BANK},
+                                     asset( 1, sym ), asset( 1, COIN_SYMBOL ), false, true ) );
+         asset_symbols.push_back( sym );
+      }
+      produce_blocks( 1 );
+
+      create_users();
+   }
+
+   static name make_user( uint32_t i ) {
+      std::string s = "stress";
+      for( int d = 0; d < 6; d++, i /= 26 ) {
+         s += char('a' + i % 26);
+      }
+      return name( s );
+   }
+
+   void push_signed( vector<action> &&actions, const name& signer ) {
+      signed_transaction trx;
+      trx.actions = std::move( actions );
+      set_transaction_headers( trx );
+      trx.sign( get_private_key( signer, "active" ), control->get_chain_id() );
+      push_transaction( trx );
+      if( ++pending_trx >= TRX_PER_BLOCK ) {
+         produce_block();
+         pending_trx = 0;
+      }
+   }
+
+   action transfer_action( const name& from, const name& to, const asset& quantity ) {
+      return get_action( N(eosio.token), N(transfer), vector<permission_level>{{from, config::active_name}},
+                         mvo()("from", from)("to", to)("quantity", quantity)("memo", "") );
+   }
+
+   action order_action( const name& user, uint64_t sympair_id, const name& side, const asset& quant, const asset& price ) {
+      return get_action( N(dex), N(neworder), vector<permission_level>{{user, config::active_name}}, mvo()
+         ( "user", user )
+         ( "sympair_id", sympair_id )
+         ( "order_type", "limit" )
+         ( "order_side", side )
+         ( "limit_quant", quant )
+         ( "frozen_quant", quant )
+         ( "price", price )
+         ( "external_id", ++external_id )
+         ( "order_config_ex", fc::variant() ) );
+   }
+
+   // every user deposits coins and all the assets, so it can place any resting order
+   void create_users() {
+      for( uint32_t i = 0; i < account_count; i++ ) {
+         users.push_back( make_user(i) );
+      }
+      create_accounts( users );
+      produce_blocks( 1 );
+
+      for( const auto& user : users ) {
+         vector<action> funding{ transfer_action( N(dex.admin), user, USER_COINS ) };
+         vector<action> deposits{ transfer_action( user, N(dex), USER_COINS ) };
+         for( const auto& sym : asset_symbols ) {
+            funding.push_back( transfer_action( N(dex.admin), user, asset( USER_ASSET_AMOUNT, sym ) ) );
+            deposits.push_back( transfer_action( user, N(dex), asset( USER_ASSET_AMOUNT, sym ) ) );
+         }
+         push_signed( std::move(funding), N(dex.admin) );
+         push_signed( std::move(deposits), user );
+      }
+      produce_blocks( 1 );
+   }
+
+   // resting orders alternate over pairs and sides, buys below and sells above the price of 1
+   void load_orders( uint64_t target_depth ) {
+      while( depth < target_depth ) {
+         const auto& user = users[ user_cursor++ % users.size() ];
+         vector<action> actions;
+         for( uint32_t i = 0; i < ORDERS_PER_TRX && depth < target_depth; i++, depth++ ) {
+            uint32_t pair = depth % sympair_count;
+            bool is_buy = (depth / sympair_count) % 2 == 0;
+            int64_t level = (depth / sympair_count / 2) % PRICE_LEVELS;
+            asset price( is_buy ? BID_PRICE - level : ASK_PRICE + level, COIN_SYMBOL );
+            actions.push_back( order_action( user, pair + 1, is_buy ? N(buy) : N(sell),
+                                             asset( ORDER_AMOUNT, asset_symbols[pair] ), price ) );
+         }
+         push_signed( std::move(actions), user );
+      }
+      produce_blocks( 1 );
+   }
+
+   void measure( uint64_t target_depth ) {
+      const auto& maker = users[0];
+      const auto& sym = asset_symbols[0];
+      const std::string prefix = "depth=" + std::to_string(target_depth) + " ";
+      auto push_cost = [&]( const std::string& workload, const name& signer, const action_name& act, const variant_object& data ) {
+         auto trace = push_billed_action( *this, N(dex), act, signer, data );
+         report.record( prefix + workload, act.to_string(), trace );
+         produce_blocks( 1 );
+      };
+      auto order_data = [&]( const name& side, int64_t lots, int64_t price ) {
+         return mvo()
+            ( "user", maker )
+            ( "sympair_id", 1 )
+            ( "order_type", "limit" )
+            ( "order_side", side )
+            ( "limit_quant", asset( ORDER_AMOUNT * lots, sym ) )
+            ( "frozen_quant", asset( ORDER_AMOUNT * lots, sym ) )
+            ( "price", asset( price, COIN_SYMBOL ) )
+            ( "external_id", ++external_id )
+            ( "order_config_ex", fc::variant() );
+      };
+
+      // a resting order, then cancel it
+      push_cost( "neworder resting", maker, N(neworder), order_data( N(buy), 1, BID_PRICE - PRICE_LEVELS ) );
+      auto resting_order_id = ++order_id_offset + depth;
+      push_cost( "cancel", maker, N(cancel), mvo()("order_id", resting_order_id) );
+
+      // takers that cross the best bids, then the match crank
+      for( uint32_t fills : { 1u, MAX_MATCH_COUNT } ) {
+         push_cost( "neworder taker fills=" + std::to_string(fills), maker, N(neworder), order_data( N(sell), fills, 1 ) );
+         ++order_id_offset;
+         push_cost( "match fills=" + std::to_string(fills), N(dex.matcher), N(match), mvo()
+            ("matcher", N(dex.matcher))
+            ("max_count", fills)
+            ("sym_pairs", std::vector<uint64_t>{1})
+            ("memo", "") );
+      }
+   }
+
+   static constexpr int64_t  ORDER_AMOUNT        = 1000000;         // 0.01000000 of an asset
+   static constexpr int64_t  USER_ASSET_AMOUNT   = 1000000000;      // 10.00000000 of each asset
+   static constexpr int64_t  ASSET_SUPPLY_AMOUNT = 100000000000000; // 1000000.00000000
+   static constexpr int64_t  BID_PRICE           = 5000;            // 0.5000 COIN
+   static constexpr int64_t  ASK_PRICE           = 20000;           // 2.0000 COIN
+   static constexpr int64_t  PRICE_LEVELS        = 4000;
+   static constexpr uint32_t MAX_MATCH_COUNT     = 50;              // DEX_MATCH_COUNT_MAX of the contract
+
+   const symbol COIN_SYMBOL = symbol( 4, "COIN" );
+   const asset  COIN_SUPPLY = ASSET( "1000000000.0000 COIN" );
+   const asset  USER_COINS  = ASSET( "100.0000 COIN" );
+
+   cost_report report;
+   vector<symbol> asset_symbols;
+   vector<name> users;
+   uint64_t max_depth;
+   uint32_t account_count;
+   uint32_t sympair_count;
+   uint64_t depth = 0;           // resting orders loaded, also the number of loader order ids
+   uint64_t order_id_offset = 0; // order ids taken by the measured orders
+   uint64_t external_id = 0;
+   uint64_t user_cursor = 0;
+   uint32_t pending_trx = 0;
+};
+
+BOOST_AUTO_TEST_SUITE(dex_stress_tests)
+
+BOOST_AUTO_TEST_CASE( dex_book_depth_scaling ) try {
+   dex_stress_tester t( "dex_book_depth_scaling" );
+
+   std::vector<uint64_t> checkpoints;
+   for( uint64_t d = 1000; d < t.max_depth; d *= 4 ) {
+      checkpoints.push_back( d );
+   }
+   checkpoints.push_back( t.max_depth );
+
+   for( auto checkpoint : checkpoints ) {
+      t.load_orders( checkpoint );
+      t.measure( checkpoint );
+   }
+
+   const auto& gpo = t.control->get_global_properties();
+   const uint64_t max_block_cpu = gpo.configuration.max_block_cpu_usage;
+   const uint64_t max_trx_cpu   = gpo.configuration.max_transaction_cpu_usage;
+   const action_cost* worst = nullptr;
+   for( const auto& c : t.report.costs() ) {
+      if( !worst || c.cpu_us > worst->cpu_us ) worst = &c;
+   }
+   BOOST_REQUIRE( worst );
+   BOOST_TEST_MESSAGE( "worst single action: " << worst->workload << " cpu_us=" << worst->cpu_us
+                       << ", " << (100.0 * worst->cpu_us / max_block_cpu) << "% of max_block_cpu_usage=" << max_block_cpu
+                       << ", " << (100.0 * worst->cpu_us / max_trx_cpu) << "% of max_transaction_cpu_usage=" << max_trx_cpu );
+   BOOST_CHECK_LT( worst->cpu_us, max_trx_cpu );
+
+   t.report.finish();
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
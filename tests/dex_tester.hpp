@@ -0,0 +1,549 @@
+
+#pragma once
+
+#include <boost/test/unit_test.hpp>
+#include <eosio/testing/tester.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include "eosio.system_tester.hpp"
+
+#include "Runtime/Runtime.h"
+
+#include <fc/variant_object.hpp>
+
+using namespace eosio::testing;
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+using namespace fc;
+using namespace std;
+
+using mvo = fc::mutable_variant_object;
+
+static const name BANK = N(eosio.token);
+
+static const extended_symbol BTC_SYMBOL = extended_symbol{symbol(8, "BTC"), BANK};
+static const extended_symbol USD_SYMBOL = extended_symbol{symbol(4, "USD"), BANK};
+static const extended_symbol EOS_SYMBOL = extended_symbol{symbol(4, "EOS"), BANK};
+
+#define ASSET(s) asset::from_string(s)
+
+#define EXECUTE_ACTION(action_expr) BOOST_REQUIRE_EQUAL(action_expr, "")
+
+
+#define REQUIRE_MATCH_OBJ(obj, statements)                                                         \
+    {                                                                                              \
+        auto __o = fc::variant(obj);                                                               \
+        BOOST_REQUIRE_EQUAL(true, __o.is_object());                                                \
+        const auto &o = __o.get_object();                                                          \
+        statements                                                                                 \
+    }
+
+#define MATCH_FIELD(field, value) BOOST_REQUIRE_EQUAL(o[field], fc::variant(value));
+
+#define MATCH_FIELD_OBJ(field, value) REQUIRE_MATCHING_OBJECT(o[field], fc::variant(value));
+
+#define REQUIRE_MATCH_FIELD_OBJ(field, statements) REQUIRE_MATCH_OBJ(o[field], statements);
+
+class eosio_token_helper {
+public:
+    using action_result = tester::action_result;
+
+   eosio_token_helper(tester &t): _tester(t) {
+      _tester.produce_blocks( 2 );
+
+      _tester.create_accounts( { N(eosio.token) } );
+      _tester.produce_blocks( 2 );
+
+      _tester.set_code( N(eosio.token), contracts::token_wasm() );
+      _tester.set_abi( N(eosio.token), contracts::token_abi().data() );
+
+      _tester.produce_blocks();
+
+      const auto& accnt = _tester.control->db().get<account_object,by_name>( N(eosio.token) );
+      abi_def abi;
+      BOOST_REQUIRE_EQUAL(abi_serializer::to_abi(accnt.abi, abi), true);
+      abi_ser.set_abi(abi, _tester.abi_serializer_max_time);
+   }
+
+   action_result push_action( const account_name& signer, const action_name &name, const variant_object &data ) {
+      string action_type_name = abi_ser.get_action_type(name);
+
+      action act;
+      act.account = N(eosio.token);
+      act.name    = name;
+      act.data    = abi_ser.variant_to_binary( action_type_name, data, _tester.abi_serializer_max_time );
+
+      return _tester.push_action( std::move(act), signer.to_uint64_t() );
+   }
+
+   fc::variant get_stats( const string& symbolname )
+   {
+      auto symb = eosio::chain::symbol::from_string(symbolname);
+      auto symbol_code = symb.to_symbol_code().value;
+      vector<char> data = _tester.get_row_by_account( N(eosio.token), name(symbol_code), N(stat), account_name(symbol_code) );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "currency_stats", data, _tester.abi_serializer_max_time );
+   }
+
+   fc::variant get_account( account_name acc, const string& symbolname)
+   {
+      auto symb = eosio::chain::symbol::from_string(symbolname);
+      auto symbol_code = symb.to_symbol_code().value;
+      vector<char> data = _tester.get_row_by_account( N(eosio.token), acc, N(accounts), account_name(symbol_code) );
+      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "account", data, _tester.abi_serializer_max_time );
+   }
+
+   action_result create( account_name issuer,
+                         asset        maximum_supply ) {
+
+      return push_action( N(eosio.token), N(create), mvo()
+           ( "issuer", issuer)
+           ( "maximum_supply", maximum_supply)
+      );
+   }
+
+   action_result issue( account_name issuer, asset quantity, string memo ) {
+      return push_action( issuer, N(issue), mvo()
+           ( "to", issuer)
+           ( "quantity", quantity)
+           ( "memo", memo)
+      );
+   }
+
+   action_result retire( account_name issuer, asset quantity, string memo ) {
+      return push_action( issuer, N(retire), mvo()
+           ( "quantity", quantity)
+           ( "memo", memo)
+      );
+
+   }
+
+   action_result transfer( account_name from,
+                  account_name to,
+                  asset        quantity,
+                  string       memo ) {
+      return push_action( from, N(transfer), mvo()
+           ( "from", from)
+           ( "to", to)
+           ( "quantity", quantity)
+           ( "memo", memo)
+      );
+   }
+
+   action_result open( account_name owner,
+                       const string& symbolname,
+                       account_name ram_payer    ) {
+      return push_action( ram_payer, N(open), mvo()
+           ( "owner", owner )
+           ( "symbol", symbolname )
+           ( "ram_payer", ram_payer )
+      );
+   }
+
+   action_result close( account_name owner,
+                        const string& symbolname ) {
+      return push_action( owner, N(close), mvo()
+           ( "owner", owner )
+           ( "symbol", "0,CERO" )
+      );
+   }
+
+   tester &_tester;
+   abi_serializer abi_ser;
+};
+
+class dex_tester : public tester {
+public:
+
+    dex_tester(): eosio_token(*this) {
+        produce_blocks( 2 );
+
+        create_accounts( { N(dex.admin), N(dex.matcher), N(dex.fee),
+            N(alice), N(bob), N(carol), N(dex) } );
+        produce_blocks( 2 );
+
+        set_code( N(dex), contracts::dex_wasm() );
+        set_abi( N(dex), contracts::dex_abi().data() );
+
+        produce_blocks();
+
+        const auto& accnt = control->db().get<account_object,by_name>( N(dex) );
+        abi_def abi;
+        BOOST_REQUIRE_EQUAL(abi_serializer::to_abi(accnt.abi, abi), true);
+        abi_ser.set_abi(abi, abi_serializer_max_time);
+
+        EXECUTE_ACTION(eosio_token.create(N(dex.admin), asset::from_string("100000.0000 USD")));
+        produce_blocks(1);
+        EXECUTE_ACTION(eosio_token.issue( N(dex.admin), asset::from_string("100000.0000 USD"), "" ));
+        EXECUTE_ACTION(eosio_token.transfer( N(dex.admin), N(alice), asset::from_string("10000.0000 USD"), "" ) );
+
+        EXECUTE_ACTION(eosio_token.create(N(dex.admin), asset::from_string("10.00000000 BTC")));
+        EXECUTE_ACTION(eosio_token.issue( N(dex.admin), asset::from_string("10.00000000 BTC"), "" ));
+        EXECUTE_ACTION(eosio_token.transfer( N(dex.admin), N(bob), asset::from_string("1.00000000 BTC"), "" ) );
+
+    }
+
+    inline time_point get_head_block_time() {
+        return control->head_block_state()->block->timestamp.to_time_point();
+    }
+
+    action_result push_action( const account_name& signer, const action_name &name, const variant_object &data ) {
+        string action_type_name = abi_ser.get_action_type(name);
+        BOOST_REQUIRE_NE(action_type_name, "");
+        action act;
+        act.account = N(dex);
+        act.name    = name;
+        act.data    = abi_ser.variant_to_binary( action_type_name, data,abi_serializer_max_time );
+
+        return base_tester::push_action( std::move(act), signer.to_uint64_t() );
+    }
+
+    fc::variant get_conf( )
+    {
+        auto data = get_row_by_account( N(dex), N(dex), N(config), N(config) );
+        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "config", data, abi_serializer_max_time );
+    }
+
+    fc::variant get_symbol_pair( uint64_t sympair_id)
+    {
+        vector<char> data = get_row_by_account( N(dex), N(dex), N(sympair), name(sympair_id) );
+        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "symbol_pair_t", data, abi_serializer_max_time );
+    }
+
+    fc::variant get_order( uint64_t order_id)
+    {
+        vector<char> data = get_row_by_account( N(dex), N(dex), N(order), name(order_id) );
+        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "order_t", data, abi_serializer_max_time );
+    }
+
+    fc::variant get_account( const name &user, uint64_t account_id)
+    {
+        vector<char> data = get_row_by_account( N(dex), user, N(account), name(account_id) );
+        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "account_t", data, abi_serializer_max_time );
+    }
+
+    fc::variant get_deal( uint64_t deal_id )
+    {
+        vector<char> data = get_row_by_account( N(dex), N(dex), N(deal), name(deal_id) );
+        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "deal_item_t", data, abi_serializer_max_time );
+    }
+
+    // the market extension of the sympair row, null before the first deal of the pair
+    fc::variant get_market( uint64_t sympair_id )
+    {
+        auto sym_pair = get_symbol_pair( sympair_id );
+        return sym_pair.is_object() && sym_pair.get_object().contains("market") ? sym_pair["market"] : fc::variant();
+    }
+
+    fc::variant get_candle( uint64_t sympair_id, uint64_t slot )
+    {
+        vector<char> data = get_row_by_account( N(dex), name(sympair_id), N(candle), name(slot) );
+        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "candle_slot_t", data, abi_serializer_max_time );
+    }
+
+    fc::variant get_pool( uint64_t sympair_id )
+    {
+        vector<char> data = get_row_by_account( N(dex), N(dex), N(pool), name(sympair_id) );
+        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "pool_t", data, abi_serializer_max_time );
+    }
+
+    fc::variant get_lp_share( uint64_t sympair_id, const name &owner )
+    {
+        vector<char> data = get_row_by_account( N(dex), name(sympair_id), N(lpshare), owner );
+        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "lp_share_t", data, abi_serializer_max_time );
+    }
+
+    fc::variant get_trigger( uint64_t trigger_id )
+    {
+        vector<char> data = get_row_by_account( N(dex), N(dex), N(trigger), name(trigger_id) );
+        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "trigger_order_t", data, abi_serializer_max_time );
+    }
+
+    // scope: the sympair_id, or N(dex) for the totals
+    fc::variant get_counters( const name &scope )
+    {
+        vector<char> data = get_row_by_account( N(dex), scope, N(counters), N(counters) );
+        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "counters", data, abi_serializer_max_time );
+    }
+
+    action_result setconfig( const variant_object &conf ) {
+        return push_action( N(dex), N(setconfig), mvo()
+            ( "conf", conf)
+        );
+    }
+
+    action_result setsympair(const extended_symbol &asset_symbol,
+                             const extended_symbol &coin_symbol, const asset &min_asset_quant,
+                             const asset &min_coin_quant, bool only_accept_coin_fee, bool enabled) {
+        auto ret = push_action( N(dex.admin), N(setsympair), mvo()
+            ( "asset_symbol", asset_symbol)
+            ( "coin_symbol", coin_symbol)
+            ( "min_asset_quant", min_asset_quant)
+            ( "min_coin_quant", min_coin_quant)
+            ( "only_accept_coin_fee", only_accept_coin_fee)
+            ( "enabled", enabled)
+        );
+        // sympair_id().next();
+        return ret;
+    }
+
+    action_result deposit(const name &from, const asset &quantity) {
+        return eosio_token.transfer(from, N(dex), quantity, "deposit");
+    }
+
+    struct order_config_ex_t {
+        uint64_t taker_fee_ratio = 0;
+        uint64_t maker_fee_ratio = 0;
+    };
+
+    action_result neworder(const name &user, const uint64_t &sympair_id,
+        const name &order_type, const name &order_side,
+        const asset &limit_quant,
+        const asset &frozen_quant,
+        const asset &price,
+        const uint64_t &external_id,
+        const std::optional<order_config_ex_t> &order_config_ex) {
+
+        return push_action( user, N(neworder), mvo()
+            ( "user", user)
+            ( "sympair_id", sympair_id)
+            ( "order_type", order_type)
+            ( "order_side", order_side)
+            ( "limit_quant", limit_quant)
+            ( "frozen_quant", frozen_quant)
+            ( "price", price)
+            ( "external_id", external_id)
+            ( "order_config_ex", fc::variant())
+        );
+    }
+
+    action_result match(uint32_t max_count, const std::vector<uint64_t> &sym_pairs, const string &memo) {
+        return push_action( N(dex.matcher), N(match), mvo()
+            ("matcher", N(dex.matcher))
+            ("max_count", max_count)
+            ("sym_pairs", sym_pairs)
+            ("memo", memo)
+        );
+    }
+
+    action_result cancel(const name &owner, const uint64_t &order_id) {
+        return push_action( owner, N(cancel), mvo()
+            ( "order_id", order_id)
+        );
+    }
+
+    action_result setpool(const uint64_t &sympair_id, int64_t fee_ratio, bool enabled) {
+        return push_action( N(dex.admin), N(setpool), mvo()
+            ( "sympair_id", sympair_id)
+            ( "fee_ratio", fee_ratio)
+            ( "enabled", enabled)
+        );
+    }
+
+    action_result addliquidity(const name &user, const uint64_t &sympair_id, const asset &asset_quant, const asset &coin_quant) {
+        return push_action( user, N(addliquidity), mvo()
+            ( "user", user)
+            ( "sympair_id", sympair_id)
+            ( "asset_quant", asset_quant)
+            ( "coin_quant", coin_quant)
+        );
+    }
+
+    action_result rmliquidity(const name &user, const uint64_t &sympair_id, uint64_t shares) {
+        return push_action( user, N(rmliquidity), mvo()
+            ( "user", user)
+            ( "sympair_id", sympair_id)
+            ( "shares", shares)
+        );
+    }
+
+    action_result setrelaykey(const name &user, const fc::crypto::public_key &pubkey) {
+        return push_action( user, N(setrelaykey), mvo()
+            ( "user", user)
+            ( "pubkey", pubkey)
+        );
+    }
+
+    // an order of relayorders, signed over the digest of dex::make_relay_order_digest
+    fc::variant make_relay_order(const name &user, const uint64_t &sympair_id,
+        const name &order_type, const name &order_side,
+        const asset &limit_quant, const asset &price,
+        const uint64_t &external_id, const uint64_t &nonce,
+        const std::optional<fc::sha256> &signed_chain_id = std::nullopt) {
+
+        const uint64_t words[] = {
+            N(dex).to_uint64_t(), user.to_uint64_t(), sympair_id, order_type.to_uint64_t(), order_side.to_uint64_t(),
+            uint64_t(limit_quant.get_amount()), limit_quant.get_symbol().value(),
+            uint64_t(price.get_amount()), price.get_symbol().value(),
+            external_id, nonce
+        };
+        const fc::sha256 chain_id = signed_chain_id ? *signed_chain_id : control->get_chain_id();
+        std::vector<char> buf( chain_id.data(), chain_id.data() + chain_id.data_size() );
+        buf.insert( buf.end(), reinterpret_cast<const char*>(words), reinterpret_cast<const char*>(words) + sizeof(words) );
+        auto digest = fc::sha256::hash( buf.data(), buf.size() );
+        return mvo()
+            ( "user", user)
+            ( "sympair_id", sympair_id)
+            ( "order_type", order_type)
+            ( "order_side", order_side)
+            ( "limit_quant", limit_quant)
+            ( "price", price)
+            ( "external_id", external_id)
+            ( "nonce", nonce)
+            ( "sig", get_private_key(user, "relay").sign(digest));
+    }
+
+    action_result relayorders(const std::vector<fc::variant> &orders) {
+        return push_action( N(dex.admin), N(relayorders), mvo()
+            ( "orders", orders)
+        );
+    }
+
+    action_result newtrigger(const name &user, const uint64_t &sympair_id,
+        const name &trigger_type, const asset &trigger_price,
+        const name &order_type, const name &order_side,
+        const asset &limit_quant, const asset &price, const uint64_t &external_id) {
+
+        return push_action( user, N(newtrigger), mvo()
+            ( "user", user)
+            ( "sympair_id", sympair_id)
+            ( "trigger_type", trigger_type)
+            ( "trigger_price", trigger_price)
+            ( "order_type", order_type)
+            ( "order_side", order_side)
+            ( "limit_quant", limit_quant)
+            ( "price", price)
+            ( "external_id", external_id)
+        );
+    }
+
+    action_result canceltrig(const name &owner, const uint64_t &trigger_id) {
+        return push_action( owner, N(canceltrig), mvo()
+            ( "trigger_id", trigger_id)
+        );
+    }
+
+    // the bookchunk notifications of a snapshot action
+    std::vector<fc::variant> snapshot(const uint64_t &sympair_id, const fc::variant &cursor, uint32_t max_count) {
+        auto trace = base_tester::push_action( N(dex), N(snapshot), N(alice), mvo()
+            ( "sympair_id", sympair_id)
+            ( "cursor", cursor)
+            ( "max_count", max_count)
+        );
+        std::vector<fc::variant> chunks;
+        for (const auto &at : trace->action_traces) {
+            if (at.receiver == N(dex) && at.act.name == N(bookchunk))
+                chunks.push_back(abi_ser.binary_to_variant( "bookchunk", at.act.data, abi_serializer_max_time ));
+        }
+        return chunks;
+    }
+
+    action_result routeorder(const name &user, const std::vector<uint64_t> &path,
+                             const asset &quantity, const asset &min_output) {
+        return push_action( user, N(routeorder), mvo()
+            ( "user", user)
+            ( "path", path)
+            ( "quantity", extended_asset(quantity, BANK))
+            ( "min_output", extended_asset(min_output, BANK))
+        );
+    }
+
+    action_result setauction(const uint64_t &sympair_id, uint32_t interval_blocks, bool enabled) {
+        return push_action( N(dex.admin), N(setauction), mvo()
+            ( "sympair_id", sympair_id)
+            ( "interval_blocks", interval_blocks)
+            ( "enabled", enabled)
+        );
+    }
+
+    action_result clear(const uint64_t &sympair_id, uint32_t max_count, const string &memo) {
+        return push_action( N(dex.matcher), N(clear), mvo()
+            ("matcher", N(dex.matcher))
+            ("sympair_id", sympair_id)
+            ("max_count", max_count)
+            ("memo", memo)
+        );
+    }
+
+    action_result cleandata(uint64_t max_count) {
+        return push_action( N(dex.matcher), N(cleandata), mvo()
+            ("max_count", max_count)
+        );
+    }
+
+    void init_config() {
+        auto conf = mvo()
+            ("dex_enabled", true)
+            ("dex_admin", N(dex.admin))
+            ("dex_fee_collector", N(dex.fee))
+            ("taker_fee_ratio", 8)
+            ("maker_fee_ratio", 4)
+            ("max_match_count", uint32_t(0))
+            ("admin_sign_required", false)
+            ("data_recycle_sec", 90 * 3600 * 24);
+
+        EXECUTE_ACTION(setconfig( conf ));
+        produce_blocks(1);
+        auto conf_store = get_conf();
+        REQUIRE_MATCHING_OBJECT(get_conf(), conf);
+    }
+
+    void init_sym_pair() {
+        // add symbol pair for trading
+        EXECUTE_ACTION(setsympair(BTC_SYMBOL, USD_SYMBOL, ASSET("0.00001000 BTC"), ASSET("0.1000 USD"), false, true));
+        uint64_t sympair_id = 1;
+        auto sym_pair = get_symbol_pair(sympair_id);
+
+        REQUIRE_MATCH_OBJ( sym_pair,
+            MATCH_FIELD("sympair_id", sympair_id)
+            MATCH_FIELD_OBJ("asset_symbol", BTC_SYMBOL)
+            MATCH_FIELD_OBJ("coin_symbol", USD_SYMBOL)
+            MATCH_FIELD("min_asset_quant", "0.00001000 BTC")
+            MATCH_FIELD("min_coin_quant", "0.1000 USD")
+            MATCH_FIELD("only_accept_coin_fee", "0")
+            MATCH_FIELD("enabled", "1")
+        );
+    }
+
+    mvo init_buy_order(uint64_t sympair_id) {
+        // buy order
+        EXECUTE_ACTION(deposit(N(alice), ASSET("100.0000 USD")));
+        auto account = get_account(N(alice), 0);
+
+        REQUIRE_MATCH_OBJ( account,
+            MATCH_FIELD("id", 0)
+            REQUIRE_MATCH_FIELD_OBJ("balance",
+                MATCH_FIELD("contract", "eosio.token")
+                MATCH_FIELD("quantity", "100.0000 USD")
+            )
+        );
+
+        uint64_t order_id = 1;
+        EXECUTE_ACTION(neworder(N(alice), order_id, N(limit), N(buy), ASSET("0.01000000 BTC"), ASSET("100.0000 USD"),
+                ASSET("10000.0000 USD"), 1, std::nullopt));
+        auto buy_order = get_order(order_id);
+        auto expected_order = mvo()
+            ("sympair_id", 1)
+            ("order_id", order_id)
+            ("owner", "alice")
+            ("order_type", "limit")
+            ("order_side", "buy")
+            ("price", "10000.0000 USD")
+            ("limit_quant", "0.01000000 BTC")
+            ("frozen_quant", "100.0000 USD")
+            ("external_id", 1)
+            ("taker_fee_ratio", 8)
+            ("maker_fee_ratio", 4)
+            ("matched_assets", "0.00000000 BTC")
+            ("matched_coins", "0.0000 USD")
+            ("matched_fee", "0.00000000 BTC")
+            ("status", "matchable")
+            ("created_at", get_head_block_time())
+            ("last_updated_at", get_head_block_time())
+            ("last_deal_id", 0);
+        REQUIRE_MATCHING_OBJECT( buy_order, expected_order );
+        return expected_order;
+    }
+
+    abi_serializer abi_ser;
+    eosio_token_helper eosio_token;
+};
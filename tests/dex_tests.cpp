@@ -1,366 +1,4 @@
-
-#include <boost/test/unit_test.hpp>
-#include <eosio/testing/tester.hpp>
-#include <eosio/chain/abi_serializer.hpp>
-#include "eosio.system_tester.hpp"
-
-#include "Runtime/Runtime.h"
-
-#include <fc/variant_object.hpp>
-
-using namespace eosio::testing;
-using namespace eosio;
-using namespace eosio::chain;
-using namespace eosio::testing;
-using namespace fc;
-using namespace std;
-
-using mvo = fc::mutable_variant_object;
-
-static const name BANK = N(eosio.token);
-
-static const extended_symbol BTC_SYMBOL = extended_symbol{symbol(8, "BTC"), BANK};
-static const extended_symbol USD_SYMBOL = extended_symbol{symbol(4, "USD"), BANK};
-
-#define ASSET(s) asset::from_string(s)
-
-#define EXECUTE_ACTION(action_expr) BOOST_REQUIRE_EQUAL(action_expr, "")
-
-
-#define REQUIRE_MATCH_OBJ(obj, statements)                                                         \
-    {                                                                                              \
-        auto __o = fc::variant(obj);                                                               \
-        BOOST_REQUIRE_EQUAL(true, __o.is_object());                                                \
-        const auto &o = __o.get_object();                                                          \
-        statements                                                                                 \
-    }
-
-#define MATCH_FIELD(field, value) BOOST_REQUIRE_EQUAL(o[field], fc::variant(value));
-
-#define MATCH_FIELD_OBJ(field, value) REQUIRE_MATCHING_OBJECT(o[field], fc::variant(value));
-
-#define REQUIRE_MATCH_FIELD_OBJ(field, statements) REQUIRE_MATCH_OBJ(o[field], statements);
-
-class eosio_token_helper {
-public:
-    using action_result = tester::action_result;
-
-   eosio_token_helper(tester &t): _tester(t) {
-      _tester.produce_blocks( 2 );
-
-      _tester.create_accounts( { N(eosio.token) } );
-      _tester.produce_blocks( 2 );
-
-      _tester.set_code( N(eosio.token), contracts::token_wasm() );
-      _tester.set_abi( N(eosio.token), contracts::token_abi().data() );
-
-      _tester.produce_blocks();
-
-      const auto& accnt = _tester.control->db().get<account_object,by_name>( N(eosio.token) );
-      abi_def abi;
-      BOOST_REQUIRE_EQUAL(abi_serializer::to_abi(accnt.abi, abi), true);
-      abi_ser.set_abi(abi, _tester.abi_serializer_max_time);
-   }
-
-   action_result push_action( const account_name& signer, const action_name &name, const variant_object &data ) {
-      string action_type_name = abi_ser.get_action_type(name);
-
-      action act;
-      act.account = N(eosio.token);
-      act.name    = name;
-      act.data    = abi_ser.variant_to_binary( action_type_name, data, _tester.abi_serializer_max_time );
-
-      return _tester.push_action( std::move(act), signer.to_uint64_t() );
-   }
-
-   fc::variant get_stats( const string& symbolname )
-   {
-      auto symb = eosio::chain::symbol::from_string(symbolname);
-      auto symbol_code = symb.to_symbol_code().value;
-      vector<char> data = _tester.get_row_by_account( N(eosio.token), name(symbol_code), N(stat), account_name(symbol_code) );
-      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "currency_stats", data, _tester.abi_serializer_max_time );
-   }
-
-   fc::variant get_account( account_name acc, const string& symbolname)
-   {
-      auto symb = eosio::chain::symbol::from_string(symbolname);
-      auto symbol_code = symb.to_symbol_code().value;
-      vector<char> data = _tester.get_row_by_account( N(eosio.token), acc, N(accounts), account_name(symbol_code) );
-      return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "account", data, _tester.abi_serializer_max_time );
-   }
-
-   action_result create( account_name issuer,
-                         asset        maximum_supply ) {
-
-      return push_action( N(eosio.token), N(create), mvo()
-           ( "issuer", issuer)
-           ( "maximum_supply", maximum_supply)
-      );
-   }
-
-   action_result issue( account_name issuer, asset quantity, string memo ) {
-      return push_action( issuer, N(issue), mvo()
-           ( "to", issuer)
-           ( "quantity", quantity)
-           ( "memo", memo)
-      );
-   }
-
-   action_result retire( account_name issuer, asset quantity, string memo ) {
-      return push_action( issuer, N(retire), mvo()
-           ( "quantity", quantity)
-           ( "memo", memo)
-      );
-
-   }
-
-   action_result transfer( account_name from,
-                  account_name to,
-                  asset        quantity,
-                  string       memo ) {
-      return push_action( from, N(transfer), mvo()
-           ( "from", from)
-           ( "to", to)
-           ( "quantity", quantity)
-           ( "memo", memo)
-      );
-   }
-
-   action_result open( account_name owner,
-                       const string& symbolname,
-                       account_name ram_payer    ) {
-      return push_action( ram_payer, N(open), mvo()
-           ( "owner", owner )
-           ( "symbol", symbolname )
-           ( "ram_payer", ram_payer )
-      );
-   }
-
-   action_result close( account_name owner,
-                        const string& symbolname ) {
-      return push_action( owner, N(close), mvo()
-           ( "owner", owner )
-           ( "symbol", "0,CERO" )
-      );
-   }
-
-   tester &_tester;
-   abi_serializer abi_ser;
-};
-
-class dex_tester : public tester {
-public:
-
-    dex_tester(): eosio_token(*this) {
-        produce_blocks( 2 );
-
-        create_accounts( { N(dex.admin), N(dex.matcher), N(dex.fee),
-            N(alice), N(bob), N(carol), N(dex) } );
-        produce_blocks( 2 );
-
-        set_code( N(dex), contracts::dex_wasm() );
-        set_abi( N(dex), contracts::dex_abi().data() );
-
-        produce_blocks();
-
-        const auto& accnt = control->db().get<account_object,by_name>( N(dex) );
-        abi_def abi;
-        BOOST_REQUIRE_EQUAL(abi_serializer::to_abi(accnt.abi, abi), true);
-        abi_ser.set_abi(abi, abi_serializer_max_time);
-
-        EXECUTE_ACTION(eosio_token.create(N(dex.admin), asset::from_string("100000.0000 USD")));
-        produce_blocks(1);
-        EXECUTE_ACTION(eosio_token.issue( N(dex.admin), asset::from_string("100000.0000 USD"), "" ));
-        EXECUTE_ACTION(eosio_token.transfer( N(dex.admin), N(alice), asset::from_string("10000.0000 USD"), "" ) );
-
-        EXECUTE_ACTION(eosio_token.create(N(dex.admin), asset::from_string("10.00000000 BTC")));
-        EXECUTE_ACTION(eosio_token.issue( N(dex.admin), asset::from_string("10.00000000 BTC"), "" ));
-        EXECUTE_ACTION(eosio_token.transfer( N(dex.admin), N(bob), asset::from_string("1.00000000 BTC"), "" ) );
-
-    }
-
-    inline time_point get_head_block_time() {
-        return control->head_block_state()->block->timestamp.to_time_point();
-    }
-
-    action_result push_action( const account_name& signer, const action_name &name, const variant_object &data ) {
-        string action_type_name = abi_ser.get_action_type(name);
-        BOOST_REQUIRE_NE(action_type_name, "");
-        action act;
-        act.account = N(dex);
-        act.name    = name;
-        act.data    = abi_ser.variant_to_binary( action_type_name, data,abi_serializer_max_time );
-
-        return base_tester::push_action( std::move(act), signer.to_uint64_t() );
-    }
-
-    fc::variant get_conf( )
-    {
-        auto data = get_row_by_account( N(dex), N(dex), N(config), N(config) );
-        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "config", data, abi_serializer_max_time );
-    }
-
-    fc::variant get_symbol_pair( uint64_t sympair_id)
-    {
-        vector<char> data = get_row_by_account( N(dex), N(dex), N(sympair), name(sympair_id) );
-        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "symbol_pair_t", data, abi_serializer_max_time );
-    }
-
-    fc::variant get_order( uint64_t order_id)
-    {
-        vector<char> data = get_row_by_account( N(dex), N(dex), N(order), name(order_id) );
-        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "order_t", data, abi_serializer_max_time );
-    }
-
-    fc::variant get_account( const name &user, uint64_t account_id)
-    {
-        vector<char> data = get_row_by_account( N(dex), user, N(account), name(account_id) );
-        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "account_t", data, abi_serializer_max_time );
-    }
-
-    action_result setconfig( const variant_object &conf ) {
-        return push_action( N(dex), N(setconfig), mvo()
-            ( "conf", conf)
-        );
-    }
-
-    action_result setsympair(const extended_symbol &asset_symbol,
-                             const extended_symbol &coin_symbol, const asset &min_asset_quant,
-                             const asset &min_coin_quant, bool only_accept_coin_fee, bool enabled) {
-        auto ret = push_action( N(dex.admin), N(setsympair), mvo()
-            ( "asset_symbol", asset_symbol)
-            ( "coin_symbol", coin_symbol)
-            ( "min_asset_quant", min_asset_quant)
-            ( "min_coin_quant", min_coin_quant)
-            ( "only_accept_coin_fee", only_accept_coin_fee)
-            ( "enabled", enabled)
-        );
-        // sympair_id().next();
-        return ret;
-    }
-
-    action_result deposit(const name &from, const asset &quantity) {
-        return eosio_token.transfer(from, N(dex), quantity, "deposit");
-    }
-
-    struct order_config_ex_t {
-        uint64_t taker_fee_ratio = 0;
-        uint64_t maker_fee_ratio = 0;
-    };
-
-    action_result neworder(const name &user, const uint64_t &sympair_id,
-        const name &order_type, const name &order_side,
-        const asset &limit_quant,
-        const asset &frozen_quant,
-        const asset &price,
-        const uint64_t &external_id,
-        const std::optional<order_config_ex_t> &order_config_ex) {
-
-        return push_action( user, N(neworder), mvo()
-            ( "user", user)
-            ( "sympair_id", sympair_id)
-            ( "order_type", order_type)
-            ( "order_side", order_side)
-            ( "limit_quant", limit_quant)
-            ( "frozen_quant", frozen_quant)
-            ( "price", price)
-            ( "external_id", external_id)
-            ( "order_config_ex", fc::variant())
-        );
-    }
-
-    action_result match(uint32_t max_count, const std::vector<uint64_t> &sym_pairs, const string &memo) {
-        return push_action( N(dex.matcher), N(match), mvo()
-            ("matcher", N(dex.matcher))
-            ("max_count", max_count)
-            ("sym_pairs", sym_pairs)
-            ("memo", memo)
-        );
-    }
-
-    action_result cancel(const name &owner, const uint64_t &order_id) {
-        return push_action( owner, N(cancel), mvo()
-            ( "order_id", order_id)
-        );
-    }
-
-    void init_config() {
-        auto conf = mvo()
-            ("dex_enabled", true)
-            ("dex_admin", N(dex.admin))
-            ("dex_fee_collector", N(dex.fee))
-            ("taker_fee_ratio", 8)
-            ("maker_fee_ratio", 4)
-            ("max_match_count", uint32_t(0))
-            ("admin_sign_required", false)
-            ("data_recycle_sec", 90 * 3600 * 24);
-
-        EXECUTE_ACTION(setconfig( conf ));
-        produce_blocks(1);
-        auto conf_store = get_conf();
-        REQUIRE_MATCHING_OBJECT(get_conf(), conf);
-    }
-
-    void init_sym_pair() {
-        // add symbol pair for trading
-        EXECUTE_ACTION(setsympair(BTC_SYMBOL, USD_SYMBOL, ASSET("0.00001000 BTC"), ASSET("0.1000 USD"), false, true));
-        uint64_t sympair_id = 1;
-        auto sym_pair = get_symbol_pair(sympair_id);
-
-        REQUIRE_MATCH_OBJ( sym_pair,
-            MATCH_FIELD("sympair_id", sympair_id)
-            MATCH_FIELD_OBJ("asset_symbol", BTC_SYMBOL)
-            MATCH_FIELD_OBJ("coin_symbol", USD_SYMBOL)
-            MATCH_FIELD("min_asset_quant", "0.00001000 BTC")
-            MATCH_FIELD("min_coin_quant", "0.1000 USD")
-            MATCH_FIELD("only_accept_coin_fee", "0")
-            MATCH_FIELD("enabled", "1")
-        );
-    }
-
-    mvo init_buy_order(uint64_t sympair_id) {
-        // buy order
-        EXECUTE_ACTION(deposit(N(alice), ASSET("100.0000 USD")));
-        auto account = get_account(N(alice), 0);
-
-        REQUIRE_MATCH_OBJ( account,
-            MATCH_FIELD("id", 0)
-            REQUIRE_MATCH_FIELD_OBJ("balance",
-                MATCH_FIELD("contract", "eosio.token")
-                MATCH_FIELD("quantity", "100.0000 USD")
-            )
-        );
-
-        uint64_t order_id = 1;
-        EXECUTE_ACTION(neworder(N(alice), order_id, N(limit), N(buy), ASSET("0.01000000 BTC"), ASSET("100.0000 USD"),
-                ASSET("10000.0000 USD"), 1, std::nullopt));
-        auto buy_order = get_order(order_id);
-        auto expected_order = mvo()
-            ("sympair_id", 1)
-            ("order_id", order_id)
-            ("owner", "alice")
-            ("order_type", "limit")
-            ("order_side", "buy")
-            ("price", "10000.0000 USD")
-            ("limit_quant", "0.01000000 BTC")
-            ("frozen_quant", "100.0000 USD")
-            ("external_id", 1)
-            ("taker_fee_ratio", 8)
-            ("maker_fee_ratio", 4)
-            ("matched_assets", "0.00000000 BTC")
-            ("matched_coins", "0.0000 USD")
-            ("matched_fee", "0.00000000 BTC")
-            ("status", "matchable")
-            ("created_at", get_head_block_time())
-            ("last_updated_at", get_head_block_time())
-            ("last_deal_id", 0);
-        REQUIRE_MATCHING_OBJECT( buy_order, expected_order );
-        return expected_order;
-    }
-
-    abi_serializer abi_ser;
-    eosio_token_helper eosio_token;
-};
+#include "dex_tester.hpp"
 
 BOOST_AUTO_TEST_SUITE(dex_tests)
 
@@ -484,4 +122,446 @@ BOOST_FIXTURE_TEST_CASE( dex_match_test, dex_tester ) try {
     REQUIRE_MATCHING_OBJECT( matched_sell_order, sell_order );
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( dex_counters_test, dex_tester ) try {
+
+    init_config();
+    init_sym_pair();
+    init_buy_order(1); // order 1, 0.01000000 BTC at 10000.0000 USD
+
+    EXECUTE_ACTION(deposit(N(bob), ASSET("0.02000000 BTC")));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.01000000 BTC"), ASSET("0.01000000 BTC"),
+            ASSET("10000.0000 USD"), 2, std::nullopt));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.01000000 BTC"), ASSET("0.01000000 BTC"),
+            ASSET("20000.0000 USD"), 3, std::nullopt));
+    EXECUTE_ACTION(match(100, {1}, "test"));
+    EXECUTE_ACTION(cancel(N(bob), 3));
+
+    REQUIRE_MATCH_OBJ( get_counters(name(1)),
+        MATCH_FIELD("open_buy_orders", 0)
+        MATCH_FIELD("open_sell_orders", 0)
+        MATCH_FIELD("total_orders", 3)
+        MATCH_FIELD("deal_rows", 1)
+        MATCH_FIELD("fills", 1)
+        MATCH_FIELD("cancels", 1)
+        MATCH_FIELD("balance_rows", 0)
+        MATCH_FIELD("asset_volume", 1000000)
+        MATCH_FIELD("coin_volume", 1000000)
+    );
+    // balances: alice USD and BTC, bob BTC and USD, dex.fee BTC and USD
+    REQUIRE_MATCH_OBJ( get_counters(N(dex)),
+        MATCH_FIELD("open_buy_orders", 0)
+        MATCH_FIELD("open_sell_orders", 0)
+        MATCH_FIELD("total_orders", 3)
+        MATCH_FIELD("deal_rows", 1)
+        MATCH_FIELD("fills", 1)
+        MATCH_FIELD("cancels", 1)
+        MATCH_FIELD("balance_rows", 6)
+        MATCH_FIELD("asset_volume", 0)
+        MATCH_FIELD("coin_volume", 0)
+    );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( dex_market_test, dex_tester ) try {
+
+    init_config();
+    init_sym_pair();
+    BOOST_REQUIRE( get_market(1).is_null() );
+    init_buy_order(1); // order 1, 0.01000000 BTC at 10000.0000 USD
+
+    EXECUTE_ACTION(deposit(N(bob), ASSET("0.01000000 BTC")));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.00400000 BTC"), ASSET("0.00400000 BTC"),
+            ASSET("9000.0000 USD"), 2, std::nullopt));
+    EXECUTE_ACTION(match(100, {1}, "test"));
+
+    // the latest deal price and the candles are written to the sympair row together
+    REQUIRE_MATCH_OBJ( get_symbol_pair(1),
+        MATCH_FIELD("latest_deal_price", "10000.0000 USD")
+    );
+    auto market = get_market(1);
+    BOOST_REQUIRE( !market.is_null() );
+    BOOST_REQUIRE_EQUAL( market["candles"].get_array().size(), 3u );
+    auto first_minute = fc::time_point_sec::from_iso_string( market["candles"][size_t(0)]["start"].as_string() );
+    REQUIRE_MATCH_OBJ( market["candles"][size_t(0)],
+        MATCH_FIELD("open", 100000000)
+        MATCH_FIELD("close", 100000000)
+        MATCH_FIELD("asset_volume", 400000)
+        MATCH_FIELD("coin_volume", 400000)
+        MATCH_FIELD("deals", 1)
+    );
+
+    // a deal one minute later closes the first 1m candle into the ring
+    produce_block( fc::seconds(60) );
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.00600000 BTC"), ASSET("0.00600000 BTC"),
+            ASSET("9000.0000 USD"), 3, std::nullopt));
+    EXECUTE_ACTION(match(100, {1}, "test"));
+
+    uint64_t slot = (uint64_t(60) << 32) | (first_minute.sec_since_epoch() / 60 % 1440);
+    auto closed = get_candle(1, slot);
+    BOOST_REQUIRE( !closed.is_null() );
+    REQUIRE_MATCH_OBJ( closed["candle"],
+        MATCH_FIELD("deals", 1)
+        MATCH_FIELD("asset_volume", 400000)
+    );
+    market = get_market(1);
+    REQUIRE_MATCH_OBJ( market["candles"][size_t(0)],
+        MATCH_FIELD("deals", 1)
+        MATCH_FIELD("asset_volume", 600000)
+    );
+    // the 1d candle still holds both deals
+    REQUIRE_MATCH_OBJ( market["candles"][size_t(2)],
+        MATCH_FIELD("deals", 2)
+        MATCH_FIELD("asset_volume", 1000000)
+        MATCH_FIELD("coin_volume", 1000000)
+    );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( dex_pool_test, dex_tester ) try {
+
+    init_config();
+    init_sym_pair();
+    EXECUTE_ACTION(eosio_token.transfer( N(dex.admin), N(carol), ASSET("0.10000000 BTC"), "" ));
+    EXECUTE_ACTION(eosio_token.transfer( N(dex.admin), N(carol), ASSET("1000.0000 USD"), "" ));
+    EXECUTE_ACTION(deposit(N(carol), ASSET("0.10000000 BTC")));
+    EXECUTE_ACTION(deposit(N(carol), ASSET("1000.0000 USD")));
+
+    EXECUTE_ACTION(setpool(1, 30, true));
+    EXECUTE_ACTION(addliquidity(N(carol), 1, ASSET("0.10000000 BTC"), ASSET("1000.0000 USD")));
+    REQUIRE_MATCH_OBJ( get_pool(1),
+        MATCH_FIELD("asset_reserve", "0.10000000 BTC")
+        MATCH_FIELD("coin_reserve", "1000.0000 USD")
+        MATCH_FIELD("total_shares", 10000000)
+    );
+    REQUIRE_MATCH_OBJ( get_lp_share(1, N(carol)), MATCH_FIELD("shares", 10000000) );
+
+    // the book is empty, the pool fills the market sell order
+    // out = 10000000 * 99700 / (10000000 + 99700) = 98715, after the lp fee of 300
+    EXECUTE_ACTION(deposit(N(bob), ASSET("0.00200000 BTC")));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(market), N(sell), ASSET("0.00100000 BTC"), ASSET("0.00100000 BTC"),
+            ASSET("0.0000 USD"), 1, std::nullopt));
+    REQUIRE_MATCH_OBJ( get_order(1),
+        MATCH_FIELD("status", "completed")
+        MATCH_FIELD("matched_assets", "0.00100000 BTC")
+        MATCH_FIELD("matched_coins", "9.8715 USD")
+        MATCH_FIELD("matched_fee", "0.0079 USD")
+    );
+    REQUIRE_MATCH_OBJ( get_account(N(bob), 1),
+        REQUIRE_MATCH_FIELD_OBJ("balance", MATCH_FIELD("quantity", "9.8636 USD"))
+    );
+    REQUIRE_MATCH_OBJ( get_pool(1),
+        MATCH_FIELD("asset_reserve", "0.10100000 BTC")
+        MATCH_FIELD("coin_reserve", "990.1285 USD")
+    );
+
+    // the resting buy order gives a better price, the market order is left to the book
+    EXECUTE_ACTION(deposit(N(alice), ASSET("100.0000 USD")));
+    EXECUTE_ACTION(neworder(N(alice), 1, N(limit), N(buy), ASSET("0.00100000 BTC"), ASSET("20.0000 USD"),
+            ASSET("20000.0000 USD"), 2, std::nullopt));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(market), N(sell), ASSET("0.00100000 BTC"), ASSET("0.00100000 BTC"),
+            ASSET("0.0000 USD"), 3, std::nullopt));
+    REQUIRE_MATCH_OBJ( get_order(3), MATCH_FIELD("status", "matchable") );
+    REQUIRE_MATCH_OBJ( get_pool(1), MATCH_FIELD("asset_reserve", "0.10100000 BTC") );
+
+    EXECUTE_ACTION(rmliquidity(N(carol), 1, 10000000));
+    REQUIRE_MATCH_OBJ( get_pool(1),
+        MATCH_FIELD("asset_reserve", "0.00000000 BTC")
+        MATCH_FIELD("coin_reserve", "0.0000 USD")
+        MATCH_FIELD("total_shares", 0)
+    );
+    BOOST_REQUIRE( get_lp_share(1, N(carol)).is_null() );
+    REQUIRE_MATCH_OBJ( get_account(N(carol), 0),
+        REQUIRE_MATCH_FIELD_OBJ("balance", MATCH_FIELD("quantity", "0.10100000 BTC"))
+    );
+    REQUIRE_MATCH_OBJ( get_account(N(carol), 1),
+        REQUIRE_MATCH_FIELD_OBJ("balance", MATCH_FIELD("quantity", "990.1285 USD"))
+    );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( dex_auction_test, dex_tester ) try {
+
+    init_config();
+    init_sym_pair();
+    EXECUTE_ACTION(setauction(1, 10, true));
+
+    EXECUTE_ACTION(deposit(N(alice), ASSET("1000.0000 USD")));
+    EXECUTE_ACTION(deposit(N(bob), ASSET("0.10000000 BTC")));
+    EXECUTE_ACTION(neworder(N(alice), 1, N(limit), N(buy), ASSET("0.01000000 BTC"), ASSET("101.0000 USD"),
+            ASSET("10100.0000 USD"), 1, std::nullopt));
+    EXECUTE_ACTION(neworder(N(alice), 1, N(limit), N(buy), ASSET("0.02000000 BTC"), ASSET("201.0000 USD"),
+            ASSET("10050.0000 USD"), 2, std::nullopt));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.01500000 BTC"), ASSET("0.01500000 BTC"),
+            ASSET("9900.0000 USD"), 3, std::nullopt));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.01000000 BTC"), ASSET("0.01000000 BTC"),
+            ASSET("10000.0000 USD"), 4, std::nullopt));
+    BOOST_REQUIRE_EQUAL( wasm_assert_msg("The symbol pair '1' in auction mode only accepts limit order"),
+        neworder(N(bob), 1, N(market), N(sell), ASSET("0.01000000 BTC"), ASSET("0.01000000 BTC"),
+            ASSET("0.0000 USD"), 5, std::nullopt));
+    BOOST_REQUIRE_EQUAL( wasm_assert_msg("The indicated sym_pair=1 is in auction mode"),
+        match(100, {1}, "test"));
+
+    // the buy orders keep the fee symbol they were placed with
+    EXECUTE_ACTION(setsympair(BTC_SYMBOL, USD_SYMBOL, ASSET("0.00001000 BTC"), ASSET("0.1000 USD"), true, true));
+
+    // the last crossing orders are buy 10050 and sell 10000, so all fills are at 10025
+    EXECUTE_ACTION(clear(1, 100, "test"));
+    REQUIRE_MATCH_OBJ( get_order(1),
+        MATCH_FIELD("status", "completed")
+        MATCH_FIELD("matched_coins", "100.2500 USD")
+    );
+    REQUIRE_MATCH_OBJ( get_order(2),
+        MATCH_FIELD("status", "matchable")
+        MATCH_FIELD("matched_assets", "0.01500000 BTC")
+        MATCH_FIELD("matched_coins", "150.3750 USD")
+    );
+    REQUIRE_MATCH_OBJ( get_order(3), MATCH_FIELD("status", "completed") );
+    REQUIRE_MATCH_OBJ( get_order(4), MATCH_FIELD("status", "completed") );
+    // the buyer got 0.025 BTC less the fee 0.00002 BTC, and the refund 0.75 USD of order 1
+    REQUIRE_MATCH_OBJ( get_account(N(alice), 0),
+        REQUIRE_MATCH_FIELD_OBJ("balance", MATCH_FIELD("quantity", "698.7500 USD"))
+    );
+    REQUIRE_MATCH_OBJ( get_account(N(alice), 1),
+        REQUIRE_MATCH_FIELD_OBJ("balance", MATCH_FIELD("quantity", "0.02498000 BTC"))
+    );
+    REQUIRE_MATCH_OBJ( get_account(N(bob), 1),
+        REQUIRE_MATCH_FIELD_OBJ("balance", MATCH_FIELD("quantity", "250.4245 USD"))
+    );
+    REQUIRE_MATCH_OBJ( get_counters(name(1)),
+        MATCH_FIELD("deal_rows", 3)
+        MATCH_FIELD("fills", 3)
+    );
+    // each fill has its deal item with the ids of its orders
+    REQUIRE_MATCH_OBJ( get_deal(get_order(1)["last_deal_id"].as_uint64()),
+        MATCH_FIELD("buy_order_id", 1)
+        MATCH_FIELD("sell_order_id", 3)
+        MATCH_FIELD("deal_assets", "0.01000000 BTC")
+        MATCH_FIELD("buy_fee", "0.00000800 BTC")
+        MATCH_FIELD("buy_refund_coins", "0.7500 USD")
+    );
+    REQUIRE_MATCH_OBJ( get_deal(get_order(4)["last_deal_id"].as_uint64()),
+        MATCH_FIELD("buy_order_id", 2)
+        MATCH_FIELD("sell_order_id", 4)
+    );
+    // the candle counts every fill of the auction
+    REQUIRE_MATCH_OBJ( get_market(1)["candles"][size_t(0)],
+        MATCH_FIELD("open", 100250000)
+        MATCH_FIELD("close", 100250000)
+        MATCH_FIELD("asset_volume", 2500000)
+        MATCH_FIELD("coin_volume", 2506250)
+        MATCH_FIELD("deals", 3)
+    );
+
+    // too early for the next clear
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.00500000 BTC"), ASSET("0.00500000 BTC"),
+            ASSET("10000.0000 USD"), 6, std::nullopt));
+    BOOST_REQUIRE( clear(1, 100, "test") != "" );
+    produce_blocks(10);
+    EXECUTE_ACTION(clear(1, 100, "test"));
+    REQUIRE_MATCH_OBJ( get_order(2), MATCH_FIELD("status", "completed") );
+
+    // cleandata erases the orders completed by the auction with their deal items
+    EXECUTE_ACTION(setconfig( mvo()
+        ("dex_enabled", true)
+        ("dex_admin", N(dex.admin))
+        ("dex_fee_collector", N(dex.fee))
+        ("taker_fee_ratio", 8)
+        ("maker_fee_ratio", 4)
+        ("max_match_count", uint32_t(0))
+        ("admin_sign_required", false)
+        ("data_recycle_sec", 1) ));
+    produce_block( fc::seconds(10) );
+    EXECUTE_ACTION(cleandata(100));
+    for (uint64_t order_id : {1, 2, 3, 4, 6}) {
+        BOOST_REQUIRE( get_order(order_id).is_null() );
+    }
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( dex_route_test, dex_tester ) try {
+
+    init_config();
+    init_sym_pair();
+    EXECUTE_ACTION(eosio_token.create(N(dex.admin), ASSET("1000.0000 EOS")));
+    EXECUTE_ACTION(eosio_token.issue( N(dex.admin), ASSET("1000.0000 EOS"), "" ));
+    EXECUTE_ACTION(eosio_token.transfer( N(dex.admin), N(carol), ASSET("100.0000 EOS"), "" ));
+    EXECUTE_ACTION(setsympair(EOS_SYMBOL, USD_SYMBOL, ASSET("0.0010 EOS"), ASSET("0.1000 USD"), true, true));
+
+    EXECUTE_ACTION(deposit(N(bob), ASSET("0.10000000 BTC")));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.01000000 BTC"), ASSET("0.01000000 BTC"),
+            ASSET("10000.0000 USD"), 1, std::nullopt));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.01000000 BTC"), ASSET("0.01000000 BTC"),
+            ASSET("10100.0000 USD"), 2, std::nullopt));
+    EXECUTE_ACTION(deposit(N(alice), ASSET("1000.0000 USD")));
+    EXECUTE_ACTION(neworder(N(alice), 2, N(limit), N(buy), ASSET("50.0000 EOS"), ASSET("200.1600 USD"),
+            ASSET("4.0000 USD"), 3, std::nullopt));
+    EXECUTE_ACTION(newtrigger(N(bob), 1, N(takeprofit), ASSET("10050.0000 USD"), N(limit), N(sell),
+            ASSET("0.01000000 BTC"), ASSET("10200.0000 USD"), 4));
+
+    // EOS -> USD -> BTC: 40 EOS sell for 160 USD less the taker fee 0.128 USD, which buys
+    // 0.01 BTC at 10000 and 59.872 USD / 10100 = 0.00592792 BTC, less the taker fees in BTC
+    EXECUTE_ACTION(deposit(N(carol), ASSET("40.0000 EOS")));
+    BOOST_REQUIRE_EQUAL( wasm_assert_msg("The route output 0.01591518 BTC is less than min_output 0.03000000 BTC"),
+        routeorder(N(carol), {2, 1}, ASSET("40.0000 EOS"), ASSET("0.03000000 BTC")));
+    EXECUTE_ACTION(routeorder(N(carol), {2, 1}, ASSET("40.0000 EOS"), ASSET("0.01000000 BTC")));
+
+    REQUIRE_MATCH_OBJ( get_account(N(carol), 1),
+        REQUIRE_MATCH_FIELD_OBJ("balance", MATCH_FIELD("quantity", "0.01591518 BTC"))
+    );
+    // no balance row for the intermediate USD
+    BOOST_REQUIRE( get_account(N(carol), 2).is_null() );
+    REQUIRE_MATCH_OBJ( get_order(1), MATCH_FIELD("status", "completed") );
+    REQUIRE_MATCH_OBJ( get_order(2),
+        MATCH_FIELD("status", "matchable")
+        MATCH_FIELD("matched_assets", "0.00592792 BTC")
+    );
+    REQUIRE_MATCH_OBJ( get_order(3), MATCH_FIELD("matched_assets", "40.0000 EOS") );
+
+    // the route deal at 10100 reaches the take-profit price, the order waits for the next match
+    BOOST_REQUIRE( get_trigger(0).is_null() );
+    REQUIRE_MATCH_OBJ( get_order(4),
+        MATCH_FIELD("owner", "bob")
+        MATCH_FIELD("external_id", 4)
+        MATCH_FIELD("status", "matchable")
+    );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( dex_trigger_test, dex_tester ) try {
+
+    init_config();
+    init_sym_pair();
+    EXECUTE_ACTION(eosio_token.transfer( N(dex.admin), N(carol), ASSET("0.10000000 BTC"), "" ));
+
+    EXECUTE_ACTION(deposit(N(alice), ASSET("1000.0000 USD")));
+    EXECUTE_ACTION(neworder(N(alice), 1, N(limit), N(buy), ASSET("0.01000000 BTC"), ASSET("100.0000 USD"),
+            ASSET("10000.0000 USD"), 1, std::nullopt));
+    EXECUTE_ACTION(neworder(N(alice), 1, N(limit), N(buy), ASSET("0.01000000 BTC"), ASSET("95.0000 USD"),
+            ASSET("9500.0000 USD"), 2, std::nullopt));
+
+    EXECUTE_ACTION(deposit(N(carol), ASSET("0.01000000 BTC")));
+    EXECUTE_ACTION(newtrigger(N(carol), 1, N(stop), ASSET("9800.0000 USD"), N(market), N(sell),
+            ASSET("0.00500000 BTC"), ASSET("0.0000 USD"), 3));
+    EXECUTE_ACTION(newtrigger(N(carol), 1, N(takeprofit), ASSET("12000.0000 USD"), N(limit), N(sell),
+            ASSET("0.00500000 BTC"), ASSET("12000.0000 USD"), 4));
+    REQUIRE_MATCH_OBJ( get_trigger(0),
+        MATCH_FIELD("owner", "carol")
+        MATCH_FIELD("frozen_quant", "0.00500000 BTC")
+    );
+    // the trigger orders are not in the order table
+    BOOST_REQUIRE( get_order(3).is_null() );
+
+    // the deal at 9500 reaches the stop price, the stop order is placed and matched in the same match
+    EXECUTE_ACTION(deposit(N(bob), ASSET("0.01500000 BTC")));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.01500000 BTC"), ASSET("0.01500000 BTC"),
+            ASSET("9000.0000 USD"), 5, std::nullopt));
+    EXECUTE_ACTION(match(100, {1}, "test"));
+
+    BOOST_REQUIRE( get_trigger(0).is_null() );
+    REQUIRE_MATCH_OBJ( get_order(4),
+        MATCH_FIELD("owner", "carol")
+        MATCH_FIELD("external_id", 3)
+        MATCH_FIELD("status", "completed")
+        MATCH_FIELD("matched_coins", "47.5000 USD")
+    );
+    REQUIRE_MATCH_OBJ( get_order(2), MATCH_FIELD("status", "completed") );
+
+    // the take-profit order is not reached, cancel it
+    EXECUTE_ACTION(canceltrig(N(carol), 1));
+    BOOST_REQUIRE( get_trigger(1).is_null() );
+    REQUIRE_MATCH_OBJ( get_account(N(carol), 0),
+        REQUIRE_MATCH_FIELD_OBJ("balance", MATCH_FIELD("quantity", "0.00500000 BTC"))
+    );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( dex_relay_test, dex_tester ) try {
+
+    init_config();
+    init_sym_pair();
+    EXECUTE_ACTION(deposit(N(alice), ASSET("1000.0000 USD")));
+    EXECUTE_ACTION(deposit(N(bob), ASSET("0.01000000 BTC")));
+    EXECUTE_ACTION(setrelaykey(N(alice), get_public_key(N(alice), "relay")));
+    EXECUTE_ACTION(setrelaykey(N(bob), get_public_key(N(bob), "relay")));
+
+    EXECUTE_ACTION(relayorders({
+        make_relay_order(N(alice), 1, N(limit), N(buy), ASSET("0.01000000 BTC"), ASSET("10000.0000 USD"), 1, 1),
+        make_relay_order(N(bob), 1, N(limit), N(sell), ASSET("0.01000000 BTC"), ASSET("10000.0000 USD"), 2, 5),
+    }));
+    REQUIRE_MATCH_OBJ( get_order(1),
+        MATCH_FIELD("owner", "alice")
+        MATCH_FIELD("frozen_quant", "100.0000 USD")
+    );
+    REQUIRE_MATCH_OBJ( get_order(2), MATCH_FIELD("owner", "bob") );
+
+    // replayed nonce
+    BOOST_REQUIRE_EQUAL( wasm_assert_msg("The nonce=5 of user=bob must > the last nonce=5"),
+        relayorders({ make_relay_order(N(bob), 1, N(limit), N(sell), ASSET("0.01000000 BTC"), ASSET("10000.0000 USD"), 2, 5) }));
+    // signed by another key
+    auto forged = make_relay_order(N(carol), 1, N(limit), N(buy), ASSET("0.01000000 BTC"), ASSET("10000.0000 USD"), 3, 2);
+    forged = mvo(forged.get_object())("user", N(alice));
+    BOOST_REQUIRE( relayorders({ forged }) != "" );
+    // signed for another chain
+    BOOST_REQUIRE( relayorders({ make_relay_order(N(alice), 1, N(limit), N(buy), ASSET("0.01000000 BTC"),
+        ASSET("10000.0000 USD"), 3, 2, fc::sha256::hash(std::string("other chain"))) }) != "" );
+    // the owner must be an account, as for neworder
+    BOOST_REQUIRE_EQUAL( wasm_assert_msg("Account of user=nobody does not existed"),
+        relayorders({ make_relay_order(N(nobody), 1, N(limit), N(buy), ASSET("0.01000000 BTC"), ASSET("10000.0000 USD"), 3, 1) }));
+    // only the admin submits
+    BOOST_REQUIRE_EQUAL( error("missing authority of dex.admin"),
+        push_action( N(alice), N(relayorders), mvo()("orders", std::vector<fc::variant>{
+            make_relay_order(N(alice), 1, N(limit), N(buy), ASSET("0.01000000 BTC"), ASSET("10000.0000 USD"), 3, 2) })));
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( dex_snapshot_test, dex_tester ) try {
+
+    init_config();
+    init_sym_pair();
+    // bookchunk is sent inline with the active permission of dex
+    set_authority( N(dex), config::active_name, authority( 1,
+        { key_weight{ get_public_key(N(dex), "active"), 1 } },
+        { permission_level_weight{ { N(dex), config::eosio_code_name }, 1 } } ), config::owner_name );
+
+    EXECUTE_ACTION(deposit(N(alice), ASSET("1000.0000 USD")));
+    EXECUTE_ACTION(deposit(N(bob), ASSET("0.03000000 BTC")));
+    EXECUTE_ACTION(neworder(N(alice), 1, N(limit), N(buy), ASSET("0.01000000 BTC"), ASSET("100.0000 USD"),
+            ASSET("10000.0000 USD"), 1, std::nullopt));
+    EXECUTE_ACTION(neworder(N(alice), 1, N(limit), N(buy), ASSET("0.01000000 BTC"), ASSET("96.0000 USD"),
+            ASSET("9600.0000 USD"), 2, std::nullopt));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.01000000 BTC"), ASSET("0.01000000 BTC"),
+            ASSET("11000.0000 USD"), 3, std::nullopt));
+    EXECUTE_ACTION(neworder(N(bob), 1, N(limit), N(sell), ASSET("0.00500000 BTC"), ASSET("0.00500000 BTC"),
+            ASSET("10000.0000 USD"), 4, std::nullopt));
+    EXECUTE_ACTION(match(10, {1}, "test"));
+
+    // the best buy first, then the sells from the best, the completed order 4 is not in the book
+    auto chunks = snapshot(1, fc::variant(), 2);
+    BOOST_REQUIRE_EQUAL( chunks.size(), 1u );
+    REQUIRE_MATCH_OBJ( chunks[0],
+        MATCH_FIELD("sympair_id", 1)
+        MATCH_FIELD("last_deal_id", 1)
+    );
+    auto orders = chunks[0]["orders"].get_array();
+    BOOST_REQUIRE_EQUAL( orders.size(), 2u );
+    REQUIRE_MATCH_OBJ( orders[0],
+        MATCH_FIELD("order_id", 1)
+        MATCH_FIELD("matched_assets", 500000)
+        MATCH_FIELD("matched_coins", 500000)
+    );
+    REQUIRE_MATCH_OBJ( orders[1], MATCH_FIELD("order_id", 2) );
+    auto cursor = chunks[0]["next_cursor"];
+    REQUIRE_MATCH_OBJ( cursor,
+        MATCH_FIELD("order_side", "buy")
+        MATCH_FIELD("price", 96000000)
+        MATCH_FIELD("order_id", 2)
+    );
+
+    // resume after the cursor, even though its order is canceled since
+    EXECUTE_ACTION(cancel(N(alice), 2));
+    chunks = snapshot(1, cursor, 10);
+    BOOST_REQUIRE_EQUAL( chunks.size(), 1u );
+    orders = chunks[0]["orders"].get_array();
+    BOOST_REQUIRE_EQUAL( orders.size(), 1u );
+    REQUIRE_MATCH_OBJ( orders[0],
+        MATCH_FIELD("order_id", 3)
+        MATCH_FIELD("order_side", "sell")
+        MATCH_FIELD("limit_quant", 1000000)
+    );
+    BOOST_REQUIRE( chunks[0]["next_cursor"].is_null() );
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
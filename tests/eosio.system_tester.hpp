@@ -260,6 +260,17 @@ public:
       return buyrambytes( account_name(payer), account_name(receiver), numbytes );
    }
 
+   action_result onboard( const account_name& payer, const vector<account_name>& receivers, uint32_t numbytes,
+                          const asset& net, const asset& cpu ) {
+      return push_action( payer, N(onboard), mvo()
+                          ("payer",              payer)
+                          ("receivers",          receivers)
+                          ("bytes",              numbytes)
+                          ("stake_net_quantity", net)
+                          ("stake_cpu_quantity", cpu)
+      );
+   }
+
    action_result sellram( const account_name& account, uint64_t numbytes ) {
       return push_action( account, N(sellram), mvo()( "account", account)("bytes",numbytes) );
    }
@@ -337,6 +348,10 @@ public:
       return unstake( account_name(acnt), net, cpu );
    }
 
+   action_result runrefunds( const account_name& caller, uint16_t max ) {
+      return push_action( caller, N(runrefunds), mvo()("max", max) );
+   }
+
    int64_t bancor_convert( int64_t S, int64_t R, int64_t T ) { return double(R) * T  / ( double(S) + T ); };
 
    int64_t get_net_limit( account_name a ) {
@@ -824,6 +839,23 @@ public:
       return get_producer_info( account_name(act) );
    }
 
+   // the row's count plus the blocks of the current round, which stay in the global state until the row is updated
+   uint32_t get_producer_unpaid_blocks( const account_name& act ) {
+      uint32_t unpaid_blocks = get_producer_info( act )["unpaid_blocks"].as<uint32_t>();
+      const auto gs = get_global_state();
+      if( gs.get_object().contains( "round_unpaid_blocks" ) ) {
+         for( const auto& c : gs["round_unpaid_blocks"].get_array() ) {
+            if( c["producer"].as<account_name>() == act ) {
+               unpaid_blocks += c["unpaid_blocks"].as<uint32_t>();
+            }
+         }
+      }
+      return unpaid_blocks;
+   }
+   uint32_t get_producer_unpaid_blocks( std::string_view act ) {
+      return get_producer_unpaid_blocks( account_name(act) );
+   }
+
    fc::variant get_producer_info2( const account_name& act ) {
       vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, N(producers2), act );
       return abi_ser.binary_to_variant( "producer_info2", data, abi_serializer_max_time );
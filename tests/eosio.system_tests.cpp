@@ -174,6 +174,72 @@ BOOST_FIXTURE_TEST_CASE( buysell, eosio_system_tester ) try {
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( onboard_receivers, eosio_system_tester ) try {
+
+   const account_name alice = N(alice1111111), bob = N(bob111111111), carol = N(carol1111111);
+   const asset net = core_sym::from_string("1.0000");
+   const asset cpu = core_sym::from_string("2.0000");
+   transfer( config::system_account_name, alice, core_sym::from_string("1000.0000"), config::system_account_name );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("no receivers"), onboard( alice, {}, 4096, net, cpu ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("too many receivers"), onboard( alice, std::vector<account_name>( 51, bob ), 4096, net, cpu ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("cannot onboard the payer"), onboard( alice, { bob, alice }, 4096, net, cpu ) );
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("must purchase or stake a positive amount"),
+                        onboard( alice, { bob, carol }, 0, core_sym::from_string("0.0000"), core_sym::from_string("0.0000") ) );
+
+   const auto bob_total0   = get_total_stake( bob );
+   const auto carol_total0 = get_total_stake( carol );
+   const asset alice_balance0  = get_balance( alice );
+   const asset stake_balance0  = get_balance( N(eosio.stake) );
+   const asset ram_balance0    = get_balance( N(eosio.ram) );
+   const asset ramfee_balance0 = get_balance( N(eosio.ramfee) );
+   const auto  alice_voter0    = get_voter_info( alice );
+   const int64_t alice_staked0 = alice_voter0.is_null() ? 0 : alice_voter0["staked"].as_int64();
+
+   BOOST_REQUIRE_EQUAL( success(), onboard( alice, { bob, carol }, 4096, net, cpu ) );
+
+   // one ram purchase for both, shared evenly
+   const int64_t bob_bytes   = get_total_stake( bob )["ram_bytes"].as_int64() - bob_total0["ram_bytes"].as_int64();
+   const int64_t carol_bytes = get_total_stake( carol )["ram_bytes"].as_int64() - carol_total0["ram_bytes"].as_int64();
+   BOOST_REQUIRE( within_error( 4096, bob_bytes, 2 ) );
+   BOOST_REQUIRE( within_one( bob_bytes, carol_bytes ) );
+   BOOST_REQUIRE( bob_bytes >= carol_bytes );
+
+   // each receiver gets the full stake, delegated from alice
+   for( const auto& [receiver, total0] : { std::make_pair( bob, bob_total0 ), std::make_pair( carol, carol_total0 ) } ) {
+      const auto total = get_total_stake( receiver );
+      BOOST_REQUIRE_EQUAL( total0["net_weight"].as<asset>() + net, total["net_weight"].as<asset>() );
+      BOOST_REQUIRE_EQUAL( total0["cpu_weight"].as<asset>() + cpu, total["cpu_weight"].as<asset>() );
+      const auto dbw = get_dbw_obj( alice, receiver );
+      BOOST_REQUIRE_EQUAL( net, dbw["net_weight"].as<asset>() );
+      BOOST_REQUIRE_EQUAL( cpu, dbw["cpu_weight"].as<asset>() );
+   }
+   BOOST_REQUIRE_EQUAL( stake_balance0 + core_sym::from_string("6.0000"), get_balance( N(eosio.stake) ) );
+   BOOST_REQUIRE_EQUAL( alice_staked0 + 60000, get_voter_info( alice )["staked"].as_int64() );
+
+   const asset ram_paid = get_balance( N(eosio.ram) ) - ram_balance0;
+   const asset fee_paid = get_balance( N(eosio.ramfee) ) - ramfee_balance0;
+   BOOST_REQUIRE_EQUAL( alice_balance0 - core_sym::from_string("6.0000") - ram_paid - fee_paid, get_balance( alice ) );
+
+   // the stake is always transferred from the payer, a pending refund of the payer is left as it is
+   cross_15_percent_threshold();
+   BOOST_REQUIRE_EQUAL( success(), stake( alice, alice, core_sym::from_string("3.0000"), core_sym::from_string("3.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), unstake( alice, alice, core_sym::from_string("3.0000"), core_sym::from_string("3.0000") ) );
+   const asset alice_balance1 = get_balance( alice );
+   const asset stake_balance1 = get_balance( N(eosio.stake) );
+
+   BOOST_REQUIRE_EQUAL( success(), onboard( alice, { bob }, 0, net, cpu ) );
+   auto refund = get_refund_request( alice );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("3.0000"), refund["net_amount"].as<asset>() );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("3.0000"), refund["cpu_amount"].as<asset>() );
+   BOOST_REQUIRE_EQUAL( alice_balance1 - core_sym::from_string("3.0000"), get_balance( alice ) );
+   BOOST_REQUIRE_EQUAL( stake_balance1 + core_sym::from_string("3.0000"), get_balance( N(eosio.stake) ) );
+   const auto dbw = get_dbw_obj( alice, bob );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("2.0000"), dbw["net_weight"].as<asset>() );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("4.0000"), dbw["cpu_weight"].as<asset>() );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( stake_unstake, eosio_system_tester ) try {
    cross_15_percent_threshold();
 
@@ -239,6 +305,63 @@ BOOST_FIXTURE_TEST_CASE( stake_unstake, eosio_system_tester ) try {
    BOOST_REQUIRE_EQUAL( core_sym::from_string("1000.0000"), get_balance( "alice1111111" ) );
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( run_refunds, eosio_system_tester ) try {
+   cross_15_percent_threshold();
+
+   produce_blocks( 10 );
+   const account_name alice = N(alice1111111), bob = N(bob111111111), carol = N(carol1111111);
+   transfer( "eosio", "alice1111111", core_sym::from_string("1000.0000"), "eosio" );
+   transfer( "eosio", "bob111111111", core_sym::from_string("1000.0000"), "eosio" );
+
+   // bob's request is the oldest one, at the head of the queue
+   BOOST_REQUIRE_EQUAL( success(), stake( bob, bob, core_sym::from_string("100.0000"), core_sym::from_string("100.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), unstake( bob, bob, core_sym::from_string("100.0000"), core_sym::from_string("100.0000") ) );
+   produce_block( fc::seconds(2) );
+   BOOST_REQUIRE_EQUAL( success(), stake( alice, alice, core_sym::from_string("200.0000"), core_sym::from_string("100.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), unstake( alice, alice, core_sym::from_string("200.0000"), core_sym::from_string("100.0000") ) );
+
+   // a delegation to another account cancels the deferred refunds, only runrefunds or refund pays them now
+   BOOST_REQUIRE_EQUAL( success(), stake( bob, carol, core_sym::from_string("1.0000"), core_sym::from_string("1.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), stake( alice, carol, core_sym::from_string("1.0000"), core_sym::from_string("1.0000") ) );
+   produce_blocks( 1 );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("698.0000"), get_balance( alice ) );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("798.0000"), get_balance( bob ) );
+
+   // bob rejects every transfer notification from now on
+   set_code( bob, contracts::util::reject_all_wasm() );
+   produce_blocks( 1 );
+
+   // not matured yet
+   BOOST_REQUIRE_EQUAL( success(), runrefunds( carol, 10 ) );
+   produce_blocks( 2 );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("698.0000"), get_balance( alice ) );
+
+   produce_block( fc::days(3) );
+   produce_blocks( 2 );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("698.0000"), get_balance( alice ) );
+   BOOST_REQUIRE_EQUAL( false, get_refund_request( alice ).is_null() );
+
+   // the payment of bob fails on its own, alice behind him is paid
+   BOOST_REQUIRE_EQUAL( success(), runrefunds( carol, 10 ) );
+   try {
+      produce_block();
+   } catch( const eosio_assert_message_exception& e ) {
+      BOOST_REQUIRE( eosio_assert_message_is("rejecting all notifications")( e ) );
+   }
+   produce_blocks( 2 );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("998.0000"), get_balance( alice ) );
+   BOOST_REQUIRE_EQUAL( true, get_refund_request( alice ).is_null() );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("798.0000"), get_balance( bob ) );
+   BOOST_REQUIRE_EQUAL( false, get_refund_request( bob ).is_null() );
+
+   // bob's request left the queue, later calls do not retry it
+   BOOST_REQUIRE_EQUAL( success(), runrefunds( carol, 10 ) );
+   produce_blocks( 2 );
+   BOOST_REQUIRE_EQUAL( core_sym::from_string("798.0000"), get_balance( bob ) );
+   BOOST_REQUIRE_EQUAL( false, get_refund_request( bob ).is_null() );
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE( stake_unstake_with_transfer, eosio_system_tester ) try {
    cross_15_percent_threshold();
 
@@ -1219,6 +1342,38 @@ BOOST_FIXTURE_TEST_CASE( producer_keep_votes, eosio_system_tester, * boost::unit
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( refresh_votes_decay, eosio_system_tester, * boost::unit_test::tolerance(1e-10) ) try {
+   issue_and_transfer( "alice1111111", core_sym::from_string("1000.0000"),  config::system_account_name );
+   BOOST_REQUIRE_EQUAL( success(), regproducer( N(alice1111111) ) );
+
+   issue_and_transfer( "bob111111111", core_sym::from_string("2000.0000"),  config::system_account_name );
+   BOOST_REQUIRE_EQUAL( success(), stake( "bob111111111", core_sym::from_string("13.0000"), core_sym::from_string("0.5791") ) );
+   BOOST_REQUIRE_EQUAL( success(), vote( N(bob111111111), { N(alice1111111) } ) );
+   const double initial_votes = get_producer_info( "alice1111111" )["total_votes"].as_double();
+   BOOST_TEST_REQUIRE( stake2votes(core_sym::from_string("13.5791")) == initial_votes );
+
+   BOOST_REQUIRE_EQUAL( wasm_assert_msg("max_voters must be positive"),
+                        push_action( N(carol1111111), N(refreshvotes), mvo()("max_voters", 0) ) );
+
+   // two weeks later the votes of bob111111111 are worth more, but nothing changed them yet
+   produce_block( fc::days(14) );
+   produce_blocks(1);
+   BOOST_TEST_REQUIRE( initial_votes == get_producer_info( "alice1111111" )["total_votes"].as_double() );
+
+   // anyone can refresh them
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(carol1111111), N(refreshvotes), mvo()("max_voters", 100) ) );
+   const double refreshed_votes = get_producer_info( "alice1111111" )["total_votes"].as_double();
+   BOOST_TEST_REQUIRE( initial_votes < refreshed_votes );
+   BOOST_TEST_REQUIRE( stake2votes(core_sym::from_string("13.5791")) == refreshed_votes );
+   BOOST_TEST_REQUIRE( stake2votes(core_sym::from_string("13.5791")) == get_voter_info( "bob111111111" )["last_vote_weight"].as_double() );
+
+   // a refreshed weight is not applied twice
+   produce_blocks(1);
+   BOOST_REQUIRE_EQUAL( success(), push_action( N(carol1111111), N(refreshvotes), mvo()("max_voters", 100) ) );
+   BOOST_TEST_REQUIRE( refreshed_votes == get_producer_info( "alice1111111" )["total_votes"].as_double() );
+
+} FC_LOG_AND_RETHROW()
+
 
 BOOST_FIXTURE_TEST_CASE( vote_for_two_producers, eosio_system_tester, * boost::unit_test::tolerance(1e+5) ) try {
    //alice1111111 becomes a producer
@@ -1468,7 +1623,7 @@ BOOST_FIXTURE_TEST_CASE(producer_pay, eosio_system_tester, * boost::unit_test::t
       const uint32_t initial_tot_unpaid_blocks = initial_global_state["total_unpaid_blocks"].as<uint32_t>();
 
       prod = get_producer_info("defproducera");
-      const uint32_t unpaid_blocks = prod["unpaid_blocks"].as<uint32_t>();
+      const uint32_t unpaid_blocks = get_producer_unpaid_blocks("defproducera");
       BOOST_REQUIRE(1 < unpaid_blocks);
 
       BOOST_REQUIRE_EQUAL(initial_tot_unpaid_blocks, unpaid_blocks);
@@ -1486,7 +1641,7 @@ BOOST_FIXTURE_TEST_CASE(producer_pay, eosio_system_tester, * boost::unit_test::t
       const uint32_t tot_unpaid_blocks = global_state["total_unpaid_blocks"].as<uint32_t>();
 
       prod = get_producer_info("defproducera");
-      BOOST_REQUIRE_EQUAL(1, prod["unpaid_blocks"].as<uint32_t>());
+      BOOST_REQUIRE_EQUAL(1, get_producer_unpaid_blocks("defproducera"));
       BOOST_REQUIRE_EQUAL(1, tot_unpaid_blocks);
       const asset supply  = get_token_supply();
       const asset balance = get_balance(N(defproducera));
@@ -1545,7 +1700,7 @@ BOOST_FIXTURE_TEST_CASE(producer_pay, eosio_system_tester, * boost::unit_test::t
       const double   initial_tot_vote_weight   = initial_global_state["total_producer_vote_weight"].as<double>();
 
       prod = get_producer_info("defproducera");
-      const uint32_t unpaid_blocks = prod["unpaid_blocks"].as<uint32_t>();
+      const uint32_t unpaid_blocks = get_producer_unpaid_blocks("defproducera");
       BOOST_REQUIRE(1 < unpaid_blocks);
       BOOST_REQUIRE_EQUAL(initial_tot_unpaid_blocks, unpaid_blocks);
       BOOST_REQUIRE(0 < prod["total_votes"].as<double>());
@@ -1567,7 +1722,7 @@ BOOST_FIXTURE_TEST_CASE(producer_pay, eosio_system_tester, * boost::unit_test::t
       const uint32_t tot_unpaid_blocks = global_state["total_unpaid_blocks"].as<uint32_t>();
 
       prod = get_producer_info("defproducera");
-      BOOST_REQUIRE_EQUAL(1, prod["unpaid_blocks"].as<uint32_t>());
+      BOOST_REQUIRE_EQUAL(1, get_producer_unpaid_blocks("defproducera"));
       BOOST_REQUIRE_EQUAL(1, tot_unpaid_blocks);
       const asset supply  = get_token_supply();
       const asset balance = get_balance(N(defproducera));
@@ -1818,7 +1973,7 @@ BOOST_FIXTURE_TEST_CASE(multiple_producer_pay, eosio_system_tester, * boost::uni
       auto prodv = get_producer_info( N(defproducerv) );
       auto prodz = get_producer_info( N(defproducerz) );
 
-      BOOST_REQUIRE (0 == proda["unpaid_blocks"].as<uint32_t>() && 0 == prodz["unpaid_blocks"].as<uint32_t>());
+      BOOST_REQUIRE (0 == get_producer_unpaid_blocks( N(defproducera) ) && 0 == get_producer_unpaid_blocks( N(defproducerz) ));
 
       // check vote ratios
       BOOST_REQUIRE ( 0 < proda["total_votes"].as<double>() && 0 < prodz["total_votes"].as<double>() );
@@ -1834,13 +1989,13 @@ BOOST_FIXTURE_TEST_CASE(multiple_producer_pay, eosio_system_tester, * boost::uni
       produce_blocks(23 * 12 + 20);
       bool all_21_produced = true;
       for (uint32_t i = 0; i < 21; ++i) {
-         if (0 == get_producer_info(producer_names[i])["unpaid_blocks"].as<uint32_t>()) {
+         if (0 == get_producer_unpaid_blocks(producer_names[i])) {
             all_21_produced = false;
          }
       }
       bool rest_didnt_produce = true;
       for (uint32_t i = 21; i < producer_names.size(); ++i) {
-         if (0 < get_producer_info(producer_names[i])["unpaid_blocks"].as<uint32_t>()) {
+         if (0 < get_producer_unpaid_blocks(producer_names[i])) {
             rest_didnt_produce = false;
          }
       }
@@ -1876,7 +2031,7 @@ BOOST_FIXTURE_TEST_CASE(multiple_producer_pay, eosio_system_tester, * boost::uni
       const asset    initial_bpay_balance      = get_balance(N(eosio.bpay));
       const asset    initial_vpay_balance      = get_balance(N(eosio.vpay));
       const asset    initial_balance           = get_balance(prod_name);
-      const uint32_t initial_unpaid_blocks     = get_producer_info(prod_name)["unpaid_blocks"].as<uint32_t>();
+      const uint32_t initial_unpaid_blocks     = get_producer_unpaid_blocks(prod_name);
 
       BOOST_REQUIRE_EQUAL(success(), push_action(prod_name, N(claimrewards), mvo()("owner", prod_name)));
 
@@ -1890,7 +2045,7 @@ BOOST_FIXTURE_TEST_CASE(multiple_producer_pay, eosio_system_tester, * boost::uni
       const asset    bpay_balance      = get_balance(N(eosio.bpay));
       const asset    vpay_balance      = get_balance(N(eosio.vpay));
       const asset    balance           = get_balance(prod_name);
-      const uint32_t unpaid_blocks     = get_producer_info(prod_name)["unpaid_blocks"].as<uint32_t>();
+      const uint32_t unpaid_blocks     = get_producer_unpaid_blocks(prod_name);
 
       const uint64_t usecs_between_fills = claim_time - initial_claim_time;
       const int32_t secs_between_fills = static_cast<int32_t>(usecs_between_fills / 1000000);
@@ -1952,7 +2107,7 @@ BOOST_FIXTURE_TEST_CASE(multiple_producer_pay, eosio_system_tester, * boost::uni
       const asset    initial_bpay_balance      = get_balance(N(eosio.bpay));
       const asset    initial_vpay_balance      = get_balance(N(eosio.vpay));
       const asset    initial_balance           = get_balance(prod_name);
-      const uint32_t initial_unpaid_blocks     = get_producer_info(prod_name)["unpaid_blocks"].as<uint32_t>();
+      const uint32_t initial_unpaid_blocks     = get_producer_unpaid_blocks(prod_name);
 
       BOOST_REQUIRE_EQUAL(success(), push_action(prod_name, N(claimrewards), mvo()("owner", prod_name)));
 
@@ -1966,7 +2121,7 @@ BOOST_FIXTURE_TEST_CASE(multiple_producer_pay, eosio_system_tester, * boost::uni
       const asset    bpay_balance      = get_balance(N(eosio.bpay));
       const asset    vpay_balance      = get_balance(N(eosio.vpay));
       const asset    balance           = get_balance(prod_name);
-      const uint32_t unpaid_blocks     = get_producer_info(prod_name)["unpaid_blocks"].as<uint32_t>();
+      const uint32_t unpaid_blocks     = get_producer_unpaid_blocks(prod_name);
 
       const uint64_t usecs_between_fills = claim_time - initial_claim_time;
 
@@ -2026,7 +2181,7 @@ BOOST_FIXTURE_TEST_CASE(multiple_producer_pay, eosio_system_tester, * boost::uni
       {
          bool rest_didnt_produce = true;
          for (uint32_t i = 21; i < producer_names.size(); ++i) {
-            if (0 < get_producer_info(producer_names[i])["unpaid_blocks"].as<uint32_t>()) {
+            if (0 < get_producer_unpaid_blocks(producer_names[i])) {
                rest_didnt_produce = false;
             }
          }
@@ -2035,17 +2190,17 @@ BOOST_FIXTURE_TEST_CASE(multiple_producer_pay, eosio_system_tester, * boost::uni
 
       produce_blocks(3 * 21 * 12);
       info = get_producer_info(prod_name);
-      const uint32_t init_unpaid_blocks = info["unpaid_blocks"].as<uint32_t>();
+      const uint32_t init_unpaid_blocks = get_producer_unpaid_blocks(prod_name);
       BOOST_REQUIRE( !info["is_active"].as<bool>() );
       BOOST_REQUIRE( fc::crypto::public_key() == fc::crypto::public_key(info["producer_key"].as_string()) );
       BOOST_REQUIRE_EQUAL( wasm_assert_msg("producer does not have an active key"),
                            push_action(prod_name, N(claimrewards), mvo()("owner", prod_name) ) );
       produce_blocks(3 * 21 * 12);
-      BOOST_REQUIRE_EQUAL( init_unpaid_blocks, get_producer_info(prod_name)["unpaid_blocks"].as<uint32_t>() );
+      BOOST_REQUIRE_EQUAL( init_unpaid_blocks, get_producer_unpaid_blocks(prod_name) );
       {
          bool prod_was_replaced = false;
          for (uint32_t i = 21; i < producer_names.size(); ++i) {
-            if (0 < get_producer_info(producer_names[i])["unpaid_blocks"].as<uint32_t>()) {
+            if (0 < get_producer_unpaid_blocks(producer_names[i])) {
                prod_was_replaced = true;
             }
          }
@@ -2084,7 +2239,7 @@ BOOST_FIXTURE_TEST_CASE(multiple_producer_pay, eosio_system_tester, * boost::uni
       const uint32_t initial_tot_unpaid_blocks = initial_global_state["total_unpaid_blocks"].as<uint32_t>();
       const asset    initial_supply            = get_token_supply();
       const asset    initial_balance           = get_balance(prod_name);
-      const uint32_t initial_unpaid_blocks     = initial_prod_info["unpaid_blocks"].as<uint32_t>();
+      const uint32_t initial_unpaid_blocks     = get_producer_unpaid_blocks(prod_name);
       const uint64_t initial_claim_time        = microseconds_since_epoch_of_iso_string( initial_prod_info["last_claim_time"] );
       const uint64_t initial_prod_update_time  = microseconds_since_epoch_of_iso_string( initial_prod_info2["last_votepay_share_update"] );
 
@@ -2101,7 +2256,7 @@ BOOST_FIXTURE_TEST_CASE(multiple_producer_pay, eosio_system_tester, * boost::uni
       const uint32_t tot_unpaid_blocks = global_state["total_unpaid_blocks"].as<uint32_t>();
       const asset    supply            = get_token_supply();
       const asset    balance           = get_balance(prod_name);
-      const uint32_t unpaid_blocks     = prod_info["unpaid_blocks"].as<uint32_t>();
+      const uint32_t unpaid_blocks     = get_producer_unpaid_blocks(prod_name);
       const uint64_t claim_time        = microseconds_since_epoch_of_iso_string( prod_info["last_claim_time"] );
       const uint64_t prod_update_time  = microseconds_since_epoch_of_iso_string( prod_info2["last_votepay_share_update"] );
 
@@ -2212,7 +2367,7 @@ BOOST_FIXTURE_TEST_CASE(multiple_producer_votepay_share, eosio_system_tester, *
       auto prodv = get_producer_info( N(defproducerv) );
       auto prodz = get_producer_info( N(defproducerz) );
 
-      BOOST_REQUIRE (0 == proda["unpaid_blocks"].as<uint32_t>() && 0 == prodz["unpaid_blocks"].as<uint32_t>());
+      BOOST_REQUIRE (0 == get_producer_unpaid_blocks( N(defproducera) ) && 0 == get_producer_unpaid_blocks( N(defproducerz) ));
 
       // check vote ratios
       BOOST_REQUIRE ( 0 < proda["total_votes"].as_double() && 0 < prodz["total_votes"].as_double() );
@@ -2867,13 +3022,13 @@ BOOST_FIXTURE_TEST_CASE(producer_onblock_check, eosio_system_tester) try {
       produce_blocks(21 * 12);
       bool all_21_produced = true;
       for (uint32_t i = 0; i < 21; ++i) {
-         if (0 == get_producer_info(producer_names[i])["unpaid_blocks"].as<uint32_t>()) {
+         if (0 == get_producer_unpaid_blocks(producer_names[i])) {
             all_21_produced= false;
          }
       }
       bool rest_didnt_produce = true;
       for (uint32_t i = 21; i < producer_names.size(); ++i) {
-         if (0 < get_producer_info(producer_names[i])["unpaid_blocks"].as<uint32_t>()) {
+         if (0 < get_producer_unpaid_blocks(producer_names[i])) {
             rest_didnt_produce = false;
          }
       }
@@ -2906,13 +3061,13 @@ BOOST_FIXTURE_TEST_CASE(producer_onblock_check, eosio_system_tester) try {
       produce_blocks(21 * 12);
       bool all_21_produced = true;
       for (uint32_t i = 0; i < 21; ++i) {
-         if (0 == get_producer_info(producer_names[i])["unpaid_blocks"].as<uint32_t>()) {
+         if (0 == get_producer_unpaid_blocks(producer_names[i])) {
             all_21_produced= false;
          }
       }
       bool rest_didnt_produce = true;
       for (uint32_t i = 21; i < producer_names.size(); ++i) {
-         if (0 < get_producer_info(producer_names[i])["unpaid_blocks"].as<uint32_t>()) {
+         if (0 < get_producer_unpaid_blocks(producer_names[i])) {
             rest_didnt_produce = false;
          }
       }
@@ -3217,6 +3372,90 @@ BOOST_FIXTURE_TEST_CASE( elect_producers /*_and_parameters*/, eosio_system_teste
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE( skip_unchanged_producer_schedule, eosio_system_tester ) try {
+   create_accounts_with_resources( {  N(defproducer1), N(defproducer2) } );
+   BOOST_REQUIRE_EQUAL( success(), regproducer( N(defproducer1), 1) );
+   BOOST_REQUIRE_EQUAL( success(), regproducer( N(defproducer2), 2) );
+
+   transfer( "eosio", "alice1111111", core_sym::from_string("600000000.0000"), "eosio" );
+   BOOST_REQUIRE_EQUAL( success(), stake( "alice1111111", "alice1111111", core_sym::from_string("300000000.0000"), core_sym::from_string("300000000.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(), vote( N(alice1111111), { N(defproducer1) } ) );
+   produce_blocks(250);
+   BOOST_REQUIRE_EQUAL( 1, control->head_block_state()->active_schedule.producers.size() );
+   const auto first_hash = get_global_state2()["last_proposed_schedule_hash"].as_string();
+   BOOST_REQUIRE( !first_hash.empty() );
+   const auto first_version = control->head_block_state()->active_schedule.version;
+
+   // several election rounds with the same votes propose nothing new
+   produce_blocks(500);
+   BOOST_REQUIRE_EQUAL( first_hash, get_global_state2()["last_proposed_schedule_hash"].as_string() );
+   BOOST_REQUIRE_EQUAL( first_version, control->head_block_state()->active_schedule.version );
+
+   // a new producer in the top 21 is proposed
+   BOOST_REQUIRE_EQUAL( success(), vote( N(alice1111111), { N(defproducer1), N(defproducer2) } ) );
+   produce_blocks(250);
+   BOOST_REQUIRE( first_hash != get_global_state2()["last_proposed_schedule_hash"].as_string() );
+   BOOST_REQUIRE_EQUAL( 2, control->head_block_state()->active_schedule.producers.size() );
+   BOOST_REQUIRE_EQUAL( first_version + 1, control->head_block_state()->active_schedule.version );
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE( repropose_rejected_producer_schedule, eosio_system_tester ) try {
+   std::vector<account_name> producer_names;
+   for( char c = 'a'; c <= 'v'; ++c ) {
+      producer_names.emplace_back( std::string("defproducer") + c );
+   }
+   create_accounts_with_resources( producer_names );
+   for( const auto& p : producer_names ) {
+      BOOST_REQUIRE_EQUAL( success(), regproducer( p ) );
+   }
+
+   transfer( "eosio", "alice1111111", core_sym::from_string("600000000.0000"), "eosio" );
+   BOOST_REQUIRE_EQUAL( success(), stake( "alice1111111", "alice1111111", core_sym::from_string("300000000.0000"), core_sym::from_string("300000000.0000") ) );
+
+   auto active_names = [&]() {
+      std::vector<account_name> names;
+      for( const auto& p : control->head_block_state()->active_schedule.producers ) {
+         names.push_back( p.producer_name );
+      }
+      return names;
+   };
+   auto produce_until_round = [&]() {
+      const auto last_update = get_global_state()["last_producer_schedule_update"].as_string();
+      while( last_update == get_global_state()["last_producer_schedule_update"].as_string() ) {
+         produce_block();
+      }
+   };
+   auto produce_until_active = [&]( const std::vector<account_name>& expected ) {
+      for( int i = 0; i < 3000 && active_names() != expected; ++i ) {
+         produce_block();
+      }
+      return active_names() == expected;
+   };
+
+   // first 21 producers become active
+   const std::vector<account_name> first( producer_names.begin(), producer_names.begin() + 21 );
+   BOOST_REQUIRE_EQUAL( success(), vote( N(alice1111111), first ) );
+   BOOST_REQUIRE( produce_until_active( first ) );
+
+   // defproducerv replaces defproduceru and is proposed
+   std::vector<account_name> second( producer_names.begin(), producer_names.begin() + 20 );
+   second.push_back( N(defproducerv) );
+   BOOST_REQUIRE_EQUAL( success(), vote( N(alice1111111), second ) );
+   produce_until_round();
+   const auto second_hash = get_global_state2()["last_proposed_schedule_hash"].as_string();
+
+   // with 21 producers the second proposal is not irreversible by the next round, so the third set is rejected
+   std::vector<account_name> third( producer_names.begin(), producer_names.begin() + 19 );
+   third.push_back( N(defproduceru) );
+   third.push_back( N(defproducerv) );
+   BOOST_REQUIRE_EQUAL( success(), vote( N(alice1111111), third ) );
+   produce_until_round();
+   BOOST_REQUIRE_EQUAL( second_hash, get_global_state2()["last_proposed_schedule_hash"].as_string() );
+
+   // a later round proposes the rejected set again and it becomes active
+   BOOST_REQUIRE( produce_until_active( third ) );
+   BOOST_REQUIRE( second_hash != get_global_state2()["last_proposed_schedule_hash"].as_string() );
+} FC_LOG_AND_RETHROW()
 
 BOOST_FIXTURE_TEST_CASE( buyname, eosio_system_tester ) try {
    create_accounts_with_resources( { N(dan), N(sam) } );
@@ -3345,7 +3584,7 @@ BOOST_FIXTURE_TEST_CASE( multiple_namebids, eosio_system_tester ) try {
 
    // stake enough to go above the 15% threshold
    stake_with_transfer( config::system_account_name, N(alice), core_sym::from_string( "10000000.0000" ), core_sym::from_string( "10000000.0000" ) );
-   BOOST_REQUIRE_EQUAL(0, get_producer_info("producer")["unpaid_blocks"].as<uint32_t>());
+   BOOST_REQUIRE_EQUAL(0, get_producer_unpaid_blocks("producer"));
    BOOST_REQUIRE_EQUAL( success(), vote( N(alice), { N(producer) } ) );
 
    // need to wait for 14 days after going live
@@ -3468,13 +3707,13 @@ BOOST_FIXTURE_TEST_CASE( vote_producers_in_and_out, eosio_system_tester ) try {
       produce_blocks(23 * 12 + 20);
       bool all_21_produced = true;
       for (uint32_t i = 0; i < 21; ++i) {
-         if (0 == get_producer_info(producer_names[i])["unpaid_blocks"].as<uint32_t>()) {
+         if (0 == get_producer_unpaid_blocks(producer_names[i])) {
             all_21_produced = false;
          }
       }
       bool rest_didnt_produce = true;
       for (uint32_t i = 21; i < producer_names.size(); ++i) {
-         if (0 < get_producer_info(producer_names[i])["unpaid_blocks"].as<uint32_t>()) {
+         if (0 < get_producer_unpaid_blocks(producer_names[i])) {
             rest_didnt_produce = false;
          }
       }
@@ -3487,12 +3726,12 @@ BOOST_FIXTURE_TEST_CASE( vote_producers_in_and_out, eosio_system_tester ) try {
       const uint32_t new_prod_index  = 23;
       BOOST_REQUIRE_EQUAL(success(), stake("producvoterd", core_sym::from_string("40000000.0000"), core_sym::from_string("40000000.0000")));
       BOOST_REQUIRE_EQUAL(success(), vote(N(producvoterd), { producer_names[new_prod_index] }));
-      BOOST_REQUIRE_EQUAL(0, get_producer_info(producer_names[new_prod_index])["unpaid_blocks"].as<uint32_t>());
+      BOOST_REQUIRE_EQUAL(0, get_producer_unpaid_blocks(producer_names[new_prod_index]));
       produce_blocks(4 * 12 * 21);
-      BOOST_REQUIRE(0 < get_producer_info(producer_names[new_prod_index])["unpaid_blocks"].as<uint32_t>());
-      const uint32_t initial_unpaid_blocks = get_producer_info(producer_names[voted_out_index])["unpaid_blocks"].as<uint32_t>();
+      BOOST_REQUIRE(0 < get_producer_unpaid_blocks(producer_names[new_prod_index]));
+      const uint32_t initial_unpaid_blocks = get_producer_unpaid_blocks(producer_names[voted_out_index]);
       produce_blocks(2 * 12 * 21);
-      BOOST_REQUIRE_EQUAL(initial_unpaid_blocks, get_producer_info(producer_names[voted_out_index])["unpaid_blocks"].as<uint32_t>());
+      BOOST_REQUIRE_EQUAL(initial_unpaid_blocks, get_producer_unpaid_blocks(producer_names[voted_out_index]));
       produce_block(fc::hours(24));
       BOOST_REQUIRE_EQUAL(success(), vote(N(producvoterd), { producer_names[voted_out_index] }));
       produce_blocks(2 * 12 * 21);
@@ -4514,8 +4753,15 @@ BOOST_FIXTURE_TEST_CASE( ramfee_namebid_to_rex, eosio_system_tester ) try {
    asset cur_rex_balance = get_balance( N(eosio.rex) );
    BOOST_REQUIRE_EQUAL( core_sym::from_string("350.0000"), cur_rex_balance );
    BOOST_REQUIRE_EQUAL( success(),                         buyram( bob, carol, core_sym::from_string("70.0000") ) );
+   BOOST_REQUIRE_EQUAL( success(),                         buyram( bob, emily, core_sym::from_string("70.0000") ) );
+   // the fees wait in eosio.ramfee and are channeled to REX by the next runrex
+   BOOST_REQUIRE_EQUAL( cur_ramfee_balance + core_sym::from_string("0.7000"), get_balance( N(eosio.ramfee) ) );
+   BOOST_REQUIRE_EQUAL( cur_rex_balance,                   get_balance( N(eosio.rex) ) );
+   BOOST_REQUIRE_EQUAL( 7000,                              get_global_state()["ram_fee_proceeds"].as_int64() );
+   BOOST_REQUIRE_EQUAL( success(),                         rexexec( alice, 1 ) );
    BOOST_REQUIRE_EQUAL( cur_ramfee_balance,                get_balance( N(eosio.ramfee) ) );
-   BOOST_REQUIRE_EQUAL( get_balance( N(eosio.rex) ),       cur_rex_balance + core_sym::from_string("0.3500") );
+   BOOST_REQUIRE_EQUAL( get_balance( N(eosio.rex) ),       cur_rex_balance + core_sym::from_string("0.7000") );
+   BOOST_REQUIRE_EQUAL( 0,                                 get_global_state()["ram_fee_proceeds"].as_int64() );
 
    cur_rex_balance = get_balance( N(eosio.rex) );
 